@@ -0,0 +1,190 @@
+#include "Benchmark.h"
+#include "TransformStore.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+	// relaxed, only the totals matter and they are read on the benchmark thread
+	std::atomic<std::uint64_t> allocCount{ 0 };
+	std::atomic<std::uint64_t> allocBytes{ 0 };
+
+	void* CountedAlloc(std::size_t size)
+	{
+		allocCount.fetch_add(1, std::memory_order_relaxed);
+		allocBytes.fetch_add(size, std::memory_order_relaxed);
+		return std::malloc(size == 0 ? 1 : size);
+	}
+
+	void* CountedAlignedAlloc(std::size_t size, std::size_t align)
+	{
+		allocCount.fetch_add(1, std::memory_order_relaxed);
+		allocBytes.fetch_add(size, std::memory_order_relaxed);
+#if defined(_MSC_VER)
+		return _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+		// aligned_alloc wants a multiple of the alignment
+		return std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+	}
+
+	void AlignedFree(void* p)
+	{
+#if defined(_MSC_VER)
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+
+	void WriteString(std::ostream& out, const std::string& s)
+	{
+		out << '"';
+		for (char c : s) {
+			if (c == '"' || c == '\\') out << '\\';
+			out << c;
+		}
+		out << '"';
+	}
+}
+
+// Every allocation in the process goes through these, aligned new included
+void* operator new(std::size_t size)
+{
+	if (void* p = CountedAlloc(size)) return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	if (void* p = CountedAlloc(size)) return p;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+	if (void* p = CountedAlignedAlloc(size, static_cast<std::size_t>(align))) return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+	if (void* p = CountedAlignedAlloc(size, static_cast<std::size_t>(align))) return p;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { AlignedFree(p); }
+
+AllocationCounter AllocationCounter::Now()
+{
+	return { allocCount.load(std::memory_order_relaxed), allocBytes.load(std::memory_order_relaxed) };
+}
+
+void BenchState::Start()
+{
+	running = false;
+	Resume();
+}
+
+void BenchState::Stop()
+{
+	Pause();
+}
+
+void BenchState::Pause()
+{
+	if (!running) return;
+
+	// clock first, so reading the counters isn't timed
+	elapsed += Clock::now() - started;
+	AllocationCounter now = AllocationCounter::Now();
+	allocs += now.count - allocsAtStart.count;
+	bytes += now.bytes - allocsAtStart.bytes;
+	running = false;
+}
+
+void BenchState::Resume()
+{
+	if (running) return;
+
+	running = true;
+	allocsAtStart = AllocationCounter::Now();
+	started = Clock::now();
+}
+
+BenchRunner::BenchRunner(double minSeconds, const std::string& filter) : minSeconds(minSeconds), filter(filter)
+{
+}
+
+bool BenchRunner::Selected(const std::string& name) const
+{
+	return filter.empty() || name.find(filter) != std::string::npos;
+}
+
+void BenchRunner::Record(const std::string& name, std::size_t size, std::size_t opsPerCall, std::uint64_t iterations, const BenchState& state)
+{
+	const double ops = static_cast<double>(iterations) * static_cast<double>(opsPerCall == 0 ? 1 : opsPerCall);
+	const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(state.elapsed).count());
+
+	BenchResult result;
+	result.name = name;
+	result.size = size;
+	result.iterations = iterations;
+	result.nsPerOp = ns / ops;
+	result.itemsPerSecond = ns > 0 ? ops * 1e9 / ns : 0;
+	result.allocsPerOp = static_cast<double>(state.allocs) / ops;
+	result.bytesPerOp = static_cast<double>(state.bytes) / ops;
+	results.push_back(result);
+}
+
+void BenchRunner::WriteJson(std::ostream& out) const
+{
+#if defined(__clang__)
+	const std::string compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+	const std::string compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+	const std::string compiler = "msvc " + std::to_string(_MSC_VER);
+#else
+	const std::string compiler = "unknown";
+#endif
+
+#ifdef NDEBUG
+	const char* build = "release";
+#else
+	const char* build = "debug";
+#endif
+
+	out << "{\n  \"context\": {\n    \"compiler\": ";
+	WriteString(out, compiler);
+	out << ",\n    \"build\": \"" << build << "\",\n    \"kernels\": ";
+	WriteString(out, TransformKernels::Get().name);
+	out << ",\n    \"min_seconds\": " << minSeconds << "\n  },\n  \"benchmarks\": [";
+
+	for (std::size_t i = 0; i < results.size(); i++) {
+		const BenchResult& r = results[i];
+		out << (i == 0 ? "\n" : ",\n") << "    { \"name\": ";
+		WriteString(out, r.name);
+		out << ", \"size\": " << r.size
+			<< ", \"iterations\": " << r.iterations
+			<< ", \"ns_per_op\": " << r.nsPerOp
+			<< ", \"items_per_second\": " << r.itemsPerSecond
+			<< ", \"allocs_per_op\": " << r.allocsPerOp
+			<< ", \"bytes_per_op\": " << r.bytesPerOp << " }";
+	}
+
+	out << "\n  ]\n}\n";
+}
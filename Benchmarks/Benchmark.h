@@ -0,0 +1,98 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Allocations made through global operator new since the process started, counted by Benchmark.cpp
+struct AllocationCounter {
+	std::uint64_t count;
+	std::uint64_t bytes;
+
+	static AllocationCounter Now();
+};
+
+// Handed to every benchmark body, work between Pause and Resume is not timed or counted
+class BenchState {
+public:
+	void Pause();
+	void Resume();
+
+private:
+	friend class BenchRunner;
+
+	using Clock = std::chrono::steady_clock;
+
+	void Start();
+	void Stop();
+
+	Clock::time_point started;
+	Clock::duration elapsed;
+	AllocationCounter allocsAtStart;
+	std::uint64_t allocs;
+	std::uint64_t bytes;
+	bool running;
+};
+
+struct BenchResult {
+	std::string name;
+	// entities or elements the benchmark was run at
+	std::size_t size;
+	// times the body was called
+	std::uint64_t iterations;
+	double nsPerOp;
+	double itemsPerSecond;
+	double allocsPerOp;
+	double bytesPerOp;
+};
+
+// Calls each benchmark body until it has been timed for at least minSeconds and collects the
+// results. A body processes opsPerCall items per call, every figure is per item.
+class BenchRunner {
+public:
+	BenchRunner(double minSeconds, const std::string& filter);
+
+	template<typename F>
+	inline void Run(const std::string& name, std::size_t size, std::size_t opsPerCall, F&& body);
+
+	const std::vector<BenchResult>& GetResults() const { return results; }
+
+	// One object with the build context and a "benchmarks" array, stable field names so
+	// results can be compared across versions
+	void WriteJson(std::ostream& out) const;
+
+private:
+	bool Selected(const std::string& name) const;
+	void Record(const std::string& name, std::size_t size, std::size_t opsPerCall, std::uint64_t iterations, const BenchState& state);
+
+	double minSeconds;
+	std::string filter;
+	std::vector<BenchResult> results;
+};
+
+template<typename F>
+inline void BenchRunner::Run(const std::string& name, std::size_t size, std::size_t opsPerCall, F&& body)
+{
+	if (!Selected(name)) return;
+
+	BenchState state;
+	state.elapsed = BenchState::Clock::duration::zero();
+	state.allocs = 0;
+	state.bytes = 0;
+
+	const auto minTime = std::chrono::duration_cast<BenchState::Clock::duration>(std::chrono::duration<double>(minSeconds));
+	std::uint64_t iterations = 0;
+	do {
+		state.Start();
+		body(state);
+		state.Stop();
+		iterations++;
+	} while (state.elapsed < minTime);
+
+	Record(name, size, opsPerCall, iterations, state);
+}
+
+#endif
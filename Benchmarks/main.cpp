@@ -0,0 +1,412 @@
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "Benchmark.h"
+#include "EntityManager.h"
+#include "Logger.h"
+#include "TransformStore.h"
+
+// ECS_Bench [--quick] [--filter text] [--min-time seconds] [--out file.json]
+// Runs every benchmark whose name contains the filter and writes the results as JSON to the file,
+// or stdout. Progress goes to stderr. --quick runs each one briefly and skips the 1M entity sizes.
+
+// Quiet stand ins for ComponentOne and ComponentTwo, which print on every update
+class BenchTable : public Component {
+public:
+	BenchTable() : value(0) {};
+	BenchTable(float value) : value(value) {};
+
+	void Update() { value += 1.0f; }
+
+	float value;
+};
+
+class BenchSparse : public Component {
+public:
+	BenchSparse() : value(0) {};
+	BenchSparse(float value) : value(value) {};
+
+	static constexpr StoragePolicy storagePolicy = StoragePolicy::SparseSet;
+
+	void Update() { value += 1.0f; }
+
+	float value;
+};
+
+ECS_REGISTER_COMPONENT(BenchTable, 16)
+ECS_REGISTER_COMPONENT(BenchSparse, 17)
+
+namespace {
+	// keeps results the compiler could otherwise prove unused
+	volatile float floatSink;
+	volatile double doubleSink;
+	volatile bool boolSink;
+
+	std::vector<Entity*> Populate(EntityManager& manager, std::size_t n, bool withTable)
+	{
+		std::vector<Entity*> created;
+		created.reserve(n);
+		for (std::size_t i = 0; i < n; i++) {
+			Entity* e = new Entity(manager, Vec3(static_cast<double>(i), 0, 0), Quat::identity, Vec3::one);
+			if (withTable) e->add<BenchTable>(static_cast<float>(i));
+			manager.AddEntity(e);
+			created.push_back(e);
+		}
+		manager.AddNewEntities();
+		return created;
+	}
+
+	void Clear(EntityManager& manager)
+	{
+		for (auto& e : *manager.GetEntities()) e->kill();
+		manager.Refresh();
+	}
+
+	void EntityBenchmarks(BenchRunner& runner, EntityManager& manager, std::size_t n)
+	{
+		runner.Run("entity/create", n, n, [&](BenchState& state) {
+			Populate(manager, n, false);
+			state.Pause();
+			Clear(manager);
+			state.Resume();
+		});
+
+		runner.Run("entity/create_with_component", n, n, [&](BenchState& state) {
+			Populate(manager, n, true);
+			state.Pause();
+			Clear(manager);
+			state.Resume();
+		});
+
+		Prefab prefab;
+		prefab.add<BenchTable>(1.0f);
+		prefab.add<BenchSparse>(2.0f);
+		runner.Run("entity/instantiate", n, n, [&](BenchState& state) {
+			manager.Instantiate(prefab, n);
+			manager.AddNewEntities();
+			state.Pause();
+			Clear(manager);
+			state.Resume();
+		});
+
+		runner.Run("entity/destroy", n, n, [&](BenchState& state) {
+			state.Pause();
+			Populate(manager, n, true);
+			state.Resume();
+			Clear(manager);
+		});
+	}
+
+	void ComponentBenchmarks(BenchRunner& runner, EntityManager& manager, std::size_t n)
+	{
+		std::vector<Entity*> entities = Populate(manager, n, false);
+
+		runner.Run("component/add_table", n, n, [&](BenchState& state) {
+			for (auto e : entities) e->add<BenchTable>(1.0f);
+			state.Pause();
+			for (auto e : entities) e->remove<BenchTable>();
+			state.Resume();
+		});
+
+		runner.Run("component/remove_table", n, n, [&](BenchState& state) {
+			state.Pause();
+			for (auto e : entities) e->add<BenchTable>(1.0f);
+			state.Resume();
+			for (auto e : entities) e->remove<BenchTable>();
+		});
+
+		runner.Run("component/add_sparse", n, n, [&](BenchState& state) {
+			for (auto e : entities) e->add<BenchSparse>(1.0f);
+			state.Pause();
+			for (auto e : entities) e->remove<BenchSparse>();
+			state.Resume();
+		});
+
+		runner.Run("component/remove_sparse", n, n, [&](BenchState& state) {
+			state.Pause();
+			for (auto e : entities) e->add<BenchSparse>(1.0f);
+			state.Resume();
+			for (auto e : entities) e->remove<BenchSparse>();
+		});
+
+		for (auto e : entities) {
+			e->add<BenchTable>(1.0f);
+			e->add<BenchSparse>(2.0f);
+		}
+
+		runner.Run("component/get_table", n, n, [&](BenchState&) {
+			float sum = 0;
+			for (auto e : entities) sum += e->get<BenchTable>().value;
+			floatSink = sum;
+		});
+
+		runner.Run("component/get_sparse", n, n, [&](BenchState&) {
+			float sum = 0;
+			for (auto e : entities) sum += e->get<BenchSparse>().value;
+			floatSink = sum;
+		});
+
+		runner.Run("component/has", n, n, [&](BenchState&) {
+			bool all = true;
+			for (auto e : entities) all &= e->has<BenchTable>();
+			boolSink = all;
+		});
+
+		runner.Run("component/has_many", n, n, [&](BenchState&) {
+			bool all = true;
+			for (auto e : entities) all &= e->has<Transform, BenchTable, BenchSparse>();
+			boolSink = all;
+		});
+
+		runner.Run("view/each", n, n, [&](BenchState&) {
+			float sum = 0;
+			manager.view<const Transform, const BenchTable>().each([&](Entity&, const Transform&, const BenchTable& b) { sum += b.value; });
+			floatSink = sum;
+		});
+
+		Clear(manager);
+	}
+
+	void ManagerBenchmarks(BenchRunner& runner, EntityManager& manager, std::size_t n)
+	{
+		Populate(manager, n, true);
+
+		runner.Run("manager/update", n, n, [&](BenchState&) {
+			manager.Update();
+		});
+
+		// nothing is dead, this is the cost of the scan every update pays
+		runner.Run("manager/refresh", n, n, [&](BenchState&) {
+			manager.Refresh();
+		});
+
+		// standalone so the update numbers above and in later sizes don't include it
+		TransformBuffer buffer;
+		runner.Run("transform/publish", n, n, [&](BenchState&) {
+			buffer.Publish(manager);
+		});
+
+		const TransformFrame& frame = buffer.Acquire();
+		std::vector<Vec3> positions, scales;
+		std::vector<Quat> rotations;
+		runner.Run("transform/interpolate", n, n, [&](BenchState&) {
+			frame.Interpolate(0.5f, positions, rotations, scales);
+		});
+		doubleSink = positions.empty() ? 0.0 : positions.back().x + rotations.back().w;
+
+		Clear(manager);
+	}
+
+	void SpatialBenchmarks(BenchRunner& runner, EntityManager& manager, std::size_t n)
+	{
+		// spread so there are about four entities per 16 unit cell in the xz plane
+		const double extent = std::sqrt(static_cast<double>(n) / 4.0) * 16.0;
+		std::vector<Entity*> entities = Populate(manager, n, false);
+		for (std::size_t i = 0; i < n; i++) {
+			const double a = static_cast<double>((i * 7919) % n) / static_cast<double>(n);
+			const double b = static_cast<double>((i * 104729) % n) / static_cast<double>(n);
+			entities[i]->transform->position = Vec3(a * extent, 0, b * extent);
+		}
+
+		const std::size_t queries = 1024;
+		std::vector<Vec3> centers(queries);
+		std::vector<double> radii(queries, 24.0);
+		for (std::size_t i = 0; i < queries; i++) centers[i] = entities[(i * 31) % n]->transform->position;
+
+		const std::pair<SpatialIndexType, const char*> types[] = { { SpatialIndexType::HashGrid, "grid" }, { SpatialIndexType::LooseOctree, "octree" } };
+		for (auto& type : types) {
+			const std::string prefix = std::string("spatial/") + type.second + "/";
+			SpatialIndex& index = manager.CreateSpatialIndex(type.first);
+			index.Update(manager);
+
+			// one entity in a hundred moves a little, the rest are skipped by their chunk tick or position
+			runner.Run(prefix + "update_moved", n, n / 100, [&](BenchState& state) {
+				state.Pause();
+				manager.GetStorage()->NextTick();
+				for (std::size_t i = 0; i < n; i += 100) {
+					entities[i]->transform->position += Vec3(0.5, 0, 0.25);
+					entities[i]->markChanged<Transform>();
+				}
+				state.Resume();
+				index.Update(manager);
+			});
+
+			SpatialResults results;
+			runner.Run(prefix + "radius_query", n, queries, [&](BenchState&) {
+				index.QueryRadius(centers.data(), radii.data(), queries, results);
+			});
+
+			runner.Run(prefix + "nearest_8", n, queries, [&](BenchState&) {
+				index.QueryNearest(centers.data(), queries, 8, results);
+			});
+		}
+
+		Clear(manager);
+	}
+
+	void MathBenchmarks(BenchRunner& runner, std::size_t n)
+	{
+		std::vector<Vec3> va(n), vb(n), vout(n);
+		std::vector<Quat> qa(n), qb(n), qout(n);
+		std::vector<Quatf> fa(n), fb(n), fout(n);
+		std::vector<float> t(n);
+
+		for (std::size_t i = 0; i < n; i++) {
+			const double f = static_cast<double>(i) / static_cast<double>(n);
+			va[i] = Vec3(f, 1 - f, 2 * f + 1);
+			vb[i] = Vec3(1 - f, f, 3);
+			qa[i] = Quat::FromAngleAxis(f * 90, Vec3::up);
+			qb[i] = Quat::FromAngleAxis(f * 180, Vec3::right);
+			fa[i] = Quatf(qa[i]);
+			fb[i] = Quatf(qb[i]);
+			t[i] = static_cast<float>(f);
+		}
+
+		runner.Run("vec3/lerp", n, n, [&](BenchState&) {
+			for (std::size_t i = 0; i < n; i++) vout[i] = Vec3::Lerp(va[i], vb[i], t[i]);
+			doubleSink = vout[n / 2].x;
+		});
+
+		runner.Run("vec3/normalize", n, n, [&](BenchState&) {
+			for (std::size_t i = 0; i < n; i++) vout[i] = va[i].Normalize();
+			doubleSink = vout[n / 2].x;
+		});
+
+		runner.Run("vec3/distance", n, n, [&](BenchState&) {
+			double sum = 0;
+			for (std::size_t i = 0; i < n; i++) sum += va[i].Distance(vb[i]);
+			doubleSink = sum;
+		});
+
+		runner.Run("quat/multiply_batch", n, n, [&](BenchState&) {
+			Quat::MultiplyBatch(qa.data(), qb.data(), qout.data(), n);
+			doubleSink = qout[n / 2].w;
+		});
+
+		runner.Run("quat/normalize_batch", n, n, [&](BenchState&) {
+			Quat::NormalizeBatch(qa.data(), qout.data(), n);
+			doubleSink = qout[n / 2].w;
+		});
+
+		runner.Run("quat/slerp_batch", n, n, [&](BenchState&) {
+			Quat::SlerpBatch(qa.data(), qb.data(), t.data(), qout.data(), n);
+			doubleSink = qout[n / 2].w;
+		});
+
+		runner.Run("quat/rotate_batch", n, n, [&](BenchState&) {
+			Quat::RotateBatch(qa.data(), va.data(), vout.data(), n);
+			doubleSink = vout[n / 2].x;
+		});
+
+		runner.Run("quatf/multiply_batch", n, n, [&](BenchState&) {
+			Quatf::MultiplyBatch(fa.data(), fb.data(), fout.data(), n);
+			floatSink = fout[n / 2].w;
+		});
+
+		runner.Run("quatf/slerp_batch", n, n, [&](BenchState&) {
+			Quatf::SlerpBatch(fa.data(), fb.data(), t.data(), fout.data(), n);
+			floatSink = fout[n / 2].w;
+		});
+
+		// structure of arrays kernels, every version the CPU can run
+		// scaling by one keeps the values from running off into denormals over the iterations
+		std::vector<float> x(n), y(n), z(n), dx(n, 0.5f), dy(n, 0.25f), dz(n, 1.0f), ones(n, 1.0f);
+		std::vector<float> rx(n), ry(n), rz(n), rw(n);
+		for (std::size_t i = 0; i < n; i++) {
+			rx[i] = fa[i].x;
+			ry[i] = fa[i].y;
+			rz[i] = fa[i].z;
+			rw[i] = fa[i].w;
+		}
+
+		const TransformKernels* sets[] = { &TransformKernels::Scalar(), TransformKernels::Sse(), TransformKernels::Avx2() };
+		for (const TransformKernels* k : sets) {
+			if (k == nullptr) continue;
+			const std::string prefix = std::string("kernels/") + k->name + "/";
+
+			runner.Run(prefix + "translate", n, n, [&](BenchState&) {
+				k->translate(x.data(), y.data(), z.data(), dx.data(), dy.data(), dz.data(), n);
+				floatSink = x[n / 2];
+			});
+
+			runner.Run(prefix + "rotate", n, n, [&](BenchState&) {
+				k->rotate(rx.data(), ry.data(), rz.data(), rw.data(), x.data(), y.data(), z.data(), n);
+				floatSink = x[n / 2];
+			});
+
+			runner.Run(prefix + "scale", n, n, [&](BenchState&) {
+				k->scale(x.data(), y.data(), z.data(), ones.data(), ones.data(), ones.data(), n);
+				floatSink = x[n / 2];
+			});
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool quick = false;
+	double minSeconds = 0.5;
+	std::string filter;
+	std::string outPath;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--quick") == 0) quick = true;
+		else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+		else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) minSeconds = std::atof(argv[++i]);
+		else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+		else {
+			std::cerr << "usage: " << argv[0] << " [--quick] [--filter text] [--min-time seconds] [--out file.json]" << std::endl;
+			return 1;
+		}
+	}
+	if (quick) minSeconds = 0.02;
+
+	// Refresh logs every kill, the results go to stdout
+	Logger::Get().Discard();
+
+	EntityManager* manager = new EntityManager();
+	BenchRunner runner(minSeconds, filter);
+
+	const std::vector<std::size_t> sizes = quick ? std::vector<std::size_t>{ 1000, 100000 } : std::vector<std::size_t>{ 1000, 100000, 1000000 };
+
+	std::size_t reported = 0;
+	auto report = [&]() {
+		const auto& results = runner.GetResults();
+		for (; reported < results.size(); reported++) {
+			const BenchResult& r = results[reported];
+			std::cerr << r.name << " [" << r.size << "]: " << r.nsPerOp << " ns/op, " << r.allocsPerOp << " allocs/op" << std::endl;
+		}
+	};
+
+	for (std::size_t n : sizes) {
+		EntityBenchmarks(runner, *manager, n);
+		report();
+		ComponentBenchmarks(runner, *manager, n);
+		report();
+		ManagerBenchmarks(runner, *manager, n);
+		report();
+		SpatialBenchmarks(runner, *manager, n);
+		report();
+	}
+	MathBenchmarks(runner, 4096);
+	report();
+
+	manager->Purge();
+	delete manager;
+
+	if (outPath.empty()) runner.WriteJson(std::cout);
+	else {
+		std::ofstream out(outPath);
+		if (!out) {
+			std::cerr << "Could not write " << outPath << std::endl;
+			return 1;
+		}
+		runner.WriteJson(out);
+	}
+
+	return 0;
+}
@@ -0,0 +1,150 @@
+#include "Archetype.h"
+
+#include <algorithm>
+
+static std::size_t AlignUp(std::size_t value, std::size_t align)
+{
+	return (value + align - 1) & ~(align - 1);
+}
+
+// Bytes a chunk needs to hold capacity rows of the given types
+static std::size_t LayoutSize(const std::vector<const ComponentInfo*>& types, std::size_t capacity, std::vector<std::size_t>* offsets)
+{
+	std::size_t offset = AlignUp(sizeof(Tick) * 2 * types.size(), ECS_CACHE_LINE);
+	offset = AlignUp(offset + sizeof(Entity*) * capacity, ECS_CACHE_LINE);
+
+	if (offsets) offsets->clear();
+	for (auto t : types) {
+		offset = AlignUp(offset, std::max(ECS_CACHE_LINE, t->align));
+		if (offsets) offsets->push_back(offset);
+		offset += t->size * capacity;
+	}
+
+	return offset;
+}
+
+Archetype::Archetype(std::vector<const ComponentInfo*> types) : types(std::move(types)), entitiesOffset(0), chunkAllocator(nullptr), chunkBytes(ECS_CHUNK_SIZE), capacity(0), size(0)
+{
+	// columns are kept in TypeID order so every archetype with the same set has the same layout
+	std::sort(this->types.begin(), this->types.end(), [](const ComponentInfo* a, const ComponentInfo* b) { return a->id < b->id; });
+
+	entitiesOffset = AlignUp(sizeof(Tick) * 2 * this->types.size(), ECS_CACHE_LINE);
+
+	std::size_t rowBytes = sizeof(Entity*);
+	TypeID maxID = 0;
+	for (auto t : this->types) {
+		signature.set(t->id);
+		rowBytes += t->size;
+		maxID = std::max(maxID, t->id);
+	}
+
+	columnOf.assign(this->types.empty() ? 0 : maxID + 1, -1);
+	for (std::size_t i = 0; i < this->types.size(); i++)
+		columnOf[this->types[i]->id] = static_cast<int>(i);
+
+	// fit as many rows as possible once the columns are padded out to cache lines
+	capacity = std::max<std::size_t>(1, (chunkBytes - entitiesOffset) / rowBytes);
+	while (capacity > 1 && LayoutSize(this->types, capacity, nullptr) > chunkBytes) capacity--;
+
+	// a single row bigger than a chunk gets a chunk of its own size
+	chunkBytes = std::max(chunkBytes, AlignUp(LayoutSize(this->types, capacity, &offsets), ECS_CACHE_LINE));
+}
+
+Archetype::~Archetype()
+{
+	for (std::size_t row = 0; row < size; row++)
+		for (std::size_t c = 0; c < types.size(); c++)
+			types[c]->destroy(GetComponent(c, row));
+
+	for (auto& chunk : chunks)
+		chunkAllocator->Free(chunk.data);
+	chunks.clear();
+}
+
+std::size_t Archetype::AllocateRow(Entity* e)
+{
+	if (size == chunks.size() * capacity) {
+		Chunk chunk;
+		chunk.data = static_cast<unsigned char*>(chunkAllocator->Allocate());
+		chunk.count = 0;
+		std::fill(GetChangedTicks(chunk), GetChangedTicks(chunk) + 2 * types.size(), Tick(0));
+		chunks.push_back(chunk);
+	}
+
+	std::size_t row = size++;
+	Chunk& chunk = chunks[row / capacity];
+	GetEntities(chunk)[row % capacity] = e;
+	chunk.count++;
+
+	return row;
+}
+
+std::size_t Archetype::AllocateRows(Entity* const* entities, std::size_t count)
+{
+	const std::size_t first = size;
+	chunks.reserve((size + count + capacity - 1) / capacity);
+
+	for (std::size_t done = 0; done < count;) {
+		if (size == chunks.size() * capacity) {
+			Chunk chunk;
+			chunk.data = static_cast<unsigned char*>(chunkAllocator->Allocate());
+			chunk.count = 0;
+			std::fill(GetChangedTicks(chunk), GetChangedTicks(chunk) + 2 * types.size(), Tick(0));
+			chunks.push_back(chunk);
+		}
+
+		// fill the rest of the last chunk in one go
+		Chunk& chunk = chunks[size / capacity];
+		const std::size_t run = std::min(count - done, capacity - chunk.count);
+		std::copy(entities + done, entities + done + run, GetEntities(chunk) + chunk.count);
+		chunk.count += run;
+		size += run;
+		done += run;
+	}
+
+	return first;
+}
+
+Entity* Archetype::RemoveRow(std::size_t row)
+{
+	std::size_t last = size - 1;
+	Entity* moved = nullptr;
+
+	for (std::size_t c = 0; c < types.size(); c++)
+		types[c]->destroy(GetComponent(c, row));
+
+	// swap and pop, keeps every chunk but the last one full
+	if (row != last) {
+		for (std::size_t c = 0; c < types.size(); c++) {
+			void* src = GetComponent(c, last);
+			types[c]->moveConstruct(GetComponent(c, row), src);
+			types[c]->destroy(src);
+			MergeTicks(c, row, *this, c, last);
+		}
+
+		moved = GetEntity(last);
+		GetEntities(chunks[row / capacity])[row % capacity] = moved;
+	}
+
+	Chunk& tail = chunks.back();
+	tail.count--;
+	size--;
+
+	if (tail.count == 0) {
+		chunkAllocator->Free(tail.data);
+		chunks.pop_back();
+	}
+
+	return moved;
+}
+
+void Archetype::MergeTicks(std::size_t column, std::size_t row, const Archetype& from, std::size_t fromColumn, std::size_t fromRow)
+{
+	const Chunk& to = chunks[row / capacity];
+	const Chunk& source = from.chunks[fromRow / from.capacity];
+
+	Tick& changed = GetChangedTicks(to)[column];
+	Tick& added = GetAddedTicks(to)[column];
+	changed = std::max(changed, from.GetChangedTicks(source)[fromColumn]);
+	added = std::max(added, from.GetAddedTicks(source)[fromColumn]);
+}
@@ -0,0 +1,110 @@
+#ifndef ARCHETYPE_H
+#define ARCHETYPE_H
+
+#include <vector>
+#include <unordered_map>
+
+#include "ECS.h"
+#include "PoolAllocator.h"
+
+// A fixed size block of memory holding up to capacity entities of one archetype.
+// Laid out structure-of-arrays: [ticks][Entity* x capacity][column 0 x capacity][column 1 x capacity]...
+// with every array starting on a cache line. ticks holds a changed and an added Tick per column,
+// the last tick any row in the chunk had that component written / added.
+struct Chunk {
+	unsigned char* data;
+	std::size_t count;
+};
+
+// Every entity with exactly the same set of components lives in the same archetype
+class Archetype {
+public:
+	Archetype(std::vector<const ComponentInfo*> types);
+	~Archetype();
+
+	const std::vector<const ComponentInfo*>& GetTypes() const { return types; }
+	// Bit set for every type in the archetype
+	const Signature& GetSignature() const { return signature; }
+
+	// Chunks are drawn from this pool, its block size must be ChunkBytes
+	void SetChunkAllocator(PoolAllocator* allocator) { chunkAllocator = allocator; }
+	std::size_t ChunkBytes() const { return chunkBytes; }
+
+	// Returns the column holding components of this type, -1 if the archetype does not have it
+	inline int ColumnIndex(TypeID id) const {
+		return id < columnOf.size() ? columnOf[id] : -1;
+	}
+	inline bool Contains(TypeID id) const { return signature.test(id); }
+
+	std::size_t Size() const { return size; }
+	std::size_t ChunkCapacity() const { return capacity; }
+	std::size_t ChunkCount() const { return chunks.size(); }
+	Chunk& GetChunk(std::size_t i) { return chunks[i]; }
+
+	// Start of a column inside a chunk, elements are contiguous up to chunk.count
+	inline void* GetColumn(const Chunk& chunk, std::size_t column) const {
+		return chunk.data + offsets[column];
+	}
+	inline Entity** GetEntities(const Chunk& chunk) const {
+		return reinterpret_cast<Entity**>(chunk.data + entitiesOffset);
+	}
+	// One Tick per column
+	inline Tick* GetChangedTicks(const Chunk& chunk) const {
+		return reinterpret_cast<Tick*>(chunk.data);
+	}
+	inline Tick* GetAddedTicks(const Chunk& chunk) const {
+		return reinterpret_cast<Tick*>(chunk.data) + types.size();
+	}
+
+	inline void MarkChanged(std::size_t column, std::size_t row, Tick tick) {
+		GetChangedTicks(chunks[row / capacity])[column] = tick;
+	}
+	// Added also counts as changed
+	inline void MarkAdded(std::size_t column, std::size_t row, Tick tick) {
+		const Chunk& chunk = chunks[row / capacity];
+		GetChangedTicks(chunk)[column] = tick;
+		GetAddedTicks(chunk)[column] = tick;
+	}
+	// Raises the ticks of row's chunk to at least those of from's chunk, used when
+	// from's components are moved into row so their changes aren't lost
+	void MergeTicks(std::size_t column, std::size_t row, const Archetype& from, std::size_t fromColumn, std::size_t fromRow);
+
+	inline void* GetComponent(std::size_t column, std::size_t row) {
+		return static_cast<unsigned char*>(GetColumn(chunks[row / capacity], column)) + (row % capacity) * types[column]->size;
+	}
+	inline Entity* GetEntity(std::size_t row) {
+		return GetEntities(chunks[row / capacity])[row % capacity];
+	}
+
+	// Reserves a row at the end for the entity, its component memory is left uninitialised
+	std::size_t AllocateRow(Entity* e);
+	// Same for count entities at once, returns the first of their contiguous rows
+	std::size_t AllocateRows(Entity* const* entities, std::size_t count);
+
+	// Destroys the components in row and fills the hole with the last row.
+	// Returns the entity that was moved into row, nullptr if none was.
+	Entity* RemoveRow(std::size_t row);
+
+	// Cached archetype graph, archetype reached by adding / removing one type
+	std::unordered_map<TypeID, Archetype*> addEdges;
+	std::unordered_map<TypeID, Archetype*> removeEdges;
+
+private:
+	Archetype(const Archetype&) = delete;
+	void operator=(const Archetype&) = delete;
+
+	std::vector<const ComponentInfo*> types;
+	Signature signature;
+	std::vector<int> columnOf;
+	std::vector<std::size_t> offsets;
+	std::size_t entitiesOffset;
+
+	std::vector<Chunk> chunks;
+	PoolAllocator* chunkAllocator;
+	std::size_t chunkBytes;
+	std::size_t capacity;
+	std::size_t size;
+
+};
+
+#endif
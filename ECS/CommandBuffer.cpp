@@ -0,0 +1,41 @@
+#include "CommandBuffer.h"
+
+CommandBuffer::CommandBuffer(ComponentStorage* storage) : storage(storage), payloads(16 * 1024)
+{
+}
+
+CommandBuffer::~CommandBuffer()
+{
+	Clear();
+}
+
+EntityId CommandBuffer::Create()
+{
+	return Create(Vec3::zero, Quat::identity, Vec3::one);
+}
+
+EntityId CommandBuffer::Create(Vec3 pos, Quat rot, Vec3 scl)
+{
+	EntityId id = storage->Reserve();
+
+	void* payload = payloads.Allocate(sizeof(Transform), alignof(Transform));
+	new (payload) Transform(pos, rot, scl);
+
+	commands.push_back(Command{ CommandType::Create, id, payload, nullptr,
+		[](void* p) { static_cast<Transform*>(p)->~Transform(); } });
+	return id;
+}
+
+void CommandBuffer::Destroy(EntityId id)
+{
+	commands.push_back(Command{ CommandType::Destroy, id, nullptr, nullptr, [](void*) {} });
+}
+
+void CommandBuffer::Clear()
+{
+	for (auto& command : commands)
+		if (command.payload) command.discard(command.payload);
+
+	commands.clear();
+	payloads.Reset();
+}
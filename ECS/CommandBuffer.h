@@ -0,0 +1,86 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <vector>
+
+#include "ComponentStorage.h"
+#include "Entity.h"
+#include "EntityId.h"
+#include "PoolAllocator.h"
+
+// Records structural changes so systems running in parallel can request them safely.
+// Each thread records into its own buffer (EntityManager::GetCommandBuffer), all buffers are
+// applied together at the next sync point in EntityManager::FlushCommands.
+class CommandBuffer {
+public:
+	CommandBuffer(ComponentStorage* storage);
+	~CommandBuffer();
+
+	// The id is usable straight away for Add / Remove / Destroy in any buffer,
+	// the entity itself only exists once the buffers are flushed
+	EntityId Create();
+	EntityId Create(Vec3 pos, Quat rot, Vec3 scl);
+	void Destroy(EntityId id);
+
+	// Constructs the component now, it is moved onto the entity when flushed
+	template<typename T, typename... TArgs>
+	inline void Add(EntityId id, TArgs&&... args);
+
+	template<typename T>
+	inline void Remove(EntityId id);
+
+	bool Empty() const { return commands.empty(); }
+	std::size_t Size() const { return commands.size(); }
+
+private:
+	friend class EntityManager;
+
+	CommandBuffer(CommandBuffer& other) = delete;
+	void operator=(const CommandBuffer&) = delete;
+
+	// declaration order is also the order commands are applied in
+	enum class CommandType {
+		Create,
+		Change,
+		Destroy
+	};
+
+	struct Command {
+		CommandType type;
+		EntityId id;
+		void* payload;
+		// applies a Change to the entity, consumes the payload
+		void (*apply)(Entity& e, void* payload);
+		// destroys a payload that is never applied
+		void (*discard)(void* payload);
+	};
+
+	// Destroys anything left unapplied and releases the payload memory
+	void Clear();
+
+	ComponentStorage* storage;
+	std::vector<Command> commands;
+	FrameArena payloads;
+
+};
+
+template<typename T, typename... TArgs>
+inline void CommandBuffer::Add(EntityId id, TArgs&&... args)
+{
+	void* payload = payloads.Allocate(sizeof(T), alignof(T));
+	new (payload) T(std::forward<TArgs>(args)...);
+
+	commands.push_back(Command{ CommandType::Change, id, payload,
+		[](Entity& e, void* p) { e.add<T>(std::move(*static_cast<T*>(p))); static_cast<T*>(p)->~T(); },
+		[](void* p) { static_cast<T*>(p)->~T(); } });
+}
+
+template<typename T>
+inline void CommandBuffer::Remove(EntityId id)
+{
+	commands.push_back(Command{ CommandType::Change, id, nullptr,
+		[](Entity& e, void*) { e.remove<T>(); },
+		[](void*) {} });
+}
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef COMPONENT_H
 #define COMPONENT_H
 
+#include "ECS.h"
+
 class Entity;
 
 class Component {
@@ -10,6 +12,14 @@ public:
 	size_t id;
 	Entity* entity;
 
+	// hidden by components that want to be stored differently
+	static constexpr StoragePolicy storagePolicy = StoragePolicy::Table;
+	// hidden with true by components that can be restored from their bytes, see WorldSnapshot.
+	// Only opt in when every member is plain data, no pointers, containers, strings or handles
+	// to outside resources: snapshotted components are copy constructed straight from the file.
+	// Saving a world with a live component that didn't opt in throws.
+	static constexpr bool bitwiseSnapshot = false;
+
 	virtual bool init() { return true; }
 	virtual void Update() {};
 
@@ -4,17 +4,16 @@
 #include <iostream>
 
 #include "Component.h"
+#include "Entity.h"
+#include "Logger.h"
 
 class ComponentOne : public Component {
 public:
 	ComponentOne(float a, float b) : a(a), b(b) {};
 
-	void Update() {
-		
-		Print();
-		a++;
-		b += 2;
-	}
+	static constexpr bool bitwiseSnapshot = true;
+
+	void Update();
 	
 	void Print() {
 		std::cout << "ComponentOne: " << this << " values " << a << " and " << b << std::endl;
@@ -26,4 +25,15 @@ private:
 
 };
 
+ECS_REGISTER_COMPONENT(ComponentOne, 1)
+
+// after the registration, markChanged needs the id
+inline void ComponentOne::Update()
+{
+	ECS_LOG_DEBUG("ComponentOne: {} values {} and {}", this, a, b);
+	a++;
+	b += 2;
+	entity->markChanged<ComponentOne>();
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,364 @@
+#include "ComponentStorage.h"
+#include "Entity.h"
+#include "Prefab.h"
+#include "Transform.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+// 16 chunks per slab, a burst of spawns costs one allocation per 16 chunks
+static const std::size_t SLAB_BYTES = ECS_CHUNK_SIZE * 16;
+
+ComponentStorage::ComponentStorage() : frameArena(64 * 1024), entityPool(sizeof(Entity), alignof(Entity), 1024), infos(ECS_MAX_COMPONENTS, nullptr), pools(ECS_MAX_COMPONENTS), nextIndex(0), tick(1), transformsLost(0)
+{
+	GetArchetype({});
+	// every entity has one, so a snapshot can be loaded into a world that hasn't stored any yet
+	Register<Transform>();
+}
+
+ComponentStorage::~ComponentStorage()
+{
+	// transient pools hold arena memory, clear them before the arena goes
+	transientPools.clear();
+	pools.clear();
+	lookup.clear();
+	archetypes.clear();
+}
+
+Archetype* ComponentStorage::GetEmptyArchetype()
+{
+	return archetypes.front().get();
+}
+
+Archetype* ComponentStorage::GetArchetypeWith(Archetype* from, const ComponentInfo* added)
+{
+	auto edge = from->addEdges.find(added->id);
+	if (edge != from->addEdges.end()) return edge->second;
+
+	Register(added);
+
+	std::vector<const ComponentInfo*> types(from->GetTypes());
+	types.push_back(added);
+
+	Archetype* to = GetArchetype(types);
+	from->addEdges[added->id] = to;
+	to->removeEdges[added->id] = from;
+	return to;
+}
+
+Archetype* ComponentStorage::GetArchetypeWithout(Archetype* from, TypeID removed)
+{
+	auto edge = from->removeEdges.find(removed);
+	if (edge != from->removeEdges.end()) return edge->second;
+
+	std::vector<const ComponentInfo*> types;
+	for (auto t : from->GetTypes())
+		if (t->id != removed) types.push_back(t);
+
+	Archetype* to = GetArchetype(types);
+	from->removeEdges[removed] = to;
+	to->addEdges[removed] = from;
+	return to;
+}
+
+void ComponentStorage::Insert(Entity* e)
+{
+	Insert(e, Reserve());
+}
+
+void ComponentStorage::Insert(Entity* e, EntityId reserved)
+{
+	if (reserved.index >= slots.size()) slots.resize(reserved.index + 1, Slot{ nullptr, 0 });
+
+	slots[reserved.index].entity = e;
+	e->id = reserved;
+
+	e->archetype = GetEmptyArchetype();
+	e->row = e->archetype->AllocateRow(e);
+}
+
+EntityId ComponentStorage::Reserve()
+{
+	{
+		std::lock_guard<std::mutex> lock(freeSlotsMutex);
+		if (!freeSlots.empty()) {
+			std::uint32_t index = freeSlots.back();
+			freeSlots.pop_back();
+			return EntityId(index, slots[index].generation);
+		}
+	}
+
+	return EntityId(nextIndex.fetch_add(1, std::memory_order_relaxed), 0);
+}
+
+void ComponentStorage::Reserve(EntityId* ids, std::size_t count)
+{
+	std::size_t done = 0;
+	{
+		std::lock_guard<std::mutex> lock(freeSlotsMutex);
+		for (; done < count && !freeSlots.empty(); done++) {
+			const std::uint32_t index = freeSlots.back();
+			freeSlots.pop_back();
+			ids[done] = EntityId(index, slots[index].generation);
+		}
+	}
+
+	const std::uint32_t first = nextIndex.fetch_add(static_cast<std::uint32_t>(count - done), std::memory_order_relaxed);
+	for (std::uint32_t index = first; done < count; done++) ids[done] = EntityId(index++, 0);
+}
+
+void ComponentStorage::Instantiate(const Prefab& prefab, std::size_t count, std::vector<Entity*>& out)
+{
+	if (count == 0) return;
+
+	const auto& entries = prefab.GetEntries();
+
+	std::vector<const ComponentInfo*> tableTypes;
+	for (auto& entry : entries) {
+		Register(entry.info);
+		if (entry.fillRows) tableTypes.push_back(entry.info);
+	}
+	Archetype* archetype = GetArchetype(tableTypes);
+
+	std::vector<EntityId> ids(count);
+	Reserve(ids.data(), count);
+
+	const std::size_t first = out.size();
+	out.reserve(first + count);
+	std::uint32_t maxIndex = 0;
+	for (std::size_t i = 0; i < count; i++) {
+		Entity* e = new (entityPool.Allocate()) Entity(this);
+		e->pool = &entityPool;
+		out.push_back(e);
+		maxIndex = std::max(maxIndex, ids[i].index);
+	}
+	Entity* const* entities = out.data() + first;
+
+	if (maxIndex >= slots.size()) slots.resize(maxIndex + 1, Slot{ nullptr, 0 });
+
+	const std::size_t firstRow = archetype->AllocateRows(entities, count);
+	const Signature signature = prefab.GetSignature();
+	for (std::size_t i = 0; i < count; i++) {
+		Entity* e = entities[i];
+		slots[ids[i].index].entity = e;
+		e->id = ids[i];
+		e->archetype = archetype;
+		e->row = firstRow + i;
+		e->signature = signature;
+	}
+
+	// the new rows are contiguous, copy the prototypes in a chunk at a time
+	const auto& types = archetype->GetTypes();
+	for (std::size_t done = 0; done < count;) {
+		const std::size_t row = firstRow + done;
+		const std::size_t run = std::min(count - done, archetype->ChunkCapacity() - row % archetype->ChunkCapacity());
+
+		for (std::size_t c = 0; c < types.size(); c++) {
+			for (auto& entry : entries) {
+				if (entry.info != types[c]) continue;
+				entry.fillRows(archetype->GetComponent(c, row), *entry.prototype, run, entities + done);
+				break;
+			}
+			archetype->MarkAdded(c, row, tick);
+		}
+		done += run;
+	}
+
+	std::vector<std::uint32_t> indices;
+	for (auto& entry : entries) {
+		if (!entry.fillPool) continue;
+
+		if (indices.empty()) {
+			indices.resize(count);
+			for (std::size_t i = 0; i < count; i++) indices[i] = ids[i].index;
+		}
+		entry.fillPool(*this, *entry.prototype, indices.data(), count, entities);
+	}
+
+	for (std::size_t i = 0; i < count; i++) entities[i]->RefreshTransform();
+
+	const Signature added = signature & observers.Observed(ObserverEvent::Add);
+	forEachComponentId(added, [&](TypeID type) {
+		for (auto& id : ids) observers.Record(ObserverEvent::Add, type, id);
+	});
+}
+
+void ComponentStorage::Move(Entity* e, Archetype* to)
+{
+	Archetype* from = e->archetype;
+	std::size_t oldRow = e->row;
+	std::size_t newRow = to->AllocateRow(e);
+
+	const auto& types = to->GetTypes();
+	for (std::size_t c = 0; c < types.size(); c++) {
+		int fromColumn = from->ColumnIndex(types[c]->id);
+		if (fromColumn >= 0) {
+			types[c]->moveConstruct(to->GetComponent(c, newRow), from->GetComponent(fromColumn, oldRow));
+			to->MergeTicks(c, newRow, *from, fromColumn, oldRow);
+		}
+	}
+
+	// the old row still holds the moved from components, RemoveRow destroys them
+	Entity* moved = from->RemoveRow(oldRow);
+	if (moved) {
+		moved->row = oldRow;
+		moved->RefreshTransform();
+	}
+
+	const TypeID transformId = getCompTypeID<Transform>();
+	if (from->GetSignature().test(transformId) && !to->GetSignature().test(transformId)) transformsLost++;
+
+	e->archetype = to;
+	e->row = newRow;
+	e->signature = (e->signature & ~from->GetSignature()) | to->GetSignature();
+}
+
+void ComponentStorage::Erase(Entity* e)
+{
+	// table bits are covered by the archetype, the rest are pools the entity is in
+	const Signature pooled = e->signature & ~e->archetype->GetSignature();
+	if (e->archetype->GetSignature().test(getCompTypeID<Transform>())) transformsLost++;
+
+	Entity* moved = e->archetype->RemoveRow(e->row);
+	if (moved) {
+		moved->row = e->row;
+		moved->RefreshTransform();
+	}
+
+	forEachComponentId(pooled, [&](TypeID type) { pools[type]->Remove(e->id.index); });
+
+	const Signature destroyed = e->signature & observers.Observed(ObserverEvent::Destroy);
+	forEachComponentId(destroyed, [&](TypeID type) { observers.Record(ObserverEvent::Destroy, type, e->id); });
+
+	e->archetype = nullptr;
+	e->signature.reset();
+
+	// retire the id, handles still pointing at this slot are now stale
+	Slot& slot = slots[e->id.index];
+	slot.entity = nullptr;
+	slot.generation++;
+
+	std::lock_guard<std::mutex> lock(freeSlotsMutex);
+	freeSlots.push_back(e->id.index);
+}
+
+const std::vector<std::unique_ptr<Archetype>>& ComponentStorage::GetArchetypes() const
+{
+	return archetypes;
+}
+
+void ComponentStorage::RestoreSlots(const std::vector<std::uint32_t>& generations, const std::vector<bool>& used)
+{
+	for (auto& slot : slots)
+		if (slot.entity) throw std::logic_error("ComponentStorage::RestoreSlots, entities still exist");
+
+	slots.assign(generations.size(), Slot{ nullptr, 0 });
+	freeSlots.clear();
+
+	// reversed so the lowest free index is handed out first
+	for (std::size_t i = generations.size(); i-- > 0;) {
+		slots[i].generation = generations[i];
+		if (!used[i]) freeSlots.push_back(static_cast<std::uint32_t>(i));
+	}
+
+	nextIndex.store(static_cast<std::uint32_t>(generations.size()), std::memory_order_relaxed);
+}
+
+void ComponentStorage::Restore(const EntityId* ids, std::size_t count, Archetype* archetype, std::vector<Entity*>& out)
+{
+	if (count == 0) return;
+
+	const std::size_t first = out.size();
+	out.reserve(first + count);
+	std::uint32_t maxIndex = 0;
+	for (std::size_t i = 0; i < count; i++) {
+		Entity* e = new (entityPool.Allocate()) Entity(this);
+		e->pool = &entityPool;
+		out.push_back(e);
+		maxIndex = std::max(maxIndex, ids[i].index);
+	}
+	Entity* const* entities = out.data() + first;
+
+	if (maxIndex >= slots.size()) slots.resize(maxIndex + 1, Slot{ nullptr, 0 });
+
+	const std::size_t firstRow = archetype->AllocateRows(entities, count);
+	for (std::size_t i = 0; i < count; i++) {
+		Entity* e = entities[i];
+		slots[ids[i].index].entity = e;
+		e->id = ids[i];
+		e->archetype = archetype;
+		e->row = firstRow + i;
+		e->signature = archetype->GetSignature();
+		e->RefreshTransform();
+	}
+}
+
+void ComponentStorage::RestorePool(TypeID id, const std::uint32_t* indices, const void* data, std::size_t count)
+{
+	std::vector<Entity*> entities(count);
+	for (std::size_t i = 0; i < count; i++) {
+		entities[i] = slots[indices[i]].entity;
+		entities[i]->signature.set(id);
+		observers.Record(ObserverEvent::Add, id, entities[i]->id);
+	}
+
+	pools[id]->Restore(indices, data, count, entities.data(), tick);
+}
+
+void ComponentStorage::Register(const ComponentInfo* info)
+{
+	const ComponentInfo*& known = infos[info->id];
+	if (known == info) return;
+
+	if (known)
+		throw std::logic_error(std::string("Components ") + known->name + " and " + info->name + " were registered with the same id");
+	known = info;
+}
+
+const std::vector<std::unique_ptr<SparseSetBase>>& ComponentStorage::GetPools() const
+{
+	return pools;
+}
+
+void ComponentStorage::ClearTransient()
+{
+	const Signature removed = transientSignature & observers.Observed(ObserverEvent::Remove);
+
+	for (auto pool : transientPools) {
+		for (auto index : pool->Indices()) {
+			Entity* e = slots[index].entity;
+
+			const Signature lost = e->signature & removed;
+			forEachComponentId(lost, [&](TypeID type) { observers.Record(ObserverEvent::Remove, type, e->id); });
+
+			e->signature &= ~transientSignature;
+		}
+		pool->Clear();
+	}
+	frameArena.Reset();
+}
+
+FrameArena* ComponentStorage::GetFrameArena()
+{
+	return &frameArena;
+}
+
+Archetype* ComponentStorage::GetArchetype(std::vector<const ComponentInfo*> types)
+{
+	std::vector<TypeID> key;
+	for (auto t : types) key.push_back(t->id);
+	std::sort(key.begin(), key.end());
+
+	auto found = lookup.find(key);
+	if (found != lookup.end()) return found->second;
+
+	archetypes.emplace_back(new Archetype(std::move(types)));
+	Archetype* archetype = archetypes.back().get();
+
+	auto& pool = chunkPools[archetype->ChunkBytes()];
+	if (!pool) pool.reset(new PoolAllocator(archetype->ChunkBytes(), ECS_CACHE_LINE, std::max<std::size_t>(1, SLAB_BYTES / archetype->ChunkBytes())));
+	archetype->SetChunkAllocator(pool.get());
+	lookup.emplace(std::move(key), archetype);
+	return archetype;
+}
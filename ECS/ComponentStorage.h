@@ -0,0 +1,178 @@
+#ifndef COMPONENT_STORAGE_H
+#define COMPONENT_STORAGE_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Archetype.h"
+#include "EntityId.h"
+#include "Observers.h"
+#include "PoolAllocator.h"
+#include "SparseSet.h"
+
+class Prefab;
+
+// Pool type a non table component is stored in
+template<typename T>
+using PoolOf = std::conditional_t<T::storagePolicy == StoragePolicy::Transient, SparseSet<T, ArenaAllocator<T>>, SparseSet<T>>;
+
+// Owns every archetype and moves entities between them as components are added and removed.
+// Components with StoragePolicy::SparseSet are kept out of the archetypes in one pool per type instead.
+// Chunks come from one PoolAllocator per chunk size, transient components from a FrameArena.
+class ComponentStorage {
+public:
+	ComponentStorage();
+	~ComponentStorage();
+
+	// Archetype with no components, every entity starts here
+	Archetype* GetEmptyArchetype();
+
+	Archetype* GetArchetypeWith(Archetype* from, const ComponentInfo* added);
+	Archetype* GetArchetypeWithout(Archetype* from, TypeID removed);
+
+	// Gives a new entity an id and places it in the empty archetype
+	void Insert(Entity* e);
+	// Same with an id handed out by Reserve earlier
+	void Insert(Entity* e, EntityId reserved);
+	// Hands out an id for an entity that will be inserted later, safe to call from any thread
+	EntityId Reserve();
+	// count ids at once, taking the lock once
+	void Reserve(EntityId* ids, std::size_t count);
+	// Moves the entity to another archetype, components both have are moved across,
+	// components only the old one has are destroyed, new ones are left uninitialised
+	void Move(Entity* e, Archetype* to);
+	// Destroys all of the entities components, frees its row and retires its id
+	void Erase(Entity* e);
+	// Creates count entities holding copies of the prefab's components and appends them to out.
+	// Rows, pool space and ids are taken in bulk and the components copied a chunk at a time.
+	void Instantiate(const Prefab& prefab, std::size_t count, std::vector<Entity*>& out);
+
+	const std::vector<std::unique_ptr<Archetype>>& GetArchetypes() const;
+	// Archetype with exactly these types, created if there isn't one yet
+	Archetype* GetArchetype(std::vector<const ComponentInfo*> types);
+
+	// Makes a type known before any component of it is stored, so a snapshot holding it can be loaded
+	template<typename T>
+	inline void Register();
+
+	// Records the type under its id, throws std::logic_error if another type already has it
+	void Register(const ComponentInfo* info);
+	// nullptr until a component of that type has been stored
+	inline const ComponentInfo* GetInfo(TypeID id) const { return id < infos.size() ? infos[id] : nullptr; }
+
+	// Pool of a sparse set or transient component, created on first use
+	template<typename T>
+	inline PoolOf<T>& GetPool();
+	// nullptr if no component of this type has been stored in a pool yet
+	inline SparseSetBase* GetPool(TypeID id) const { return pools[id].get(); }
+	const std::vector<std::unique_ptr<SparseSetBase>>& GetPools() const;
+	inline bool IsTransient(TypeID id) const { return transientSignature.test(id); }
+
+	// Current tick, stamped on components as they are added and written.
+	// Starts at 1 so a fresh chunk or element (tick 0) never counts as changed.
+	inline Tick GetTick() const { return tick; }
+	// Called by EntityManager::Update once the frame is done
+	inline void NextTick() { tick++; }
+	// Entities that have lost their Transform so far, destroyed or removed. Caches keyed by
+	// entity only need to look for stale entries when this has moved.
+	inline std::uint64_t GetTransformsLost() const { return transformsLost; }
+
+	// Add / remove / destroy events are recorded here as they happen
+	Observers* GetObservers() { return &observers; }
+
+	// Removes every transient component and resets the frame arena
+	void ClearTransient();
+	FrameArena* GetFrameArena();
+
+	inline bool IsValid(EntityId id) const {
+		return id.index < slots.size() && slots[id.index].generation == id.generation && slots[id.index].entity;
+	}
+	// nullptr if the id is stale
+	inline Entity* GetEntity(EntityId id) const {
+		return IsValid(id) ? slots[id.index].entity : nullptr;
+	}
+	inline Entity* GetEntity(std::uint32_t index) const { return slots[index].entity; }
+	// Number of id slots handed out so far, live or not
+	std::uint32_t SlotCount() const { return static_cast<std::uint32_t>(slots.size()); }
+	inline std::uint32_t SlotGeneration(std::uint32_t index) const { return slots[index].generation; }
+
+	// Replaces the id slots with generations and used from a snapshot, only valid while no entity exists.
+	// Unused slots go on the free list, used ones are filled by Restore.
+	void RestoreSlots(const std::vector<std::uint32_t>& generations, const std::vector<bool>& used);
+	// Creates count bare entities under ids, appends them to out and gives them contiguous rows in
+	// archetype. Like Instantiate the entities and rows are taken in bulk, the rows' components are
+	// left uninitialised for the caller to restore.
+	void Restore(const EntityId* ids, std::size_t count, Archetype* archetype, std::vector<Entity*>& out);
+	// Adds count sparse set components of type id copy constructed from their snapshot bytes,
+	// see SparseSetBase::Restore. The entities must exist and not have the component yet.
+	void RestorePool(TypeID id, const std::uint32_t* indices, const void* data, std::size_t count);
+
+private:
+	ComponentStorage(ComponentStorage& other) = delete;
+	void operator=(const ComponentStorage&) = delete;
+
+	// chunk size -> pool, declared before the archetypes so it outlives their chunks
+	std::map<std::size_t, std::unique_ptr<PoolAllocator>> chunkPools;
+	FrameArena frameArena;
+	// Entity objects made by Instantiate, the manager owns them and frees them here through EntityDeleter
+	PoolAllocator entityPool;
+
+	std::map<std::vector<TypeID>, Archetype*> lookup;
+	std::vector<std::unique_ptr<Archetype>> archetypes;
+
+	// indexed by TypeID, ECS_MAX_COMPONENTS long
+	std::vector<const ComponentInfo*> infos;
+	// indexed by TypeID, ECS_MAX_COMPONENTS long, empty for table components
+	std::vector<std::unique_ptr<SparseSetBase>> pools;
+	std::vector<SparseSetBase*> transientPools;
+	// bits of every transient type, cleared from the entities when the pools are
+	Signature transientSignature;
+
+	struct Slot {
+		Entity* entity;
+		std::uint32_t generation;
+	};
+
+	// id index -> entity, freed slots are recycled through the free list with a new generation.
+	// slots is only grown on insert, ids reserved past its end come from nextIndex
+	std::vector<Slot> slots;
+	std::vector<std::uint32_t> freeSlots;
+	std::atomic<std::uint32_t> nextIndex;
+	std::mutex freeSlotsMutex;
+
+	Tick tick;
+	std::uint64_t transformsLost;
+
+	Observers observers;
+
+};
+
+template<typename T>
+inline PoolOf<T>& ComponentStorage::GetPool()
+{
+	constexpr TypeID id = getCompTypeID<T>();
+
+	if (!pools[id]) {
+		Register(ComponentInfo::Of<T>());
+		if constexpr (T::storagePolicy == StoragePolicy::Transient) {
+			pools[id].reset(new PoolOf<T>(ArenaAllocator<T>(&frameArena)));
+			transientPools.push_back(pools[id].get());
+			transientSignature.set(id);
+		}
+		else pools[id].reset(new PoolOf<T>());
+	}
+
+	return *static_cast<PoolOf<T>*>(pools[id].get());
+}
+
+template<typename T>
+inline void ComponentStorage::Register()
+{
+	if constexpr (T::storagePolicy == StoragePolicy::Table) Register(ComponentInfo::Of<T>());
+	else GetPool<T>();
+}
+
+#endif
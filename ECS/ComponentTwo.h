@@ -1,28 +1,36 @@
 #ifndef COMP_TWO_H
 #define COMP_TWO_H
 
-#include <iostream>
-
 #include "ComponentOne.h"
+#include "Entity.h"
 
 class ComponentTwo : public Component {
 public:
-	ComponentTwo(float a, float b) : a(a), b(b), one(new ComponentOne(999, 999)) {};
-	ComponentTwo(float a, float b, ComponentOne* one) : a(a), b(b), one(one) {};
+	ComponentTwo(float a, float b) : a(a), b(b) {};
 
-	void Update() {
-		std::cout << "COMPONENTTWO: " << this << " values: " << a << " and " << b << " and comp one: " << std::endl << "------";
-		one->Print();
+	// added and removed at runtime, keep it out of the archetype so that doesn't move the entity
+	static constexpr StoragePolicy storagePolicy = StoragePolicy::SparseSet;
+	static constexpr bool bitwiseSnapshot = true;
 
-		a--;
-		b -= 0.5f;
-	}
+	void Update();
 
 private:
-	ComponentOne* one;
 	float a;
 	float b;
 
 };
 
-#endif
\ No newline at end of file
+ECS_REGISTER_COMPONENT(ComponentTwo, 2)
+
+inline void ComponentTwo::Update()
+{
+	// looked up every time, components move when their entity changes archetype
+	if (entity->has<ComponentOne>()) ECS_LOG_DEBUG("ComponentTwo: {} values {} and {}, ComponentOne {}", this, a, b, &entity->get<ComponentOne>());
+	else ECS_LOG_DEBUG("ComponentTwo: {} values {} and {}, no ComponentOne", this, a, b);
+
+	a--;
+	b -= 0.5f;
+	entity->markChanged<ComponentTwo>();
+}
+
+#endif
@@ -0,0 +1,45 @@
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER) && defined(ECS_X86)
+#include <intrin.h>
+#endif
+
+static CpuFeatures Detect()
+{
+	CpuFeatures features = { false, false, false, false };
+
+#if defined(ECS_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	features.sse2 = (info[3] & (1 << 26)) != 0;
+	features.sse41 = (info[2] & (1 << 19)) != 0;
+	bool fma = (info[2] & (1 << 12)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+
+	// AVX state has to be enabled by the OS as well
+	bool avxState = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+
+	if (maxLeaf >= 7) {
+		__cpuidex(info, 7, 0);
+		features.avx2 = avxState && (info[1] & (1 << 5)) != 0;
+	}
+	features.fma = avxState && fma;
+#elif defined(ECS_X86)
+	__builtin_cpu_init();
+	features.sse2 = __builtin_cpu_supports("sse2");
+	features.sse41 = __builtin_cpu_supports("sse4.1");
+	features.avx2 = __builtin_cpu_supports("avx2");
+	features.fma = __builtin_cpu_supports("fma");
+#endif
+
+	return features;
+}
+
+const CpuFeatures& CpuFeatures::Get()
+{
+	static const CpuFeatures features = Detect();
+	return features;
+}
@@ -0,0 +1,27 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define ECS_X86 1
+#include <immintrin.h>
+#endif
+
+// GCC and Clang only emit AVX2 / FMA instructions inside functions marked for them,
+// MSVC emits any intrinsic anywhere. Only call these functions after checking CpuFeatures.
+#if defined(__GNUC__) || defined(__clang__)
+#define ECS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define ECS_TARGET_AVX2
+#endif
+
+// What the CPU the process is running on supports, detected once
+struct CpuFeatures {
+	bool sse2;
+	bool sse41;
+	bool avx2;
+	bool fma;
+
+	static const CpuFeatures& Get();
+};
+
+#endif
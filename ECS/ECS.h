@@ -2,27 +2,168 @@
 #define ECS_H
 
 #include <bitset>
+#include <cstdint>
 #include <iostream>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 class Entity;
 class Component;
 
 using TypeID = std::size_t;
+// Frame counter stamped on components as they are added and written, see ComponentStorage::GetTick
+using Tick = std::uint32_t;
+
+// Size of a cache line, every chunk and every column inside a chunk starts on one
+constexpr std::size_t ECS_CACHE_LINE = 64;
+// Size of a single archetype chunk in bytes
+constexpr std::size_t ECS_CHUNK_SIZE = 16 * 1024;
+// Component ids are dense, every id is below this. Signatures carry one bit per id, loops over
+// the types of an entity walk the set bits with forEachComponentId rather than every id.
+constexpr TypeID ECS_MAX_COMPONENTS = 256;
 
-inline TypeID getUniqueTypeID() {
-	static TypeID lastID = 0u;
-	return lastID++;
+// Where a component type keeps its data, chosen per type with a static member on the component:
+//   static constexpr StoragePolicy storagePolicy = StoragePolicy::SparseSet;
+// Table components live in archetype chunks, fastest to iterate but adding or removing one moves the entity.
+// SparseSet components live in one packed pool per type, adding and removing is O(1) and never moves the entity.
+// Transient components are sparse set components allocated from the per frame arena,
+// every one of them is removed at the end of the next EntityManager::Update.
+enum class StoragePolicy {
+	Table,
+	SparseSet,
+	Transient
+};
+
+// 32 bit FNV-1a, stable across builds and platforms
+constexpr std::uint32_t ecsHashName(const char* name) {
+	std::uint32_t hash = 2166136261u;
+	for (; *name; name++) hash = (hash ^ static_cast<unsigned char>(*name)) * 16777619u;
+	return hash;
 }
 
-// Gives a unique numerical id based on the class type
+// Filled in for every component type by ECS_REGISTER_COMPONENT
+template<typename T>
+struct ComponentTypeID {
+	static_assert(sizeof(T) == 0, "Error: Component not registered, add ECS_REGISTER_COMPONENT(Type, ID) after it");
+};
+
+// Gives a component type its id, put it at global scope right after the class.
+// Ids are part of the snapshot format, pick an unused one below ECS_MAX_COMPONENTS and never change it.
+#define ECS_REGISTER_COMPONENT(Type, ID) \
+	template<> struct ComponentTypeID<Type> { \
+		static_assert((ID) < ECS_MAX_COMPONENTS, "Error: component id out of range"); \
+		static constexpr TypeID value = (ID); \
+		static constexpr const char* name = #Type; \
+		static constexpr std::uint32_t nameHash = ecsHashName(#Type); \
+	};
+
+// Numerical id of a component type, known at compile time
+template<typename T>
+inline constexpr TypeID compTypeID = ComponentTypeID<T>::value;
+
 template<typename T>
-inline TypeID getCompTypeID() noexcept {
+constexpr TypeID getCompTypeID() noexcept {
 	// will explode if object is not a component
 	static_assert(std::is_base_of<Component, T>::value, "Error: Type not a Component");
-	
-	// not insta returning because we want it to be constant per type of component
-	static const TypeID typeID = getUniqueTypeID();
-	return typeID;
+	return compTypeID<T>;
+}
+
+// One bit per component type, set for every type an entity or archetype has
+using Signature = std::bitset<ECS_MAX_COMPONENTS>;
+
+// Index of the lowest set bit, word must not be 0
+inline unsigned int ecsCountTrailingZeros(std::uint64_t word) noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return static_cast<unsigned int>(index);
+#elif defined(_MSC_VER)
+	unsigned int index = 0;
+	for (; !(word & 1); word >>= 1) index++;
+	return index;
+#else
+	return static_cast<unsigned int>(__builtin_ctzll(word));
+#endif
+}
+
+// Calls f(id) for every id set in signature, lowest first. Goes a 64 bit word at a time, so
+// an entity with a few components costs a few steps however high ECS_MAX_COMPONENTS is.
+template<typename F>
+inline void forEachComponentId(const Signature& signature, F&& f) {
+	static const Signature lowWord(~0ULL);
+
+	for (TypeID base = 0; base < ECS_MAX_COMPONENTS; base += 64) {
+		std::uint64_t word = ((signature >> base) & lowWord).to_ullong();
+		for (; word; word &= word - 1) f(base + ecsCountTrailingZeros(word));
+	}
+}
+
+// Mask with the bit of each of Ts set
+template<typename... Ts>
+inline Signature signatureOf() noexcept {
+	Signature mask;
+	(mask.set(getCompTypeID<Ts>()), ...);
+	return mask;
+}
+
+// Type erased description of a component, lets the storage move and destroy
+// components it only knows by TypeID
+struct ComponentInfo {
+	TypeID id;
+	const char* name;
+	std::uint32_t nameHash;
+	std::size_t size;
+	std::size_t align;
+
+	// move constructs into uninitialised dst, src is left alive and must still be destroyed
+	void (*moveConstruct)(void* dst, void* src);
+	void (*destroy)(void* ptr);
+	Component* (*asComponent)(void* ptr);
+	// copy constructs count components into uninitialised dst from their bytes at src, as written
+	// by a snapshot, and points them at their entities. nullptr if the type can't be snapshotted.
+	void (*restore)(void* dst, const void* src, std::size_t count, Entity* const* entities);
+
+	template<typename T>
+	static constexpr const ComponentInfo* Of();
+};
+
+// ComponentInfo::restore of a component type, the copy reads the bytes at src as Ts
+template<typename T>
+inline void restoreComponentRange(void* dst, const void* src, std::size_t count, Entity* const* entities)
+{
+	T* to = static_cast<T*>(dst);
+	const T* from = static_cast<const T*>(src);
+	for (std::size_t i = 0; i < count; i++) {
+		T* comp = new (to + i) T(from[i]);
+		comp->entity = entities[i];
+	}
+}
+
+template<typename T>
+inline constexpr void (*componentRestoreOf)(void*, const void*, std::size_t, Entity* const*) = T::bitwiseSnapshot ? restoreComponentRange<T> : nullptr;
+
+template<typename T>
+inline constexpr ComponentInfo componentInfoOf{
+	getCompTypeID<T>(),
+	ComponentTypeID<T>::name,
+	ComponentTypeID<T>::nameHash,
+	sizeof(T),
+	alignof(T),
+	[](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); },
+	[](void* ptr) { static_cast<T*>(ptr)->~T(); },
+	[](void* ptr) -> Component* { return static_cast<T*>(ptr); },
+	componentRestoreOf<T>
+};
+
+template<typename T>
+inline constexpr const ComponentInfo* ComponentInfo::Of()
+{
+	return &componentInfoOf<T>;
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -1,37 +1,72 @@
 #include "Entity.h"
+#include "EntityManager.h"
 
-Entity::Entity() : alive(true)
+Entity::Entity(EntityManager& world) : transform(nullptr), storage(world.GetStorage()), listIndex(0), pending(false), alive(true), pool(nullptr)
 {
-	transform = &(add<Transform>());
+	storage->Insert(this);
+	add<Transform>();
 }
 
-Entity::Entity(Vec3 pos, Quat rot, Vec3 scl) : alive(true)
+Entity::Entity(EntityManager& world, Vec3 pos, Quat rot, Vec3 scl) : transform(nullptr), storage(world.GetStorage()), listIndex(0), pending(false), alive(true), pool(nullptr)
 {
-	transform = &(add<Transform>(pos, rot, scl));
+	storage->Insert(this);
+	add<Transform>(pos, rot, scl);
 }
 
-Entity::~Entity()
+Entity::Entity(ComponentStorage* storage, EntityId reserved, Vec3 pos, Quat rot, Vec3 scl) : transform(nullptr), storage(storage), listIndex(0), pending(false), alive(true), pool(nullptr)
 {
-	for (auto itr = components.begin(); itr != components.end(); itr++)
-	{
-		delete (itr->second);
+	storage->Insert(this, reserved);
+	add<Transform>(pos, rot, scl);
+}
+
+Entity::Entity(ComponentStorage* storage) : transform(nullptr), storage(storage), archetype(nullptr), row(0), listIndex(0), pending(false), alive(true), pool(nullptr)
+{
+}
+
+void EntityDeleter::operator()(Entity* e) const
+{
+	PoolAllocator* pool = e->pool;
+	if (!pool) {
+		delete e;
+		return;
 	}
-	components.clear();
+
+	e->~Entity();
+	pool->Free(e);
+}
+
+Entity::~Entity()
+{
+	storage->Erase(this);
+	transform = nullptr;
 }
 
 bool Entity::isAlive()
 {
-	return alive;
+	return alive.load(std::memory_order_relaxed);
 }
 
 void Entity::kill()
 {
-	alive = false;
+	alive.store(false, std::memory_order_relaxed);
 }
 
 void Entity::Update()
 {
-	for (auto& c : components) {
-		c.second->Update();
-	}
-}
\ No newline at end of file
+	// nothing is stamped here, components that write themselves in Update call markChanged,
+	// so mostly static ones such as Transform stay out of Changed<T> views
+	const auto& types = archetype->GetTypes();
+	for (std::size_t c = 0; c < types.size(); c++)
+		types[c]->asComponent(archetype->GetComponent(c, row))->Update();
+
+	// table bits are covered by the archetype, the rest are pools the entity is in
+	const Signature pooled = signature & ~archetype->GetSignature();
+	forEachComponentId(pooled, [this](TypeID type) {
+		storage->GetPool(type)->GetComponentBase(id.index)->Update();
+	});
+}
+
+void Entity::RefreshTransform()
+{
+	transform = has<Transform>() ? &get<Transform>() : nullptr;
+}
@@ -1,18 +1,32 @@
 #ifndef ENTITY_H
 #define ENTITY_H
 
-#include <map>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
 
 #include "ECS.h"
 #include "Component.h"
+#include "ComponentStorage.h"
 #include "Transform.h"
 
+class EntityManager;
+
+// Deletes entities however they were allocated, with new or from their storage's entity pool
+struct EntityDeleter {
+	void operator()(Entity* e) const;
+};
+using EntityPtr = std::unique_ptr<Entity, EntityDeleter>;
+
 class Entity {
 public:
-	Entity();
-	Entity(Vec3 pos, Quat rot, Vec3 scl);
+	// Entities belong to the world they are created in, hand them to that world's AddEntity
+	Entity(EntityManager& world);
+	Entity(EntityManager& world, Vec3 pos, Quat rot, Vec3 scl);
 	virtual ~Entity();
 
+	// Components live in the archetype chunks, pointers and references to them
+	// are only valid until the next add or remove on this entity
 	Transform* transform;
 
 	template<typename T, typename... TArgs>
@@ -27,9 +41,19 @@ public:
 	template<typename T>
 	inline bool has();
 
+	// Stamps the component as written this tick, for Changed<T> views. Call it after writing
+	// through get or transform, or from a component's own Update. Views with non const access
+	// and add already do it.
+	template<typename T>
+	inline void markChanged();
+
 	template<typename T, typename T2, typename... TArgs>
 	inline bool has();
 
+	EntityId GetId() const { return id; }
+	// Bit set for every component on the entity, table and sparse set alike
+	const Signature& GetSignature() const { return signature; }
+
 	virtual bool isAlive();
 	virtual void kill();
 
@@ -37,29 +61,77 @@ public:
 
 protected:
 	friend class EntityManager;
-
-	std::map<TypeID, Component*> components;
-	bool alive;
+	friend class ComponentStorage;
+	friend struct EntityDeleter;
+
+	// Creates the entity under an id reserved by a CommandBuffer
+	Entity(ComponentStorage* storage, EntityId reserved, Vec3 pos, Quat rot, Vec3 scl);
+	// Bare entity for ComponentStorage::Restore, which places it and fills in its components
+	Entity(ComponentStorage* storage);
+
+	ComponentStorage* storage;
+	Archetype* archetype;
+	std::size_t row;
+	// id.index keys the sparse set pools
+	EntityId id;
+	// kept in sync by add / remove and ComponentStorage::Move
+	Signature signature;
+	// position in the managers entity list, or its new entity list while pending
+	std::size_t listIndex;
+	bool pending;
+	// kill may be called from any thread
+	std::atomic<bool> alive;
+	// pool the entity was placed in by ComponentStorage::Instantiate, nullptr if it came from new
+	PoolAllocator* pool;
+
+private:
+	Entity(const Entity&) = delete;
+	void operator=(const Entity&) = delete;
+
+	// transform is cached, has to be looked up again whenever the entity changes archetype
+	void RefreshTransform();
 };
 
 template<typename T, typename ... TArgs>
 inline T& Entity::add(TArgs && ... args)
 {
 	// Creates new component with its arguments for its constructor
-	T* comp(new T(std::forward<TArgs>(args)...));
+	T comp(std::forward<TArgs>(args)...);
 
 	// Checks to see if created successfully
 	// init returns true by default, so objects that only need to construct and not init will return true
-	if (comp->init()) {
+	if (comp.init()) {
 		// Get a id based on the class type of component
-		comp->id = getCompTypeID<T>();
-		// insert into entities map of components
-		components.emplace(comp->id, comp);
-		comp->entity = this;
-		return *comp;
+		comp.id = getCompTypeID<T>();
+		comp.entity = this;
+
+		if constexpr (T::storagePolicy != StoragePolicy::Table) {
+			// sparse and transient components go in their pool, the entity stays where it is
+			if (!has<T>()) storage->GetObservers()->Record(ObserverEvent::Add, comp.id, id);
+			signature.set(comp.id);
+			return storage->GetPool<T>().Emplace(id.index, std::move(comp), storage->GetTick());
+		}
+		// adding a type we already have replaces it in place
+		else if (has<T>()) {
+			T* existing = &get<T>();
+			existing->~T();
+			markChanged<T>();
+			return *new (existing) T(std::move(comp));
+		}
+
+		// move the entity over to the archetype with T and construct into the new column
+		storage->Move(this, storage->GetArchetypeWith(archetype, ComponentInfo::Of<T>()));
+		int column = archetype->ColumnIndex(comp.id);
+		T* slot = static_cast<T*>(archetype->GetComponent(column, row));
+		new (slot) T(std::move(comp));
+		archetype->MarkAdded(column, row, storage->GetTick());
+		storage->GetObservers()->Record(ObserverEvent::Add, comp.id, id);
+
+		RefreshTransform();
+		return *slot;
 	}
 
-	// else returns a null 
+	// else returns a null
 	return *static_cast<T*>(nullptr);
 }
 
@@ -67,31 +139,58 @@ template<typename T>
 inline T& Entity::get() const
 {
 	// Grabs component from entity of type inserted
-	auto ptr(components.at(getCompTypeID<T>()));
-	return *static_cast<T*>(ptr);
+	if constexpr (T::storagePolicy != StoragePolicy::Table) {
+		if (!signature.test(getCompTypeID<T>())) throw std::out_of_range("Entity::get, component not on entity");
+
+		return static_cast<PoolOf<T>*>(storage->GetPool(getCompTypeID<T>()))->Get(id.index);
+	}
+
+	int column = archetype->ColumnIndex(getCompTypeID<T>());
+	if (column < 0) throw std::out_of_range("Entity::get, component not on entity");
+
+	return *static_cast<T*>(archetype->GetComponent(column, row));
 }
 
 // removes component if it exists on entity
 template<typename T>
 inline void Entity::remove() {
 
-	T* comp = &get<T>();
-
-	if (comp != nullptr) {
-		components.erase(comp->id);
-		delete comp;
+	if constexpr (T::storagePolicy != StoragePolicy::Table) {
+		if (has<T>()) {
+			storage->GetPool(getCompTypeID<T>())->Remove(id.index);
+			signature.reset(getCompTypeID<T>());
+			storage->GetObservers()->Record(ObserverEvent::Remove, getCompTypeID<T>(), id);
+		}
+	}
+	else if (has<T>()) {
+		storage->Move(this, storage->GetArchetypeWithout(archetype, getCompTypeID<T>()));
+		RefreshTransform();
+		storage->GetObservers()->Record(ObserverEvent::Remove, getCompTypeID<T>(), id);
 	}
 }
 
 template<typename T>
 inline bool Entity::has()
 {
-	return components.count(getCompTypeID<T>());
+	return signature.test(getCompTypeID<T>());
 }
 
 template<typename T, typename T2, typename... TArgs>
-inline bool Entity::has() 
+inline bool Entity::has()
 {
-	return has<T>() && has<T2, TArgs...>();
+	// one AND and compare however many types are asked for
+	const Signature mask = signatureOf<T, T2, TArgs...>();
+	return (signature & mask) == mask;
 }
-#endif 
\ No newline at end of file
+template<typename T>
+inline void Entity::markChanged()
+{
+	if (!has<T>()) return;
+
+	if constexpr (T::storagePolicy != StoragePolicy::Table)
+		storage->GetPool(getCompTypeID<T>())->MarkChanged(id.index, storage->GetTick());
+	else
+		archetype->MarkChanged(archetype->ColumnIndex(getCompTypeID<T>()), row, storage->GetTick());
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef ENTITY_ID_H
+#define ENTITY_ID_H
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+
+// Handle to an entity, 32 bit slot index + 32 bit generation.
+// The generation is bumped whenever the slot is freed, so handles to a
+// destroyed entity stop being valid even after the index is reused.
+struct EntityId {
+	std::uint32_t index;
+	std::uint32_t generation;
+
+	constexpr EntityId() : index(~0u), generation(0) {}
+	constexpr EntityId(std::uint32_t index, std::uint32_t generation) : index(index), generation(generation) {}
+
+	constexpr std::uint64_t Value() const { return (static_cast<std::uint64_t>(generation) << 32) | index; }
+	constexpr bool IsNull() const { return index == ~0u; }
+
+	static const EntityId null;
+};
+
+inline constexpr EntityId EntityId::null = EntityId();
+
+inline bool operator==(const EntityId a, const EntityId b) { return a.Value() == b.Value(); }
+inline bool operator!=(const EntityId a, const EntityId b) { return !(a == b); }
+inline bool operator<(const EntityId a, const EntityId b) { return a.Value() < b.Value(); }
+
+inline std::ostream& operator<<(std::ostream& os, const EntityId& id)
+{
+	os << id.index << "v" << id.generation;
+	return os;
+}
+
+namespace std {
+	template<> struct hash<EntityId> {
+		std::size_t operator()(const EntityId id) const noexcept { return std::hash<std::uint64_t>()(id.Value()); }
+	};
+}
+
+#endif
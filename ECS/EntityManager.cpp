@@ -1,26 +1,23 @@
 #include "EntityManager.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "WorldSnapshot.h"
 
-EntityManager* EntityManager::instance = nullptr;
-bool EntityManager::running = true;
+#include <algorithm>
+#include <thread>
 
-EntityManager::EntityManager()
+EntityManager::EntityManager() : EntityManager(std::max(1u, std::thread::hardware_concurrency()) - 1)
 {
-	if (instance != nullptr) { delete this; }
-	else instance = this;
-	
-	running = true;
 }
 
-EntityManager::~EntityManager()
+EntityManager::EntityManager(unsigned int workers) : running(true), jobs(workers), scheduler(jobs)
 {
-	if (instance == this)
-		instance = nullptr;
+	// components still update themselves through their virtual Update
+	scheduler.AddSystem<ComponentUpdateSystem>();
 }
 
-EntityManager* EntityManager::Get()
+EntityManager::~EntityManager()
 {
-	if (instance == nullptr) new EntityManager();
-	return instance;
 }
 
 void EntityManager::SetRunning(bool running)
@@ -32,63 +29,276 @@ void EntityManager::Update()
 {
 	if (!running) return;
 
-	for (auto& e : entities) e->Update();
+	ECS_PROFILE_SCOPE("EntityManager::Update");
+
+	scheduler.Run(*this);
+	FlushCommands();
 
 	Refresh();
 	AddNewEntities();
+	DispatchEvents();
+
+	// after Refresh so destroyed entities are already gone
+	hierarchy.Update(*this);
+	if (spatial) spatial->Update(*this);
+	// last, so readers see the frame exactly as it ends
+	if (published) published->Publish(*this);
+
+	// transient components only last one frame
+	storage.ClearTransient();
+	storage.NextTick();
 }
 
 void EntityManager::Refresh()
 {
-	int counter = 0;
+	ECS_PROFILE_SCOPE("EntityManager::Refresh");
 
-	for (int i = 0; i < entities.size() - counter; i++) 
-		if (!entities[i]->isAlive()) { 
-			std::cout << "Killing entity " << entities[i] << std::endl;
-			std::swap(entities[i], entities[entities.size() - 1 - counter]);
-			counter++;
+	for (std::size_t i = 0; i < entities.size();) {
+		if (!entities[i]->isAlive()) {
+			ECS_LOG_INFO("Killing entity {}", entities[i]->GetId());
+			EraseEntity(static_cast<unsigned int>(i));
 		}
-	
-	entities.erase(entities.end() - counter, entities.end());
+		else i++;
+	}
+
+	// entities killed before they were ever added
+	for (std::size_t i = 0; i < newEntities.size();) {
+		if (!newEntities[i]->isAlive()) EraseEntity(newEntities[i].get());
+		else i++;
+	}
 }
 
 void EntityManager::Purge()
 {
-	for (auto& e : entities) e->alive = false;
+	for (auto& e : entities) e->kill();
 	newEntities.clear();
 	running = false;
 }
 
-std::vector<std::shared_ptr<Entity>>* EntityManager::GetEntities()
+std::vector<EntityPtr>* EntityManager::GetEntities()
 {
 	return &entities;
 }
 
-void EntityManager::AddEntity(Entity* e)
+CommandBuffer& EntityManager::GetCommandBuffer()
 {
-	std::shared_ptr<Entity> ptr(e);
-	newEntities.push_back(ptr);
+	std::lock_guard<std::mutex> lock(commandBuffersMutex);
+
+	auto& buffer = commandBuffers[std::this_thread::get_id()];
+	if (!buffer) buffer.reset(new CommandBuffer(&storage));
+	return *buffer;
 }
 
-void EntityManager::EraseEntity(Entity* e)
+void EntityManager::FlushCommands()
 {
-	for (int i = 0; i < entities.size(); i++) {
-		if (e == entities[i].get()) {
-			entities.erase(entities.begin() + i);
+	ECS_PROFILE_SCOPE("EntityManager::FlushCommands");
+
+	std::vector<CommandBuffer::Command*> commands;
+	for (auto& buffer : commandBuffers)
+		for (auto& command : buffer.second->commands)
+			commands.push_back(&command);
+
+	if (commands.empty()) return;
+
+	// stable, so changes to one entity keep the order they were recorded in
+	std::stable_sort(commands.begin(), commands.end(), [](const CommandBuffer::Command* a, const CommandBuffer::Command* b) {
+		if (a->type != b->type) return a->type < b->type;
+		return a->id.index < b->id.index;
+	});
+
+	for (auto command : commands) {
+		switch (command->type) {
+		case CommandBuffer::CommandType::Create: {
+			Transform* t = static_cast<Transform*>(command->payload);
+			AddEntity(new Entity(&storage, command->id, t->position, t->rotation, t->scale));
+			break;
+		}
+		case CommandBuffer::CommandType::Change: {
+			// changes to entities destroyed in the meantime are dropped, Clear discards the payload
+			Entity* e = storage.GetEntity(command->id);
+			if (e) {
+				command->apply(*e, command->payload);
+				command->payload = nullptr;
+			}
+			break;
+		}
+		case CommandBuffer::CommandType::Destroy: {
+			Entity* e = storage.GetEntity(command->id);
+			if (e) e->kill();
 			break;
 		}
+		}
+	}
+
+	for (auto& buffer : commandBuffers)
+		buffer.second->Clear();
+}
+
+void EntityManager::SaveSnapshot(const std::string& path) const
+{
+	WorldSnapshot::Save(storage, path);
+}
+
+void EntityManager::LoadSnapshot(const std::string& path)
+{
+	if (!entities.empty() || !newEntities.empty()) throw std::logic_error("EntityManager::LoadSnapshot, the world is not empty");
+
+	WorldSnapshot snapshot(path, storage);
+	snapshot.RestoreSlots(storage);
+
+	std::vector<Entity*> restored;
+	restored.reserve(snapshot.EntityCount());
+	for (auto& block : snapshot.GetBlocks()) snapshot.RestoreRows(storage, block, 0, block.rows, restored);
+	for (auto& block : snapshot.GetPoolBlocks()) snapshot.RestorePool(storage, block, 0, block.count);
+
+	entities.reserve(entities.size() + restored.size());
+	for (auto e : restored) {
+		e->listIndex = entities.size();
+		entities.emplace_back(e);
+	}
+}
+
+Scheduler* EntityManager::GetScheduler()
+{
+	return &scheduler;
+}
+
+JobSystem* EntityManager::GetJobs()
+{
+	return &jobs;
+}
+
+Observers* EntityManager::GetObservers()
+{
+	return storage.GetObservers();
+}
+
+void EntityManager::DispatchEvents()
+{
+	ECS_PROFILE_SCOPE("EntityManager::DispatchEvents");
+
+	storage.GetObservers()->Dispatch(*this);
+}
+
+SpatialIndex& EntityManager::CreateSpatialIndex(SpatialIndexType type, double cellSize)
+{
+	// the observers outlive any one index, they only need adding the first time
+	if (!spatial) {
+		auto drop = [](EntityManager& manager, const std::vector<EntityId>& ids) {
+			if (!manager.spatial) return;
+			for (auto id : ids) manager.spatial->Remove(id);
+		};
+		storage.GetObservers()->OnDestroy<Transform>(drop);
+		storage.GetObservers()->OnRemove<Transform>(drop);
+	}
+
+	spatial = SpatialIndex::Create(type, cellSize);
+	return *spatial;
+}
+
+SpatialIndex* EntityManager::GetSpatialIndex()
+{
+	return spatial.get();
+}
+
+TransformBuffer& EntityManager::CreateTransformBuffer()
+{
+	if (!published) published.reset(new TransformBuffer());
+	return *published;
+}
+
+TransformBuffer* EntityManager::GetTransformBuffer()
+{
+	return published.get();
+}
+
+TransformHierarchy* EntityManager::GetHierarchy()
+{
+	return &hierarchy;
+}
+
+ComponentStorage* EntityManager::GetStorage()
+{
+	return &storage;
+}
+
+Entity* EntityManager::CreateEntity(Vec3 pos, Quat rot, Vec3 scl)
+{
+	Entity* e = new Entity(*this, pos, rot, scl);
+	AddEntity(e);
+	return e;
+}
+
+std::vector<EntityId> EntityManager::Instantiate(const Prefab& prefab, std::size_t count)
+{
+	ECS_PROFILE_SCOPE("EntityManager::Instantiate");
+
+	std::vector<Entity*> created;
+	storage.Instantiate(prefab, count, created);
+
+	std::vector<EntityId> ids;
+	ids.reserve(created.size());
+	for (Entity* e : created) {
+		e->pending = true;
+		e->listIndex = newEntities.size();
+		newEntities.emplace_back(e);
+		ids.push_back(e->GetId());
 	}
+
+	return ids;
+}
+
+EntityId EntityManager::AddEntity(Entity* e)
+{
+	e->pending = true;
+	e->listIndex = newEntities.size();
+	newEntities.emplace_back(e);
+	return e->GetId();
+}
+
+void EntityManager::EraseEntity(Entity* e)
+{
+	std::vector<EntityPtr>& list = e->pending ? newEntities : entities;
+	std::size_t index = e->listIndex;
+
+	// entities the manager does not own are left alone
+	if (index >= list.size() || list[index].get() != e) return;
+
+	// swap and pop, the entity moved into the hole takes over its index
+	std::swap(list[index], list.back());
+	list[index]->listIndex = index;
+	list.pop_back();
 }
 
 void EntityManager::EraseEntity(unsigned int index)
 {
-	entities.erase(entities.begin() + index);
+	EraseEntity(entities[index].get());
+}
+
+bool EntityManager::IsValid(EntityId id) const
+{
+	return storage.IsValid(id);
+}
+
+Entity* EntityManager::GetEntity(EntityId id) const
+{
+	return storage.GetEntity(id);
+}
+
+void EntityManager::DestroyEntity(EntityId id)
+{
+	Entity* e = storage.GetEntity(id);
+	if (e) EraseEntity(e);
 }
 
 void EntityManager::AddNewEntities()
 {
+	ECS_PROFILE_SCOPE("EntityManager::AddNewEntities");
+
 	for (auto& e : newEntities) {
-		entities.push_back(e);
+		e->pending = false;
+		e->listIndex = entities.size();
+		entities.push_back(std::move(e));
 	}
 
 	newEntities.clear();
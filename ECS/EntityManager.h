@@ -1,42 +1,126 @@
 #ifndef ENTITY_MANAGER_H
 #define ENTITY_MANAGER_H
 
+#include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "CommandBuffer.h"
 #include "Entity.h"
+#include "Prefab.h"
+#include "Scheduler.h"
+#include "SpatialIndex.h"
+#include "TransformBuffer.h"
+#include "TransformHierarchy.h"
+#include "View.h"
 
+// One world: its entities, components, systems and worker threads. Worlds share no mutable
+// state, so any number can live side by side, each updated from its own thread.
 class EntityManager {
 public:
+	// One worker per hardware thread besides the caller
 	EntityManager();
+	// 0 workers runs every system on the thread calling Update
+	explicit EntityManager(unsigned int workers);
 	~EntityManager();
 
-	static EntityManager* Get();
-	
 	void SetRunning(bool running);
 
+	// Doesn't end the profiler frame, the profiler is process wide and one host frame may update
+	// several worlds, so the host calls ECS_PROFILE_FRAME() once they are all done
 	void Update();
 	void Refresh();
 
 	void Purge();
 
-	std::vector<std::shared_ptr<Entity>>* GetEntities();
+	std::vector<EntityPtr>* GetEntities();
+	ComponentStorage* GetStorage();
 
-	void AddEntity(Entity* e);
+	// Writes every entity and component to a binary file, see WorldSnapshot
+	void SaveSnapshot(const std::string& path) const;
+	// Fills the empty world with the one saved at path, the entities join the update straight away.
+	// Every component type in the file other than Transform has to be known first, through use or RegisterComponents.
+	void LoadSnapshot(const std::string& path);
+	template<typename... Ts>
+	inline void RegisterComponents() { (storage.Register<Ts>(), ...); }
+
+	// Takes ownership of the entity, it joins the update on the next AddNewEntities
+	EntityId AddEntity(Entity* e);
+	// new Entity(*this, ...) handed straight to AddEntity
+	Entity* CreateEntity(Vec3 pos = Vec3::zero, Quat rot = Quat::identity, Vec3 scl = Vec3::one);
+	// Creates count entities with copies of the prefab's components as one batch: ids, rows and
+	// pool space are taken in bulk and the components copied a chunk at a time. Like AddEntity
+	// they join the update on the next AddNewEntities. Returns their ids in creation order.
+	std::vector<EntityId> Instantiate(const Prefab& prefab, std::size_t count);
 	void AddNewEntities();
 	void EraseEntity(Entity* e);
 	void EraseEntity(unsigned int index);
 
+	// O(1) handle lookups, stale handles are never valid even if their index was reused
+	bool IsValid(EntityId id) const;
+	Entity* GetEntity(EntityId id) const;
+	void DestroyEntity(EntityId id);
+
+	// Buffer for the calling thread, record structural changes here from inside systems
+	CommandBuffer& GetCommandBuffer();
+	// Sync point, applies every recorded command: creates first, then component changes
+	// grouped by entity, destroys last. Update calls it once the systems have finished.
+	void FlushCommands();
+
+	// Systems run by Update, in parallel where their declared reads and writes allow
+	template<typename T, typename... TArgs>
+	inline T& AddSystem(TArgs&&... args) { return scheduler.AddSystem<T>(std::forward<TArgs>(args)...); }
+	Scheduler* GetScheduler();
+	JobSystem* GetJobs();
+
+	// Component add / remove / destroy observers, dispatched in batches by Update
+	// after the frame's structural changes, or by DispatchEvents
+	Observers* GetObservers();
+	void DispatchEvents();
+
+	// Parent / child transforms, world matrices are refreshed at the end of every Update
+	TransformHierarchy* GetHierarchy();
+
+	// Starts keeping entity positions in a spatial index of the given type, replacing any earlier
+	// one. It is brought up to date at the end of every Update, after the hierarchy.
+	SpatialIndex& CreateSpatialIndex(SpatialIndexType type, double cellSize = 16.0);
+	// nullptr until CreateSpatialIndex
+	SpatialIndex* GetSpatialIndex();
+
+	// Starts publishing every Transform at the end of each Update for another thread to read,
+	// see TransformBuffer. Calling it again returns the same buffer.
+	TransformBuffer& CreateTransformBuffer();
+	// nullptr until CreateTransformBuffer
+	TransformBuffer* GetTransformBuffer();
+
+	// Query over every entity with all of Ts, see View
+	template<typename... Ts>
+	inline View<Ts...> view() { return View<Ts...>(&storage, &jobs); }
+
 private:
 	EntityManager(EntityManager& other) = delete;
 	void operator=(const EntityManager&) = delete;
-	static EntityManager* instance;
+	bool running;
+
+	// declared before the entity lists so it outlives every entity holding components in it
+	ComponentStorage storage;
+
+	std::vector<EntityPtr> newEntities;
+	std::vector<EntityPtr> entities;
 
-	static bool running;
+	std::unordered_map<std::thread::id, std::unique_ptr<CommandBuffer>> commandBuffers;
+	std::mutex commandBuffersMutex;
 
+	// jobs first, the scheduler runs on it
+	JobSystem jobs;
+	Scheduler scheduler;
 
-	std::vector<std::shared_ptr<Entity>> newEntities;
-	std::vector<std::shared_ptr<Entity>> entities;
+	TransformHierarchy hierarchy;
+	std::unique_ptr<SpatialIndex> spatial;
+	std::unique_ptr<TransformBuffer> published;
 
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,167 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <string>
+
+// Which queue the current thread owns, only meaningful while owner is this job system
+struct WorkerContext {
+	const JobSystem* owner;
+	std::size_t queue;
+};
+static thread_local WorkerContext context = { nullptr, 0 };
+
+JobSystem::JobSystem(unsigned int workers) : queued(0), stopping(false)
+{
+	for (unsigned int i = 0; i <= workers; i++)
+		queues.emplace_back(new Queue());
+
+	for (unsigned int i = 0; i < workers; i++)
+		this->workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for (auto& worker : workers) worker.join();
+}
+
+JobHandle JobSystem::CreateHandle()
+{
+	JobHandle handle;
+	handle.pending = std::make_shared<std::atomic<std::size_t>>(0);
+	return handle;
+}
+
+void JobSystem::Schedule(const JobHandle& handle, std::function<void()> job)
+{
+	handle.pending->fetch_add(1, std::memory_order_relaxed);
+
+	// workers keep their own work local, everyone else goes through the shared queue
+	std::size_t target = context.owner == this ? context.queue : queues.size() - 1;
+	{
+		std::lock_guard<std::mutex> lock(queues[target]->mutex);
+		queues[target]->jobs.push_back(Job{ std::move(job), handle.pending });
+	}
+
+	queued.fetch_add(1, std::memory_order_release);
+	if (!workers.empty()) {
+		// taking the lock orders this against a worker that is about to go to sleep
+		{ std::lock_guard<std::mutex> lock(sleepMutex); }
+		wake.notify_one();
+	}
+}
+
+JobHandle JobSystem::Schedule(std::function<void()> job)
+{
+	JobHandle handle = CreateHandle();
+	Schedule(handle, std::move(job));
+	return handle;
+}
+
+JobHandle JobSystem::ParallelFor(std::size_t count, std::size_t grain, std::function<void(std::size_t, std::size_t)> job)
+{
+	JobHandle handle = CreateHandle();
+	if (grain == 0) grain = 1;
+
+	auto shared = std::make_shared<std::function<void(std::size_t, std::size_t)>>(std::move(job));
+	for (std::size_t begin = 0; begin < count; begin += grain) {
+		std::size_t end = std::min(count, begin + grain);
+		Schedule(handle, [shared, begin, end] { (*shared)(begin, end); });
+	}
+
+	return handle;
+}
+
+void JobSystem::Wait(const JobHandle& handle)
+{
+	while (!handle.IsDone()) {
+		if (!RunOne()) std::this_thread::yield();
+	}
+}
+
+bool JobSystem::RunOne()
+{
+	Job job;
+	if (!FindJob(job)) return false;
+
+	Execute(job);
+	return true;
+}
+
+unsigned int JobSystem::WorkerCount() const
+{
+	return static_cast<unsigned int>(workers.size());
+}
+
+void JobSystem::WorkerLoop(std::size_t index)
+{
+	context = { this, index };
+	ECS_PROFILE_THREAD("Worker " + std::to_string(index));
+
+	for (;;) {
+		Job job;
+		if (FindJob(job)) {
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wake.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+		if (stopping) return;
+	}
+}
+
+bool JobSystem::TryPop(std::size_t queue, Job& job)
+{
+	Queue& q = *queues[queue];
+	std::lock_guard<std::mutex> lock(q.mutex);
+	if (q.jobs.empty()) return false;
+
+	// newest first, it's the most likely to still be in cache
+	job = std::move(q.jobs.back());
+	q.jobs.pop_back();
+	return true;
+}
+
+bool JobSystem::TrySteal(std::size_t queue, Job& job)
+{
+	Queue& q = *queues[queue];
+	std::lock_guard<std::mutex> lock(q.mutex);
+	if (q.jobs.empty()) return false;
+
+	job = std::move(q.jobs.front());
+	q.jobs.pop_front();
+	return true;
+}
+
+bool JobSystem::FindJob(Job& job)
+{
+	if (queued.load(std::memory_order_acquire) == 0) return false;
+
+	bool found = false;
+	std::size_t start = 0;
+
+	if (context.owner == this) {
+		start = context.queue + 1;
+		found = TryPop(context.queue, job);
+	}
+
+	// steal round robin starting at the queue after our own, shared queue included
+	for (std::size_t i = 0; !found && i < queues.size(); i++)
+		found = TrySteal((start + i) % queues.size(), job);
+
+	if (found) queued.fetch_sub(1, std::memory_order_relaxed);
+	return found;
+}
+
+void JobSystem::Execute(Job& job)
+{
+	job.function();
+	job.pending->fetch_sub(1, std::memory_order_acq_rel);
+}
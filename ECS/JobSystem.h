@@ -0,0 +1,84 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts the unfinished jobs scheduled against it, done once that reaches zero.
+// A default constructed handle is always done.
+class JobHandle {
+public:
+	JobHandle() {};
+
+	bool IsDone() const { return !pending || pending->load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+
+	std::shared_ptr<std::atomic<std::size_t>> pending;
+};
+
+// Work stealing job system. Every worker owns a deque, it pushes and pops its own work at the back
+// while idle workers steal from the front of the others. Jobs scheduled from outside the pool go
+// to a shared queue. Waiting on a handle runs other jobs instead of blocking the thread, so jobs
+// may schedule and wait on more jobs.
+class JobSystem {
+public:
+	JobSystem(unsigned int workers);
+	~JobSystem();
+
+	JobHandle CreateHandle();
+
+	// Adds the job to the handle, the handle is not done until the job has run
+	void Schedule(const JobHandle& handle, std::function<void()> job);
+	JobHandle Schedule(std::function<void()> job);
+
+	// Splits [0, count) into ranges of at most grain and runs job(begin, end) for each
+	JobHandle ParallelFor(std::size_t count, std::size_t grain, std::function<void(std::size_t, std::size_t)> job);
+
+	// Runs queued jobs on the calling thread until the handle is done
+	void Wait(const JobHandle& handle);
+
+	// Runs one queued job on the calling thread, false if there was nothing to run
+	bool RunOne();
+
+	unsigned int WorkerCount() const;
+
+private:
+	JobSystem(JobSystem& other) = delete;
+	void operator=(const JobSystem&) = delete;
+
+	struct Job {
+		std::function<void()> function;
+		std::shared_ptr<std::atomic<std::size_t>> pending;
+	};
+
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void WorkerLoop(std::size_t index);
+	bool TryPop(std::size_t queue, Job& job);
+	bool TrySteal(std::size_t queue, Job& job);
+	bool FindJob(Job& job);
+	void Execute(Job& job);
+
+	// one per worker, the last one takes jobs scheduled from any other thread
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+
+	std::atomic<std::size_t> queued;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	bool stopping;
+
+};
+
+#endif
@@ -0,0 +1,219 @@
+#include "Logger.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+// Set the first time a thread logs. Rings are owned by the logger, the thread only flags its
+// ring retired on exit so the logger can free it once everything in it has been written.
+struct ThreadRingOwner {
+	void* ring = nullptr;
+	std::atomic<bool>* retired = nullptr;
+
+	~ThreadRingOwner() {
+		if (retired) retired->store(true, std::memory_order_release);
+		// a later thread_local destructor that logs gets a fresh ring rather than a freed one
+		ring = nullptr;
+		retired = nullptr;
+	}
+};
+static thread_local ThreadRingOwner threadRing;
+
+static const char* LevelName(LogLevel level)
+{
+	switch (level) {
+	case LogLevel::Trace: return "trace";
+	case LogLevel::Debug: return "debug";
+	case LogLevel::Info: return "info";
+	case LogLevel::Warning: return "warning";
+	case LogLevel::Error: return "error";
+	}
+	return "";
+}
+
+Logger& Logger::Get()
+{
+	static Logger logger;
+	return logger;
+}
+
+Logger::Logger() : epoch(std::chrono::steady_clock::now()), retiredDropped(0), sink(stdout), ownsSink(false), discard(false), reportedDrops(0),
+	requested(0), drained(0), stopping(false)
+{
+	thread = std::thread(&Logger::Run, this);
+}
+
+Logger::~Logger()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+
+	if (ownsSink) std::fclose(sink);
+}
+
+Logger::Ring& Logger::ThreadRing()
+{
+	if (threadRing.ring) return *static_cast<Ring*>(threadRing.ring);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	rings.emplace_back(new Ring());
+	threadRing.ring = rings.back().get();
+	threadRing.retired = &rings.back()->retired;
+	return *rings.back();
+}
+
+bool Logger::WriteUntilArg(std::ostream& out, const char*& format)
+{
+	const char* start = format;
+	while (*format && !(format[0] == '{' && format[1] == '}')) format++;
+
+	out.write(start, format - start);
+	if (!*format) return false;
+
+	format += 2;
+	return true;
+}
+
+void Logger::Open(const std::string& path)
+{
+	std::FILE* file = std::fopen(path.c_str(), "w");
+	if (!file) throw std::runtime_error("Logger::Open, could not open " + path);
+
+	// everything logged so far still goes to the old sink
+	Flush();
+
+	std::lock_guard<std::mutex> lock(sinkMutex);
+	if (ownsSink) std::fclose(sink);
+	sink = file;
+	ownsSink = true;
+	discard = false;
+}
+
+void Logger::UseStdout()
+{
+	Flush();
+
+	std::lock_guard<std::mutex> lock(sinkMutex);
+	if (ownsSink) std::fclose(sink);
+	sink = stdout;
+	ownsSink = false;
+	discard = false;
+}
+
+void Logger::Discard()
+{
+	Flush();
+
+	std::lock_guard<std::mutex> lock(sinkMutex);
+	discard = true;
+}
+
+void Logger::Flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	const std::uint64_t ticket = ++requested;
+	wake.notify_one();
+	flushed.wait(lock, [&] { return drained >= ticket; });
+}
+
+std::uint64_t Logger::Dropped()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::uint64_t dropped = retiredDropped;
+	for (auto& ring : rings) dropped += ring->Dropped();
+	return dropped;
+}
+
+std::size_t Logger::RingCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return rings.size();
+}
+
+void Logger::Run()
+{
+	std::vector<LogRecord> batch;
+	std::string text;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		// a few times a frame is plenty, writers wake it early when a ring gets full
+		wake.wait_for(lock, std::chrono::milliseconds(5), [this] { return stopping || requested > drained; });
+
+		const bool stop = stopping;
+		const std::uint64_t ticket = requested;
+		const std::uint64_t dropped = Collect(batch, stop ? UINT64_MAX : Now());
+
+		// writers and Flush callers aren't held up by the formatting and the file
+		lock.unlock();
+		Drain(batch, dropped, text);
+		lock.lock();
+
+		drained = ticket;
+		flushed.notify_all();
+
+		if (stop) break;
+	}
+}
+
+std::uint64_t Logger::Collect(std::vector<LogRecord>& batch, std::uint64_t cutoff)
+{
+	batch.swap(held);
+
+	// rings are only added and freed under the mutex, which is held here
+	for (auto it = rings.begin(); it != rings.end();) {
+		Ring& ring = **it;
+		// read before draining, so everything the thread wrote before exiting is taken below
+		const bool retired = ring.retired.load(std::memory_order_acquire);
+		ring.Drain([&](const LogRecord& record) { batch.push_back(record); });
+
+		if (retired) {
+			retiredDropped += ring.Dropped();
+			it = rings.erase(it);
+		}
+		else ++it;
+	}
+
+	// a ring drained above may have had a record stamped before one of these added since,
+	// holding them back keeps the sink in time order
+	auto later = std::stable_partition(batch.begin(), batch.end(), [cutoff](const LogRecord& record) { return record.time < cutoff; });
+	held.assign(later, batch.end());
+	batch.erase(later, batch.end());
+
+	std::uint64_t dropped = retiredDropped;
+	for (auto& ring : rings) dropped += ring->Dropped();
+	return dropped;
+}
+
+void Logger::Drain(std::vector<LogRecord>& batch, std::uint64_t dropped, std::string& text)
+{
+	if (batch.empty() && dropped == reportedDrops) return;
+
+	// each ring is in order already, this interleaves the threads
+	std::stable_sort(batch.begin(), batch.end(), [](const LogRecord& a, const LogRecord& b) { return a.time < b.time; });
+
+	std::lock_guard<std::mutex> lock(sinkMutex);
+	if (!discard) {
+		std::ostringstream out;
+		out.precision(6);
+		for (auto& record : batch) {
+			out << '[' << std::fixed << record.time * 1e-9 << "] [" << LevelName(record.level) << "] ";
+			out.unsetf(std::ios_base::floatfield);
+			record.write(out, record.format, record.args);
+			out << '\n';
+		}
+		if (dropped != reportedDrops) out << "[logger] " << dropped - reportedDrops << " records dropped, rings were full\n";
+
+		text = out.str();
+		std::fwrite(text.data(), 1, text.size(), sink);
+		std::fflush(sink);
+	}
+
+	reportedDrops = dropped;
+	batch.clear();
+}
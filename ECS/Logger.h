@@ -0,0 +1,225 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "RingBuffer.h"
+
+enum class LogLevel : std::uint8_t {
+	Trace,
+	Debug,
+	Info,
+	Warning,
+	Error,
+};
+
+// Lowest level compiled in, 0 Trace to 4 Error, 5 strips everything.
+// Calls below it expand to nothing, their arguments aren't even evaluated.
+#ifndef ECS_LOG_LEVEL
+#ifdef NDEBUG
+#define ECS_LOG_LEVEL 2
+#else
+#define ECS_LOG_LEVEL 1
+#endif
+#endif
+
+// ECS_LOG_INFO("Killing entity {}", id) copies the arguments into the calling thread's ring,
+// the text is only built later on the logger's thread. Each {} takes the next argument.
+#define ECS_LOG(level, ...) Logger::Get().Write(level, __VA_ARGS__)
+
+#if ECS_LOG_LEVEL <= 0
+#define ECS_LOG_TRACE(...) ECS_LOG(LogLevel::Trace, __VA_ARGS__)
+#else
+#define ECS_LOG_TRACE(...) ((void)0)
+#endif
+
+#if ECS_LOG_LEVEL <= 1
+#define ECS_LOG_DEBUG(...) ECS_LOG(LogLevel::Debug, __VA_ARGS__)
+#else
+#define ECS_LOG_DEBUG(...) ((void)0)
+#endif
+
+#if ECS_LOG_LEVEL <= 2
+#define ECS_LOG_INFO(...) ECS_LOG(LogLevel::Info, __VA_ARGS__)
+#else
+#define ECS_LOG_INFO(...) ((void)0)
+#endif
+
+#if ECS_LOG_LEVEL <= 3
+#define ECS_LOG_WARNING(...) ECS_LOG(LogLevel::Warning, __VA_ARGS__)
+#else
+#define ECS_LOG_WARNING(...) ((void)0)
+#endif
+
+#if ECS_LOG_LEVEL <= 4
+#define ECS_LOG_ERROR(...) ECS_LOG(LogLevel::Error, __VA_ARGS__)
+#else
+#define ECS_LOG_ERROR(...) ((void)0)
+#endif
+
+// How an argument is stored, arrays such as string literals become pointers
+template<typename T>
+using LogArg = std::decay_t<const T&>;
+
+// A log call waiting to be formatted, its arguments packed as bytes
+struct LogRecord {
+	static constexpr std::size_t argsCapacity = 96;
+
+	std::uint64_t time;
+	// must outlive the logger, the macros only take string literals in practice
+	const char* format;
+	// knows the argument types, formats the record onto out
+	void (*write)(std::ostream& out, const char* format, const unsigned char* args);
+	LogLevel level;
+	alignas(16) unsigned char args[argsCapacity];
+};
+
+// Process wide asynchronous logger. Write only copies the record into a ring owned by the
+// calling thread, a background thread drains every ring, formats the records in time order
+// and writes them to the sink, stdout until Open is called.
+// A full ring drops records instead of stalling the thread, the sink notes how many.
+class Logger {
+public:
+	static Logger& Get();
+	~Logger();
+
+	// Arguments are copied as bytes, so they have to be trivially copyable: numbers, EntityId,
+	// Vec3, Quat, pointers. char pointers are printed as text and must outlive the write,
+	// only pass string literals.
+	template<typename... Ts>
+	inline void Write(LogLevel level, const char* format, const Ts&... args);
+
+	// Sends everything from now on to the file at path, throws std::runtime_error if it can't be opened
+	void Open(const std::string& path);
+	// Back to stdout
+	void UseStdout();
+	// Records are still taken off the rings but thrown away
+	void Discard();
+
+	// Blocks until everything written before the call is in the sink
+	void Flush();
+
+	std::uint64_t Dropped();
+	// Rings still allocated, one per thread that has logged, until the logger has drained the ring of a thread that exited
+	std::size_t RingCount();
+
+private:
+	Logger();
+	Logger(Logger& other) = delete;
+	void operator=(const Logger&) = delete;
+
+	// retired is set when the owning thread exits, the logger frees the ring once it is drained
+	struct Ring : RingBuffer<LogRecord, 4096> {
+		std::atomic<bool> retired{ false };
+	};
+
+	template<typename T>
+	static constexpr std::size_t AlignUp(std::size_t offset) { return (offset + alignof(T) - 1) / alignof(T) * alignof(T); }
+
+	template<typename... Ts>
+	static constexpr std::size_t PackedSize() {
+		std::size_t offset = 0;
+		((offset = AlignUp<Ts>(offset) + sizeof(Ts)), ...);
+		return offset;
+	}
+
+	template<typename T>
+	static void WriteArg(std::ostream& out, const char*& format, const unsigned char* args, std::size_t& offset);
+	template<typename... Ts>
+	static void WriteRecord(std::ostream& out, const char* format, const unsigned char* args);
+	// Copies format up to the next {} or its end, returns false at the end
+	static bool WriteUntilArg(std::ostream& out, const char*& format);
+
+	// nanoseconds since the logger started, what records are stamped with
+	std::uint64_t Now() const { return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count()); }
+	Ring& ThreadRing();
+	void Run();
+	// Moves everything in the rings stamped before cutoff into batch and returns the total drop count,
+	// needs the mutex. Later records wait in held for the next call.
+	std::uint64_t Collect(std::vector<LogRecord>& batch, std::uint64_t cutoff);
+	// Formats batch into the sink, called by the logger thread without the mutex
+	void Drain(std::vector<LogRecord>& batch, std::uint64_t dropped, std::string& text);
+
+	const std::chrono::steady_clock::time_point epoch;
+
+	// guards rings and the flush counters, never held while writing to the sink
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable flushed;
+	std::vector<std::unique_ptr<Ring>> rings;
+	// drops counted by rings that have been freed
+	std::uint64_t retiredDropped;
+
+	// guards the sink, held for a whole write so swapping sinks never closes one mid write
+	std::mutex sinkMutex;
+	std::FILE* sink;
+	bool ownsSink;
+	bool discard;
+	// only touched by the logger thread
+	std::uint64_t reportedDrops;
+	std::vector<LogRecord> held;
+
+	// Flush asks for a drain and waits for drained to catch up with requested
+	std::uint64_t requested;
+	std::uint64_t drained;
+	bool stopping;
+	std::thread thread;
+
+};
+
+template<typename... Ts>
+inline void Logger::Write(LogLevel level, const char* format, const Ts&... args)
+{
+	static_assert((std::is_trivially_copyable<LogArg<Ts>>::value && ...), "Log arguments are copied as bytes and must be trivially copyable");
+	static_assert(PackedSize<LogArg<Ts>...>() <= LogRecord::argsCapacity, "Too many or too large log arguments");
+
+	const std::uint64_t time = Now();
+
+	Ring& ring = ThreadRing();
+	ring.Emplace([&](LogRecord& record) {
+		record.time = time;
+		record.format = format;
+		record.write = &WriteRecord<LogArg<Ts>...>;
+		record.level = level;
+
+		std::size_t offset = 0;
+		((offset = AlignUp<LogArg<Ts>>(offset), std::memcpy(record.args + offset, &static_cast<const LogArg<Ts>&>(args), sizeof(LogArg<Ts>)), offset += sizeof(LogArg<Ts>)), ...);
+	});
+
+	// the logger thread also wakes on its own, this only keeps busy rings from filling up
+	if (ring.Size() > Ring::capacity / 2) wake.notify_one();
+}
+
+template<typename T>
+inline void Logger::WriteArg(std::ostream& out, const char*& format, const unsigned char* args, std::size_t& offset)
+{
+	offset = AlignUp<T>(offset);
+	alignas(T) unsigned char value[sizeof(T)];
+	std::memcpy(value, args + offset, sizeof(T));
+	offset += sizeof(T);
+
+	// arguments without a {} left are dropped
+	if (WriteUntilArg(out, format)) out << *reinterpret_cast<const T*>(value);
+}
+
+template<typename... Ts>
+inline void Logger::WriteRecord(std::ostream& out, const char* format, const unsigned char* args)
+{
+	std::size_t offset = 0;
+	(WriteArg<Ts>(out, format, args, offset), ...);
+	while (WriteUntilArg(out, format)) out << "{}";
+}
+
+#endif
@@ -0,0 +1,84 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) : data(nullptr), size(0), file(INVALID_HANDLE_VALUE), mapping(nullptr)
+{
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("MappedFile, can't open " + path);
+
+	LARGE_INTEGER length;
+	if (!GetFileSizeEx(file, &length)) {
+		CloseHandle(file);
+		throw std::runtime_error("MappedFile, can't read the size of " + path);
+	}
+	size = static_cast<std::size_t>(length.QuadPart);
+
+	// an empty file can't be mapped, it just has no data
+	if (size == 0) return;
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping) data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (data == nullptr) {
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		throw std::runtime_error("MappedFile, can't map " + path);
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (data) UnmapViewOfFile(data);
+	if (mapping) CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) : data(nullptr), size(0), file(-1)
+{
+	file = open(path.c_str(), O_RDONLY);
+	if (file < 0) throw std::runtime_error("MappedFile, can't open " + path);
+
+	struct stat info;
+	if (fstat(file, &info) != 0) {
+		close(file);
+		throw std::runtime_error("MappedFile, can't read the size of " + path);
+	}
+	size = static_cast<std::size_t>(info.st_size);
+
+	// an empty file can't be mapped, it just has no data
+	if (size == 0) return;
+
+	void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	if (mapped == MAP_FAILED) {
+		close(file);
+		throw std::runtime_error("MappedFile, can't map " + path);
+	}
+
+	// read front to back, let the kernel read ahead
+	madvise(mapped, size, MADV_SEQUENTIAL);
+	data = static_cast<const unsigned char*>(mapped);
+}
+
+MappedFile::~MappedFile()
+{
+	if (data) munmap(const_cast<unsigned char*>(data), size);
+	if (file >= 0) close(file);
+}
+
+#endif
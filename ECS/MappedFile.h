@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read only view of a whole file mapped into memory, pages are only read in as they are touched.
+// The mapping starts on a page boundary. Throws std::runtime_error if the file can't be mapped.
+class MappedFile {
+public:
+	MappedFile(const std::string& path);
+	~MappedFile();
+
+	const unsigned char* Data() const { return data; }
+	std::size_t Size() const { return size; }
+
+private:
+	MappedFile(MappedFile& other) = delete;
+	void operator=(const MappedFile&) = delete;
+
+	const unsigned char* data;
+	std::size_t size;
+
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#else
+	int file;
+#endif
+
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "Observers.h"
+
+Observers::Observers() : pending(false)
+{
+}
+
+void Observers::Observe(ObserverEvent event, TypeID type, Callback callback)
+{
+	callbacks[Index(event)][type].push_back(std::move(callback));
+	observed[Index(event)].set(type);
+}
+
+void Observers::Clear(ObserverEvent event, TypeID type)
+{
+	callbacks[Index(event)][type].clear();
+	queues[Index(event)][type].clear();
+	observed[Index(event)].reset(type);
+}
+
+void Observers::Dispatch(EntityManager& manager)
+{
+	while (pending) {
+		pending = false;
+
+		// the whole round is taken first, events raised by the observers below queue up again for the next one
+		Signature types[eventCount];
+		for (std::size_t event = 0; event < eventCount; event++) {
+			types[event] = queued[event];
+			queued[event].reset();
+			forEachComponentId(types[event], [&](TypeID type) { batches[event][type].swap(queues[event][type]); });
+		}
+
+		for (std::size_t event = 0; event < eventCount; event++) {
+			forEachComponentId(types[event], [&](TypeID type) {
+				std::vector<EntityId>& batch = batches[event][type];
+				if (batch.empty()) return;
+
+				for (auto& callback : callbacks[event][type]) callback(manager, batch);
+				batch.clear();
+			});
+		}
+	}
+}
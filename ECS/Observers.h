@@ -0,0 +1,80 @@
+#ifndef OBSERVERS_H
+#define OBSERVERS_H
+
+#include <functional>
+#include <vector>
+
+#include "ECS.h"
+#include "EntityId.h"
+
+class EntityManager;
+
+// What happened to a component, an observer is registered for one kind on one type
+enum class ObserverEvent {
+	// the component was added to an entity that didn't have one
+	Add,
+	// the component was removed from an entity that is still alive
+	Remove,
+	// an entity with the component was destroyed, only its id is left by the time it is dispatched
+	Destroy
+};
+
+// Callbacks for components appearing and disappearing.
+// Structural changes only record the entity in a queue per event and type, nothing is called
+// while they happen. Dispatch hands every queue to its observers as one batch, Add batches
+// first, then Remove, then Destroy. EntityManager::Update dispatches once the frame's
+// structural changes are done. Types nobody observes are never queued.
+// Batches are in the order the changes were made and are not filtered, an id in an Add batch
+// may have lost the component or been destroyed again before the batch went out.
+class Observers {
+public:
+	using Callback = std::function<void(EntityManager& manager, const std::vector<EntityId>& entities)>;
+
+	Observers();
+
+	template<typename T>
+	inline void OnAdd(Callback callback) { Observe(ObserverEvent::Add, getCompTypeID<T>(), std::move(callback)); }
+	template<typename T>
+	inline void OnRemove(Callback callback) { Observe(ObserverEvent::Remove, getCompTypeID<T>(), std::move(callback)); }
+	template<typename T>
+	inline void OnDestroy(Callback callback) { Observe(ObserverEvent::Destroy, getCompTypeID<T>(), std::move(callback)); }
+
+	void Observe(ObserverEvent event, TypeID type, Callback callback);
+	// Drops every observer of the event on the type
+	void Clear(ObserverEvent event, TypeID type);
+
+	// Types with at least one observer for the event
+	inline const Signature& Observed(ObserverEvent event) const { return observed[Index(event)]; }
+
+	inline void Record(ObserverEvent event, TypeID type, EntityId id) {
+		if (!observed[Index(event)].test(type)) return;
+
+		queues[Index(event)][type].push_back(id);
+		queued[Index(event)].set(type);
+		pending = true;
+	}
+
+	bool Pending() const { return pending; }
+
+	// Hands every queued batch to its observers. Observers may make structural changes,
+	// the events those raise are dispatched in further rounds until nothing is left.
+	// Observers must not be registered or cleared from inside an observer.
+	void Dispatch(EntityManager& manager);
+
+private:
+	static constexpr std::size_t eventCount = 3;
+	static inline std::size_t Index(ObserverEvent event) { return static_cast<std::size_t>(event); }
+
+	Signature observed[eventCount];
+	// types with something in their queue, so Dispatch only visits those
+	Signature queued[eventCount];
+	std::vector<Callback> callbacks[eventCount][ECS_MAX_COMPONENTS];
+	std::vector<EntityId> queues[eventCount][ECS_MAX_COMPONENTS];
+	bool pending;
+
+	// the round being dispatched, swapped out of the queues so observers can queue new events meanwhile
+	std::vector<EntityId> batches[eventCount][ECS_MAX_COMPONENTS];
+
+};
+
+#endif
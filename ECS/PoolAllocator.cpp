@@ -0,0 +1,100 @@
+#include "PoolAllocator.h"
+
+#include <algorithm>
+#include <new>
+
+static std::size_t AlignUp(std::size_t value, std::size_t align)
+{
+	return (value + align - 1) & ~(align - 1);
+}
+
+PoolAllocator::PoolAllocator(std::size_t blockSize, std::size_t blockAlign, std::size_t blocksPerSlab)
+	: blockSize(AlignUp(std::max(blockSize, sizeof(FreeBlock)), blockAlign)), blockAlign(blockAlign), blocksPerSlab(std::max<std::size_t>(1, blocksPerSlab)),
+	cursor(nullptr), slabEnd(nullptr), freeList(nullptr)
+{
+}
+
+PoolAllocator::~PoolAllocator()
+{
+	for (auto slab : slabs)
+		::operator delete(slab, std::align_val_t(blockAlign));
+}
+
+void* PoolAllocator::Allocate()
+{
+	if (freeList) {
+		FreeBlock* block = freeList;
+		freeList = block->next;
+		return block;
+	}
+
+	if (cursor == slabEnd) {
+		unsigned char* slab = static_cast<unsigned char*>(::operator new(blockSize * blocksPerSlab, std::align_val_t(blockAlign)));
+		slabs.push_back(slab);
+		cursor = slab;
+		slabEnd = slab + blockSize * blocksPerSlab;
+	}
+
+	void* block = cursor;
+	cursor += blockSize;
+	return block;
+}
+
+void PoolAllocator::Free(void* block)
+{
+	FreeBlock* freed = static_cast<FreeBlock*>(block);
+	freed->next = freeList;
+	freeList = freed;
+}
+
+FrameArena::FrameArena(std::size_t blockSize) : blockSize(blockSize), offset(0), used(0)
+{
+}
+
+FrameArena::~FrameArena()
+{
+	for (auto& block : blocks)
+		::operator delete(block.data);
+}
+
+void* FrameArena::Allocate(std::size_t size, std::size_t align)
+{
+	if (blocks.empty()) AddBlock(size + align);
+
+	// pad from the real address, operator new only guarantees the default alignment
+	std::size_t base = reinterpret_cast<std::size_t>(blocks.back().data);
+	std::size_t start = AlignUp(base + offset, align) - base;
+
+	if (start + size > blocks.back().size) {
+		AddBlock(size + align);
+		base = reinterpret_cast<std::size_t>(blocks.back().data);
+		start = AlignUp(base, align) - base;
+	}
+
+	offset = start + size;
+	used += size;
+	return blocks.back().data + start;
+}
+
+void FrameArena::Reset()
+{
+	if (blocks.size() > 1) {
+		std::size_t total = 0;
+		for (auto& block : blocks) {
+			total += block.size;
+			::operator delete(block.data);
+		}
+		blocks.clear();
+		AddBlock(total);
+	}
+
+	offset = 0;
+	used = 0;
+}
+
+void FrameArena::AddBlock(std::size_t minSize)
+{
+	std::size_t size = std::max(blockSize, minSize);
+	blocks.push_back(Block{ static_cast<unsigned char*>(::operator new(size)), size });
+	offset = 0;
+}
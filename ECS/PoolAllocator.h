@@ -0,0 +1,94 @@
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <cstddef>
+#include <vector>
+
+// Hands out fixed size blocks carved from large slabs.
+// Allocating pops the free list or bumps through the current slab, freeing pushes onto the free list.
+// Memory only goes back to the system when the pool is destroyed. Not thread safe.
+class PoolAllocator {
+public:
+	PoolAllocator(std::size_t blockSize, std::size_t blockAlign, std::size_t blocksPerSlab);
+	~PoolAllocator();
+
+	void* Allocate();
+	void Free(void* block);
+
+	std::size_t BlockSize() const { return blockSize; }
+
+private:
+	PoolAllocator(PoolAllocator& other) = delete;
+	void operator=(const PoolAllocator&) = delete;
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	std::size_t blockSize;
+	std::size_t blockAlign;
+	std::size_t blocksPerSlab;
+
+	std::vector<unsigned char*> slabs;
+	// next unused block in the newest slab
+	unsigned char* cursor;
+	unsigned char* slabEnd;
+	FreeBlock* freeList;
+
+};
+
+// Linear allocator for data that only lives for one frame.
+// Allocating bumps a pointer, nothing is freed on its own, Reset drops everything at once.
+// Destructors are not run, the owner has to destroy non trivial objects before Reset. Not thread safe.
+class FrameArena {
+public:
+	FrameArena(std::size_t blockSize);
+	~FrameArena();
+
+	void* Allocate(std::size_t size, std::size_t align);
+
+	// Frees every allocation, blocks are merged so the next frame fits in one
+	void Reset();
+
+	std::size_t Used() const { return used; }
+
+private:
+	FrameArena(FrameArena& other) = delete;
+	void operator=(const FrameArena&) = delete;
+
+	struct Block {
+		unsigned char* data;
+		std::size_t size;
+	};
+
+	void AddBlock(std::size_t minSize);
+
+	std::size_t blockSize;
+	std::vector<Block> blocks;
+	std::size_t offset;
+	std::size_t used;
+
+};
+
+// std allocator that draws from a FrameArena, deallocate does nothing
+template<typename T>
+class ArenaAllocator {
+public:
+	using value_type = T;
+
+	ArenaAllocator(FrameArena* arena) : arena(arena) {};
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {};
+
+	T* allocate(std::size_t n) { return static_cast<T*>(arena->Allocate(n * sizeof(T), alignof(T))); }
+	void deallocate(T*, std::size_t) {}
+
+	template<typename U>
+	bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+	template<typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+	FrameArena* arena;
+};
+
+#endif
@@ -0,0 +1,19 @@
+#include "Prefab.h"
+
+Prefab::Prefab()
+{
+	add<Transform>();
+}
+
+Prefab::Prefab(Vec3 pos, Quat rot, Vec3 scl)
+{
+	add<Transform>(pos, rot, scl);
+}
+
+Prefab::Entry* Prefab::Find(TypeID id) const
+{
+	// a handful of entries, a linear search beats anything fancier
+	for (auto& entry : entries)
+		if (entry.info->id == id) return const_cast<Entry*>(&entry);
+	return nullptr;
+}
@@ -0,0 +1,127 @@
+#ifndef PREFAB_H
+#define PREFAB_H
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "ComponentStorage.h"
+#include "Transform.h"
+
+// A set of components with default values, captured once and stamped out many times by
+// EntityManager::Instantiate. Like a new entity a prefab starts with a Transform.
+// Instances get copies of the prototypes held here, so every type added must be copy constructible.
+// Prefabs don't belong to any world, one can be instantiated into several.
+class Prefab {
+public:
+	Prefab();
+	Prefab(Vec3 pos, Quat rot, Vec3 scl);
+
+	// Makes T built from args the default, replacing any earlier T, and returns the prototype.
+	// Changes made to it show up in later instances. Throws std::logic_error if its init fails.
+	template<typename T, typename... TArgs>
+	inline T& add(TArgs&&... args);
+
+	template<typename T>
+	inline T& get() const;
+
+	template<typename T>
+	inline void remove();
+
+	template<typename T>
+	inline bool has() const { return signature.test(getCompTypeID<T>()); }
+
+	const Signature& GetSignature() const { return signature; }
+
+	struct Entry {
+		const ComponentInfo* info;
+		std::unique_ptr<Component> prototype;
+		// table components, copy constructs count prototypes into uninitialised dst
+		void (*fillRows)(void* dst, const Component& prototype, std::size_t count, Entity* const* entities);
+		// sparse set and transient components, adds count prototypes to the type's pool
+		void (*fillPool)(ComponentStorage& storage, const Component& prototype, const std::uint32_t* indices, std::size_t count, Entity* const* entities);
+	};
+	const std::vector<Entry>& GetEntries() const { return entries; }
+
+private:
+	Prefab(const Prefab&) = delete;
+	void operator=(const Prefab&) = delete;
+
+	template<typename T>
+	static void FillRows(void* dst, const Component& prototype, std::size_t count, Entity* const* entities);
+	template<typename T>
+	static void FillPool(ComponentStorage& storage, const Component& prototype, const std::uint32_t* indices, std::size_t count, Entity* const* entities);
+
+	Entry* Find(TypeID id) const;
+
+	std::vector<Entry> entries;
+	Signature signature;
+
+};
+
+template<typename T, typename... TArgs>
+inline T& Prefab::add(TArgs&&... args)
+{
+	static_assert(std::is_copy_constructible<T>::value, "Prefab components are copied into every instance and must be copy constructible");
+
+	std::unique_ptr<T> comp(new T(std::forward<TArgs>(args)...));
+	if (!comp->init()) throw std::logic_error(std::string("Prefab::add, ") + ComponentTypeID<T>::name + " failed to init");
+
+	comp->id = getCompTypeID<T>();
+	comp->entity = nullptr;
+
+	T& prototype = *comp;
+	Entry* entry = Find(comp->id);
+	if (entry) entry->prototype = std::move(comp);
+	else {
+		if constexpr (T::storagePolicy == StoragePolicy::Table)
+			entries.push_back(Entry{ ComponentInfo::Of<T>(), std::move(comp), &FillRows<T>, nullptr });
+		else
+			entries.push_back(Entry{ ComponentInfo::Of<T>(), std::move(comp), nullptr, &FillPool<T> });
+		signature.set(getCompTypeID<T>());
+	}
+
+	return prototype;
+}
+
+template<typename T>
+inline T& Prefab::get() const
+{
+	Entry* entry = Find(getCompTypeID<T>());
+	if (!entry) throw std::out_of_range("Prefab::get, component not in prefab");
+
+	return static_cast<T&>(*entry->prototype);
+}
+
+template<typename T>
+inline void Prefab::remove()
+{
+	Entry* entry = Find(getCompTypeID<T>());
+	if (!entry) return;
+
+	std::swap(*entry, entries.back());
+	entries.pop_back();
+	signature.reset(getCompTypeID<T>());
+}
+
+template<typename T>
+inline void Prefab::FillRows(void* dst, const Component& prototype, std::size_t count, Entity* const* entities)
+{
+	T* to = static_cast<T*>(dst);
+	const T& from = static_cast<const T&>(prototype);
+	for (std::size_t i = 0; i < count; i++) {
+		T* comp = new (to + i) T(from);
+		comp->entity = entities[i];
+	}
+}
+
+template<typename T>
+inline void Prefab::FillPool(ComponentStorage& storage, const Component& prototype, const std::uint32_t* indices, std::size_t count, Entity* const* entities)
+{
+	storage.GetPool<T>().Fill(indices, static_cast<const T&>(prototype), count, entities, storage.GetTick());
+}
+
+#endif
@@ -0,0 +1,265 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+// Set the first time a thread records. Rings are owned by the profiler, the thread only flags
+// its ring retired on exit so EndFrame can free it once its events are in.
+struct ProfileRingOwner {
+	ProfileRing* ring = nullptr;
+
+	~ProfileRingOwner() {
+		if (ring) ring->retired.store(true, std::memory_order_release);
+		// a later thread_local destructor that records gets a fresh ring rather than a freed one
+		ring = nullptr;
+	}
+};
+static thread_local ProfileRingOwner threadRing;
+
+static void WriteJsonString(std::ostream& out, const char* s)
+{
+	out << '"';
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\') out << '\\';
+		out << *s;
+	}
+	out << '"';
+}
+
+Profiler& Profiler::Get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Profiler() : epoch(std::chrono::steady_clock::now()), nextThread(0), retiredDropped(0), window(240), frameCount(0), maxTraceEvents(0), capturing(false)
+{
+}
+
+ProfileRing& Profiler::ThreadRing()
+{
+	if (threadRing.ring) return *threadRing.ring;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	rings.emplace_back(new ProfileRing(nextThread++));
+	threadRing.ring = rings.back().get();
+	return *threadRing.ring;
+}
+
+void Profiler::Record(const char* name, std::uint64_t start, std::uint64_t end)
+{
+	ThreadRing().events.Push({ name, start, end });
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+	ProfileRing& ring = ThreadRing();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	ring.name = name;
+}
+
+Profiler::Series& Profiler::SeriesOf(const char* name)
+{
+	auto known = byPointer.find(name);
+	if (known != byPointer.end()) return *known->second;
+
+	// same text behind another pointer, e.g. the same literal in two translation units
+	Series*& named = byName[name];
+	if (!named) {
+		series.emplace_back(new Series{ name, std::vector<Sample>(window), 0, 0, 0, 0 });
+		named = series.back().get();
+	}
+
+	byPointer[name] = named;
+	return *named;
+}
+
+void Profiler::EndFrame()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (auto it = rings.begin(); it != rings.end();) {
+		ProfileRing& ring = **it;
+		const std::uint32_t thread = ring.thread;
+		// read before draining, so everything the thread recorded before exiting is taken below
+		const bool retired = ring.retired.load(std::memory_order_acquire);
+		ring.events.Drain([&](const ProfileEvent& event) {
+			Series& s = SeriesOf(event.name);
+			if (s.frameCalls == 0) touched.push_back(&s);
+			s.frameDuration += event.end - event.start;
+			s.frameCalls++;
+
+			if (capturing && trace.size() < maxTraceEvents) trace.push_back({ event, thread });
+		});
+
+		if (retired) {
+			retiredDropped += ring.events.Dropped();
+			if (!ring.name.empty() && !trace.empty()) retiredNames.emplace_back(thread, std::move(ring.name));
+			it = rings.erase(it);
+		}
+		else ++it;
+	}
+
+	// scopes that didn't run this frame keep their samples as they are
+	for (Series* s : touched) {
+		s->samples[s->next] = { s->frameDuration, s->frameCalls };
+		s->next = (s->next + 1) % window;
+		s->count = std::min(s->count + 1, window);
+		s->frameDuration = 0;
+		s->frameCalls = 0;
+	}
+	touched.clear();
+
+	frameCount++;
+}
+
+void Profiler::SetWindow(std::size_t frames)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	window = std::max<std::size_t>(1, frames);
+	for (auto& s : series) {
+		s->samples.assign(window, Sample{ 0, 0 });
+		s->next = 0;
+		s->count = 0;
+	}
+}
+
+std::vector<ProfileStats> Profiler::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::vector<ProfileStats> stats;
+	std::vector<std::uint64_t> durations;
+	for (auto& s : series) {
+		if (s->count == 0) continue;
+
+		durations.clear();
+		std::uint64_t total = 0;
+		std::uint64_t calls = 0;
+		for (std::size_t i = 0; i < s->count; i++) {
+			durations.push_back(s->samples[i].duration);
+			total += s->samples[i].duration;
+			calls += s->samples[i].calls;
+		}
+		std::sort(durations.begin(), durations.end());
+
+		// nearest rank
+		const std::size_t p99 = (durations.size() * 99 + 99) / 100 - 1;
+		const double toMs = 1e-6;
+
+		ProfileStats st;
+		st.name = s->name;
+		st.frames = s->count;
+		st.min = durations.front() * toMs;
+		st.avg = static_cast<double>(total) / s->count * toMs;
+		st.p99 = durations[p99] * toMs;
+		st.max = durations.back() * toMs;
+		st.callsPerFrame = static_cast<double>(calls) / s->count;
+		stats.push_back(st);
+	}
+
+	return stats;
+}
+
+void Profiler::PrintStats(std::ostream& out)
+{
+	std::vector<ProfileStats> stats = GetStats();
+	std::sort(stats.begin(), stats.end(), [](const ProfileStats& a, const ProfileStats& b) { return a.avg > b.avg; });
+
+	const std::ios_base::fmtflags flags = out.flags();
+	const std::streamsize precision = out.precision();
+
+	out << std::left << std::setw(32) << "scope" << std::right
+		<< std::setw(10) << "min ms" << std::setw(10) << "avg ms" << std::setw(10) << "p99 ms" << std::setw(10) << "max ms"
+		<< std::setw(10) << "calls" << std::setw(8) << "frames" << '\n';
+	out << std::fixed << std::setprecision(3);
+	for (auto& st : stats) {
+		out << std::left << std::setw(32) << st.name << std::right
+			<< std::setw(10) << st.min << std::setw(10) << st.avg << std::setw(10) << st.p99 << std::setw(10) << st.max
+			<< std::setw(10) << st.callsPerFrame << std::setw(8) << st.frames << '\n';
+	}
+
+	out.flags(flags);
+	out.precision(precision);
+}
+
+void Profiler::StartCapture(std::size_t maxEvents)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	trace.clear();
+	retiredNames.clear();
+	maxTraceEvents = maxEvents;
+	capturing = true;
+}
+
+void Profiler::StopCapture()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	capturing = false;
+}
+
+void Profiler::WriteTrace(const std::string& path)
+{
+	std::ofstream out(path, std::ios::binary);
+	if (!out) throw std::runtime_error("Profiler::WriteTrace, could not open " + path);
+
+	WriteTrace(out);
+	if (!out) throw std::runtime_error("Profiler::WriteTrace, could not write " + path);
+}
+
+void Profiler::WriteTrace(std::ostream& out)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	const std::ios_base::fmtflags flags = out.flags();
+	const std::streamsize precision = out.precision();
+	// microseconds with nanosecond digits
+	out << std::fixed << std::setprecision(3);
+
+	out << "{\"traceEvents\":[";
+	bool first = true;
+
+	for (auto& ring : rings) {
+		if (ring->name.empty()) continue;
+
+		out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->thread << ",\"args\":{\"name\":";
+		WriteJsonString(out, ring->name.c_str());
+		out << "}}";
+		first = false;
+	}
+	for (auto& named : retiredNames) {
+		out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << named.first << ",\"args\":{\"name\":";
+		WriteJsonString(out, named.second.c_str());
+		out << "}}";
+		first = false;
+	}
+
+	// complete events, ts and dur in microseconds
+	for (auto& t : trace) {
+		out << (first ? "\n" : ",\n") << "{\"name\":";
+		WriteJsonString(out, t.event.name);
+		out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << t.thread
+			<< ",\"ts\":" << t.event.start / 1000.0
+			<< ",\"dur\":" << (t.event.end - t.event.start) / 1000.0 << "}";
+		first = false;
+	}
+
+	out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	out.flags(flags);
+	out.precision(precision);
+}
+
+std::uint64_t Profiler::Dropped()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::uint64_t dropped = retiredDropped;
+	for (auto& ring : rings) dropped += ring->events.Dropped();
+	return dropped;
+}
@@ -0,0 +1,174 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "RingBuffer.h"
+
+// Instrumentation, only compiled in when ECS_PROFILE is defined (the ECS_PROFILE CMake option).
+// Without it every macro expands to nothing and nothing is timed.
+//   ECS_PROFILE_SCOPE("Name")  times the rest of the enclosing block, the name must be a string
+//                              literal or otherwise outlive the profiler
+//   ECS_PROFILE_FRAME()        ends the frame, the host calls it once per frame after updating
+//                              every world
+//   ECS_PROFILE_THREAD("Name") names the calling thread in traces
+#ifdef ECS_PROFILE
+#define ECS_PROFILE_CONCAT_INNER(a, b) a##b
+#define ECS_PROFILE_CONCAT(a, b) ECS_PROFILE_CONCAT_INNER(a, b)
+#define ECS_PROFILE_SCOPE(name) ProfileScope ECS_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define ECS_PROFILE_FRAME() Profiler::Get().EndFrame()
+#define ECS_PROFILE_THREAD(name) Profiler::Get().SetThreadName(name)
+#else
+#define ECS_PROFILE_SCOPE(name)
+#define ECS_PROFILE_FRAME()
+#define ECS_PROFILE_THREAD(name)
+#endif
+
+// One finished scope, times in nanoseconds since the profiler started
+struct ProfileEvent {
+	const char* name;
+	std::uint64_t start;
+	std::uint64_t end;
+};
+
+// Events of one thread, it pushes and EndFrame drains. Events that don't fit are dropped
+// and counted rather than blocking the thread. retired is set when the thread exits, the
+// next EndFrame drains the ring one last time and frees it.
+struct ProfileRing {
+	ProfileRing(std::uint32_t thread) : thread(thread) {};
+
+	const std::uint32_t thread;
+	std::string name;
+	RingBuffer<ProfileEvent, 8192> events;
+	std::atomic<bool> retired{ false };
+};
+
+// Per scope figures over the last Window frames a scope ran in, times in milliseconds.
+// A scope entered several times in a frame counts the sum of them.
+struct ProfileStats {
+	std::string name;
+	std::size_t frames;
+	double min;
+	double avg;
+	double p99;
+	double max;
+	double callsPerFrame;
+};
+
+// Collects the scopes of every thread. Recording only touches the calling thread's ring,
+// EndFrame drains all of them into the rolling statistics and, while capturing, into a
+// trace that WriteTrace saves as Chrome trace_event JSON (chrome://tracing, Perfetto).
+class Profiler {
+public:
+	static Profiler& Get();
+
+	// Nanoseconds since the profiler started
+	inline std::uint64_t Now() const {
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+	}
+
+	void Record(const char* name, std::uint64_t start, std::uint64_t end);
+	void SetThreadName(const std::string& name);
+
+	void EndFrame();
+	std::uint64_t FrameCount() const { return frameCount; }
+
+	// Frames the statistics look back over, changing it drops the samples so far
+	void SetWindow(std::size_t frames);
+	std::size_t GetWindow() const { return window; }
+	std::vector<ProfileStats> GetStats();
+	// Stats as a table, slowest average first
+	void PrintStats(std::ostream& out);
+
+	// Keeps every event from the next EndFrame on until StopCapture or maxEvents are held
+	void StartCapture(std::size_t maxEvents = 1 << 20);
+	void StopCapture();
+	// Writes the captured events, throws std::runtime_error if the file can't be written
+	void WriteTrace(const std::string& path);
+	void WriteTrace(std::ostream& out);
+
+	// Events lost to full rings, EndFrame has to be called often enough to keep up
+	std::uint64_t Dropped();
+
+private:
+	Profiler();
+	Profiler(Profiler& other) = delete;
+	void operator=(const Profiler&) = delete;
+
+	struct Sample {
+		std::uint64_t duration;
+		std::uint32_t calls;
+	};
+
+	struct Series {
+		std::string name;
+		// ring of the last window samples
+		std::vector<Sample> samples;
+		std::size_t next;
+		std::size_t count;
+		// this frame so far
+		std::uint64_t frameDuration;
+		std::uint32_t frameCalls;
+	};
+
+	struct TraceEvent {
+		ProfileEvent event;
+		std::uint32_t thread;
+	};
+
+	ProfileRing& ThreadRing();
+	Series& SeriesOf(const char* name);
+
+	const std::chrono::steady_clock::time_point epoch;
+
+	// guards rings, series and the trace, never taken by Record once the thread has its ring
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ProfileRing>> rings;
+	// trace thread ids are never reused, so events of a freed ring can't be mistaken for a newer one's
+	std::uint32_t nextThread;
+	// drops counted by rings that have been freed
+	std::uint64_t retiredDropped;
+	// names of freed rings whose events may be in the trace, until the next StartCapture
+	std::vector<std::pair<std::uint32_t, std::string>> retiredNames;
+
+	std::vector<std::unique_ptr<Series>> series;
+	// names are usually literals, the pointer is looked up first and the text only the first time
+	std::unordered_map<const char*, Series*> byPointer;
+	std::unordered_map<std::string, Series*> byName;
+	std::vector<Series*> touched;
+	std::size_t window;
+	std::uint64_t frameCount;
+
+	std::vector<TraceEvent> trace;
+	std::size_t maxTraceEvents;
+	bool capturing;
+
+};
+
+// Times its own lifetime, see ECS_PROFILE_SCOPE
+class ProfileScope {
+public:
+	inline explicit ProfileScope(const char* name) : name(name), start(Profiler::Get().Now()) {}
+	inline ~ProfileScope() {
+		Profiler& profiler = Profiler::Get();
+		profiler.Record(name, start, profiler.Now());
+	}
+
+private:
+	ProfileScope(const ProfileScope&) = delete;
+	void operator=(const ProfileScope&) = delete;
+
+	const char* name;
+	std::uint64_t start;
+};
+
+#endif
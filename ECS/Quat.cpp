@@ -1,329 +1,371 @@
 #include "Quat.h"
+#include "CpuFeatures.h"
 
-const Quat Quat::identity(0, 0, 0, 1);
+#include <algorithm>
+#include <cstddef>
 
-Quat::Quat() : x(0), y(0), z(0), w(1)
-{
-}
-
-Quat::Quat(double x, double y, double z, double w) : x(x), y(y), z(z), w(w)
-{
-}
-
-Quat::Quat(Vec3 v, double w) : x(v.x), y(v.y), z(v.z), w(w)
-{
-}
+// The double batch functions, QuatT<double>. Everything else about Quat lives in Quat.h.
 
-double Quat::Magnitude() const
-{
-	return sqrt(w*w + x*x + y*y + z*z);
-}
-
-Quat Quat::Normalize() const
-{
-	return *this / Magnitude();
-}
-
-Quat Quat::Normalize(Quat q)
-{
-	return q / q.Magnitude();
-}
-
-double Quat::DotProd(const Quat other)
-{
-	return x * other.x + y * other.y + z * other.z + w * other.w;
-}
-
-double Quat::DotProd(const Quat a, const Quat b)
-{
-	return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
-}
-
-double Quat::AngleBetween(const Quat other)
-{
-	double dot = DotProd(other);
-	return acos(fmin(fabs(dot), 1)) * 2;
-}
-
-double Quat::AngleBetween(const Quat a, const Quat b)
-{
-	double dot = DotProd(a, b);
-	return acos(fmin(fabs(dot), 1)) * 2;
-}
-
-Quat Quat::Conjugate()
-{
-	return Quat(-x, -y, -z, w);
-}
+#ifdef ECS_X86
+namespace {
+	static_assert(sizeof(Quat) == 4 * sizeof(double) && offsetof(Quat, w) == 0 && offsetof(Quat, z) == 3 * sizeof(double),
+		"batches load a quaternion as 4 packed doubles w x y z");
 
-Quat Quat::Conjugate(Quat r)
-{
-	return Quat(-r.x, -r.y, -r.z, r.w);
-}
-
-// WORLD ROT
-// FromAngleAxis * rotation = new rotation
-// LOCAL ROT
-// rotation * FromAngleAxis = new rotation
-Quat Quat::FromAngleAxis(double angle, Vec3 axis)
-{
-	angle = ToRadians(angle);
-	double mag = axis.Magnitude();
-	double s = sin(angle * 0.5) / mag;
-	
-	return Quat(axis.x * s, axis.y * s, axis.z * s, cos(angle * 0.5));;
-}
-
-// to give to opengl via glMultMatrix
-std::array<double, 16> Quat::ToMatrix() {
-	
-	return {
-		1 - 2 * (z * z + y * y), 2 * (x * y + w * z), 2 * (z * x - w * y), 0,
-		2 * (x * y - w * z), 1 - 2 * (x * x + z * z), 2 * (y * z + w * x), 0,
-		2 * (z * x + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y), 0,
-		0,                   0,                   0,                       1
+	// Four quaternions, one per lane
+	struct Quat4 {
+		__m256d w, x, y, z;
 	};
-}
 
-Quat Quat::FromToRotation(Vec3 from, Vec3 to)
-{
-	double dot = Vec3::DotProd(from, to);
-	double k = sqrt(Vec3::SqrMagnitude(from) * Vec3::SqrMagnitude(to));
-	if (fabs(dot / k + 1) < 0.00001)
+	// 4x4 transpose, turns four [w x y z] rows into w, x, y, z columns and back again
+	ECS_TARGET_AVX2 inline void Transpose(__m256d& r0, __m256d& r1, __m256d& r2, __m256d& r3)
 	{
-		Vec3 ortho = Vec3::Ortho(from);
-		return Quat(Vec3::Normalize(ortho), 0);
+		__m256d t0 = _mm256_unpacklo_pd(r0, r1);
+		__m256d t1 = _mm256_unpackhi_pd(r0, r1);
+		__m256d t2 = _mm256_unpacklo_pd(r2, r3);
+		__m256d t3 = _mm256_unpackhi_pd(r2, r3);
+		r0 = _mm256_permute2f128_pd(t0, t2, 0x20);
+		r1 = _mm256_permute2f128_pd(t1, t3, 0x20);
+		r2 = _mm256_permute2f128_pd(t0, t2, 0x31);
+		r3 = _mm256_permute2f128_pd(t1, t3, 0x31);
 	}
 
-	Vec3 cross = Vec3::CrossProd(from, to);
-	return Normalize(Quat(cross, dot + k));
-}
-
-Quat Quat::Inverse()
-{
-	double m = Magnitude();
-	return Conjugate() / (m * m);
-}
-
-Quat Quat::Inverse(Quat rotation)
-{
-	double m = rotation.Magnitude();
-	return Conjugate(rotation) / (m * m);
-}
-
-Quat Quat::Lerp(Quat a, Quat b, double t)
-{
-	if (t < 0) return Normalize(a);
-	else if (t > 1) return Normalize(b);
-	return LerpUnclamped(a, b, t);
-}
+	ECS_TARGET_AVX2 inline Quat4 Load(const Quat* q)
+	{
+		Quat4 r = { _mm256_loadu_pd(&q[0].w), _mm256_loadu_pd(&q[1].w), _mm256_loadu_pd(&q[2].w), _mm256_loadu_pd(&q[3].w) };
+		Transpose(r.w, r.x, r.y, r.z);
+		return r;
+	}
 
-Quat Quat::LerpUnclamped(Quat a, Quat b, double t)
-{
-	Quat quaternion;
-	if (DotProd(a, b) >= 0)
-		quaternion = a * (1 - t) + b * t;
-	else
-		quaternion = a * (1 - t) - b * t;
-	return Normalize(quaternion);
-}
+	ECS_TARGET_AVX2 inline void Store(Quat* q, Quat4 r)
+	{
+		Transpose(r.w, r.x, r.y, r.z);
+		_mm256_storeu_pd(&q[0].w, r.w);
+		_mm256_storeu_pd(&q[1].w, r.x);
+		_mm256_storeu_pd(&q[2].w, r.y);
+		_mm256_storeu_pd(&q[3].w, r.z);
+	}
 
-Quat Quat::LookRotation(Vec3 forward)
-{
-	return LookRotation(forward, Vec3::up);
-}
+	ECS_TARGET_AVX2 inline __m256d Dot(const Quat4& a, const Quat4& b)
+	{
+		return _mm256_fmadd_pd(a.w, b.w, _mm256_fmadd_pd(a.z, b.z, _mm256_fmadd_pd(a.y, b.y, _mm256_mul_pd(a.x, b.x))));
+	}
 
-Quat Quat::LookRotation(Vec3 forward, Vec3 upwards)
-{
-	Quat rot1 = Quat::FromTo(Vec3::forward, forward);
+	ECS_TARGET_AVX2 inline Quat4 Normalize(const Quat4& q)
+	{
+		__m256d inv = _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(Dot(q, q)));
+		return { _mm256_mul_pd(q.w, inv), _mm256_mul_pd(q.x, inv), _mm256_mul_pd(q.y, inv), _mm256_mul_pd(q.z, inv) };
+	}
 
-	Vec3 up = rot1 * upwards;
-	Quat rot2 = Quat::FromTo(Vec3::up, upwards);
+	// Abramowitz & Stegun 4.4.46, x in [0, 1], absolute error <= 2e-8
+	ECS_TARGET_AVX2 inline __m256d Acos(__m256d x)
+	{
+		__m256d p = _mm256_set1_pd(-0.0012624911);
+		p = _mm256_fmadd_pd(p, x, _mm256_set1_pd(0.0066700901));
+		p = _mm256_fmadd_pd(p, x, _mm256_set1_pd(-0.0170881256));
+		p = _mm256_fmadd_pd(p, x, _mm256_set1_pd(0.0308918810));
+		p = _mm256_fmadd_pd(p, x, _mm256_set1_pd(-0.0501743046));
+		p = _mm256_fmadd_pd(p, x, _mm256_set1_pd(0.0889789874));
+		p = _mm256_fmadd_pd(p, x, _mm256_set1_pd(-0.2145988016));
+		p = _mm256_fmadd_pd(p, x, _mm256_set1_pd(1.5707963050));
+		return _mm256_mul_pd(_mm256_sqrt_pd(_mm256_sub_pd(_mm256_set1_pd(1.0), x)), p);
+	}
 
-	return rot2 * rot1;
-}
+	// Taylor series to x^13 once reduced to [-pi/2, pi/2], absolute error <= 7e-10
+	ECS_TARGET_AVX2 inline __m256d Sin(__m256d x)
+	{
+		const __m256d pi = _mm256_set1_pd(M_PI);
+		const __m256d halfPi = _mm256_set1_pd(M_PI_2);
+
+		// into [-pi, pi], then sin(x) = sin(pi - x) folds the outer quarters in
+		__m256d k = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(0.5 / M_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		x = _mm256_fnmadd_pd(k, _mm256_set1_pd(2 * M_PI), x);
+		x = _mm256_blendv_pd(x, _mm256_sub_pd(pi, x), _mm256_cmp_pd(x, halfPi, _CMP_GT_OQ));
+		x = _mm256_blendv_pd(x, _mm256_sub_pd(_mm256_set1_pd(-M_PI), x), _mm256_cmp_pd(x, _mm256_set1_pd(-M_PI_2), _CMP_LT_OQ));
+
+		__m256d x2 = _mm256_mul_pd(x, x);
+		__m256d p = _mm256_set1_pd(1.0 / 6227020800.0);
+		p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(-1.0 / 39916800.0));
+		p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(1.0 / 362880.0));
+		p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(-1.0 / 5040.0));
+		p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(1.0 / 120.0));
+		p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(-1.0 / 6.0));
+		p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(1.0));
+		return _mm256_mul_pd(p, x);
+	}
 
-Quat Quat::FromTo(Vec3 source, Vec3 dest)
-{
-	double angle = source.AngleBetween(dest);
-	Vec3 axis = source.CrossProd(dest);
+	// Same steps as Quat::FreeSlerp
+	ECS_TARGET_AVX2 inline Quat4 Slerp(const Quat4& a, const Quat4& b, __m256d t)
+	{
+		const __m256d one = _mm256_set1_pd(1.0);
+		const __m256d signBit = _mm256_set1_pd(-0.0);
+
+		// take the short way round
+		__m256d dot = Dot(a, b);
+		__m256d sign = _mm256_and_pd(dot, signBit);
+		dot = _mm256_andnot_pd(signBit, dot);
+
+		__m256d angle = Acos(_mm256_min_pd(dot, one));
+		__m256d invSin = _mm256_div_pd(one, Sin(angle));
+		__m256d n2 = _mm256_mul_pd(Sin(_mm256_mul_pd(_mm256_sub_pd(one, t), angle)), invSin);
+		__m256d n1 = _mm256_mul_pd(Sin(_mm256_mul_pd(t, angle)), invSin);
+
+		// nearly the same rotation, sin(angle) is too small to divide by so lerp instead
+		__m256d close = _mm256_cmp_pd(dot, _mm256_set1_pd(0.999999), _CMP_GT_OQ);
+		n2 = _mm256_blendv_pd(n2, _mm256_sub_pd(one, t), close);
+		n1 = _mm256_xor_pd(_mm256_blendv_pd(n1, t, close), sign);
+
+		return Normalize({
+			_mm256_fmadd_pd(n2, a.w, _mm256_mul_pd(n1, b.w)),
+			_mm256_fmadd_pd(n2, a.x, _mm256_mul_pd(n1, b.x)),
+			_mm256_fmadd_pd(n2, a.y, _mm256_mul_pd(n1, b.y)),
+			_mm256_fmadd_pd(n2, a.z, _mm256_mul_pd(n1, b.z))
+		});
+	}
 
-	return Quat::FromAngleAxis(angle, axis);
-}
+	ECS_TARGET_AVX2 void SlerpAvx2(const Quat* a, const Quat* b, const float* t, Quat* out, std::size_t n, bool clamp)
+	{
+		for (std::size_t i = 0; i < n; i += 4) {
+			Quat4 qa = Load(a + i);
+			Quat4 qb = Load(b + i);
+			__m256d ti = _mm256_cvtps_pd(_mm_loadu_ps(t + i));
+			Quat4 q = Slerp(qa, qb, ti);
+
+			// like Quat::Slerp, out of range t returns a or b as they are rather than the short way round
+			if (clamp) {
+				Quat4 na = Normalize(qa);
+				Quat4 nb = Normalize(qb);
+				__m256d below = _mm256_cmp_pd(ti, _mm256_setzero_pd(), _CMP_LT_OQ);
+				__m256d above = _mm256_cmp_pd(ti, _mm256_set1_pd(1.0), _CMP_GT_OQ);
+				q.w = _mm256_blendv_pd(_mm256_blendv_pd(q.w, na.w, below), nb.w, above);
+				q.x = _mm256_blendv_pd(_mm256_blendv_pd(q.x, na.x, below), nb.x, above);
+				q.y = _mm256_blendv_pd(_mm256_blendv_pd(q.y, na.y, below), nb.y, above);
+				q.z = _mm256_blendv_pd(_mm256_blendv_pd(q.z, na.z, below), nb.z, above);
+			}
+
+			Store(out + i, q);
+		}
+	}
 
-Quat Quat::Slerp(Quat a, Quat b, double t)
-{
-	if (t < 0) return a.Normalize();
-	else if (t > 1) return b.Normalize();
-	return FreeSlerp(a, b, t);
-}
+	// Same steps as Quat::RotateTowards
+	ECS_TARGET_AVX2 void RotateTowardsAvx2(const Quat* from, const Quat* to, const float* maxRadiansDelta, Quat* out, std::size_t n)
+	{
+		const __m256d signBit = _mm256_set1_pd(-0.0);
+
+		for (std::size_t i = 0; i < n; i += 4) {
+			Quat4 a = Load(from + i);
+			Quat4 b = Load(to + i);
+
+			__m256d dot = _mm256_min_pd(_mm256_andnot_pd(signBit, Dot(a, b)), _mm256_set1_pd(1.0));
+			__m256d angle = _mm256_mul_pd(Acos(dot), _mm256_set1_pd(2.0));
+			__m256d delta = _mm256_max_pd(_mm256_cvtps_pd(_mm_loadu_ps(maxRadiansDelta + i)), _mm256_sub_pd(angle, _mm256_set1_pd(M_PI)));
+			// delta / 0 is nan for lanes already there, min hands back 1 for those
+			__m256d t = _mm256_min_pd(_mm256_div_pd(delta, angle), _mm256_set1_pd(1.0));
+
+			Quat4 q = Slerp(a, b, t);
+			__m256d done = _mm256_cmp_pd(angle, _mm256_setzero_pd(), _CMP_EQ_OQ);
+			q.w = _mm256_blendv_pd(q.w, b.w, done);
+			q.x = _mm256_blendv_pd(q.x, b.x, done);
+			q.y = _mm256_blendv_pd(q.y, b.y, done);
+			q.z = _mm256_blendv_pd(q.z, b.z, done);
+			Store(out + i, q);
+		}
+	}
 
-Quat Quat::FreeSlerp(Quat a, Quat b, double t)
-{
-	double n1;
-	double n2;
-	double n3 = DotProd(a, b);
-	bool flag = false;
-	if (n3 < 0)
+	ECS_TARGET_AVX2 void NormalizeAvx2(const Quat* q, Quat* out, std::size_t n)
 	{
-		flag = true;
-		n3 = -n3;
+		for (std::size_t i = 0; i < n; i += 4)
+			Store(out + i, Normalize(Load(q + i)));
 	}
-	if (n3 > 0.999999)
+
+	// Same steps as Quat::operator*=
+	ECS_TARGET_AVX2 void MultiplyAvx2(const Quat* a, const Quat* b, Quat* out, std::size_t n)
 	{
-		n2 = 1 - t;
-		n1 = flag ? -t : t;
+		for (std::size_t i = 0; i < n; i += 4) {
+			Quat4 p = Load(a + i);
+			Quat4 q = Load(b + i);
+
+			Quat4 r;
+			r.w = _mm256_fnmadd_pd(p.z, q.z, _mm256_fnmadd_pd(p.y, q.y, _mm256_fnmadd_pd(p.x, q.x, _mm256_mul_pd(p.w, q.w))));
+			r.x = _mm256_fnmadd_pd(p.z, q.y, _mm256_fmadd_pd(p.y, q.z, _mm256_fmadd_pd(p.w, q.x, _mm256_mul_pd(p.x, q.w))));
+			r.y = _mm256_fmadd_pd(p.z, q.x, _mm256_fmadd_pd(p.y, q.w, _mm256_fnmadd_pd(p.x, q.z, _mm256_mul_pd(p.w, q.y))));
+			r.z = _mm256_fmadd_pd(p.z, q.w, _mm256_fnmadd_pd(p.y, q.x, _mm256_fmadd_pd(p.x, q.y, _mm256_mul_pd(p.w, q.z))));
+			Store(out + i, r);
+		}
 	}
-	else
+
+	// Same steps as operator*(Quat, Vec3)
+	ECS_TARGET_AVX2 void RotateAvx2(const Quat* q, const Vec3* v, Vec3* out, std::size_t n)
 	{
-		double n4 = acos(n3);
-		double n5 = 1 / sin(n4);
-		n2 = sin((1 - t) * n4) * n5;
-		n1 = flag ? -sin(t * n4) * n5 : sin(t * n4) * n5;
+		const __m256d two = _mm256_set1_pd(2.0);
+
+		for (std::size_t i = 0; i < n; i += 4) {
+			Quat4 u = Load(q + i);
+			__m256d vx = _mm256_set_pd(v[i + 3].x, v[i + 2].x, v[i + 1].x, v[i].x);
+			__m256d vy = _mm256_set_pd(v[i + 3].y, v[i + 2].y, v[i + 1].y, v[i].y);
+			__m256d vz = _mm256_set_pd(v[i + 3].z, v[i + 2].z, v[i + 1].z, v[i].z);
+
+			__m256d d2 = _mm256_mul_pd(two, _mm256_fmadd_pd(u.z, vz, _mm256_fmadd_pd(u.y, vy, _mm256_mul_pd(u.x, vx))));
+			__m256d k = _mm256_fnmadd_pd(u.z, u.z, _mm256_fnmadd_pd(u.y, u.y, _mm256_fnmadd_pd(u.x, u.x, _mm256_mul_pd(u.w, u.w))));
+			__m256d s2 = _mm256_mul_pd(two, u.w);
+
+			__m256d cx = _mm256_fmsub_pd(u.y, vz, _mm256_mul_pd(u.z, vy));
+			__m256d cy = _mm256_fmsub_pd(u.z, vx, _mm256_mul_pd(u.x, vz));
+			__m256d cz = _mm256_fmsub_pd(u.x, vy, _mm256_mul_pd(u.y, vx));
+
+			double x[4], y[4], z[4];
+			_mm256_storeu_pd(x, _mm256_fmadd_pd(cx, s2, _mm256_fmadd_pd(vx, k, _mm256_mul_pd(u.x, d2))));
+			_mm256_storeu_pd(y, _mm256_fmadd_pd(cy, s2, _mm256_fmadd_pd(vy, k, _mm256_mul_pd(u.y, d2))));
+			_mm256_storeu_pd(z, _mm256_fmadd_pd(cz, s2, _mm256_fmadd_pd(vz, k, _mm256_mul_pd(u.z, d2))));
+
+			for (int j = 0; j < 4; j++) {
+				out[i + j].x = x[j];
+				out[i + j].y = y[j];
+				out[i + j].z = z[j];
+			}
+		}
 	}
-	Quat q;
-	q.x = (n2 * a.x) + (n1 * b.x);
-	q.y = (n2 * a.y) + (n1 * b.y);
-	q.z = (n2 * a.z) + (n1 * b.z);
-	q.w = (n2 * a.w) + (n1 * b.w);
-	return q.Normalize();
-}
 
-Quat Quat::RotateTowards(Quat to, double maxRadiansDelta)
-{
-	double angle = AngleBetween(to);
-	if (angle == 0)
-		return to;
-	maxRadiansDelta = fmax(maxRadiansDelta, angle - M_PI);
-	double t = fmin(1, maxRadiansDelta / angle);
-	return Quat::FreeSlerp(*this, to, t);
-}
+	bool UseAvx2()
+	{
+		return CpuFeatures::Get().avx2 && CpuFeatures::Get().fma;
+	}
 
-Quat Quat::RotateTowards(Quat from, Quat to, double maxRadiansDelta)
-{
-	double angle = Quat::AngleBetween(from, to);
-	if (angle == 0)
-		return to;
-	maxRadiansDelta = fmax(maxRadiansDelta, angle - M_PI);
-	double t = fmin(1, maxRadiansDelta / angle);
-	return Quat::FreeSlerp(from, to, t);
+	// Whole groups of four, the caller pads the remainder
+	std::size_t Whole(std::size_t n)
+	{
+		return n & ~std::size_t(3);
+	}
 }
-
-void Quat::ToAngleAxis(Quat rot, double& angle, Vec3& axis)
-{
-	if (rot.w > 1)
-		rot = rot.Normalize();
-	angle = 2 * acos(rot.w);
-	double s = sqrt(1 - rot.w * rot.w);
-	if (s < SMALL_DOUBLE) {
-		axis.x = 1;
-		axis.y = 0;
-		axis.z = 0;
+#endif
+
+template<>
+void Quat::SlerpBatch(const Quat* a, const Quat* b, const float* t, Quat* out, std::size_t n)
+{
+	std::size_t i = 0;
+#ifdef ECS_X86
+	if (UseAvx2()) {
+		i = Whole(n);
+		SlerpAvx2(a, b, t, out, i, true);
+		if (i == n) return;
+
+		Quat pa[4], pb[4], po[4];
+		float pt[4] = {};
+		std::copy(a + i, a + n, pa);
+		std::copy(b + i, b + n, pb);
+		std::copy(t + i, t + n, pt);
+		SlerpAvx2(pa, pb, pt, po, 4, true);
+		std::copy(po, po + (n - i), out + i);
+		return;
 	}
-	else {
-		axis.x = rot.x / s;
-		axis.y = rot.y / s;
-		axis.z = rot.z / s;
+#endif
+	for (; i < n; i++) out[i] = Slerp(a[i], b[i], t[i]);
+}
+
+template<>
+void Quat::FreeSlerpBatch(const Quat* a, const Quat* b, const float* t, Quat* out, std::size_t n)
+{
+	std::size_t i = 0;
+#ifdef ECS_X86
+	if (UseAvx2()) {
+		i = Whole(n);
+		SlerpAvx2(a, b, t, out, i, false);
+		if (i == n) return;
+
+		Quat pa[4], pb[4], po[4];
+		float pt[4] = {};
+		std::copy(a + i, a + n, pa);
+		std::copy(b + i, b + n, pb);
+		std::copy(t + i, t + n, pt);
+		SlerpAvx2(pa, pb, pt, po, 4, false);
+		std::copy(po, po + (n - i), out + i);
+		return;
 	}
+#endif
+	for (; i < n; i++) out[i] = FreeSlerp(a[i], b[i], t[i]);
+}
+
+template<>
+void Quat::RotateTowardsBatch(const Quat* from, const Quat* to, const float* maxRadiansDelta, Quat* out, std::size_t n)
+{
+	std::size_t i = 0;
+#ifdef ECS_X86
+	if (UseAvx2()) {
+		i = Whole(n);
+		RotateTowardsAvx2(from, to, maxRadiansDelta, out, i);
+		if (i == n) return;
+
+		Quat pa[4], pb[4], po[4];
+		float pd[4] = {};
+		std::copy(from + i, from + n, pa);
+		std::copy(to + i, to + n, pb);
+		std::copy(maxRadiansDelta + i, maxRadiansDelta + n, pd);
+		RotateTowardsAvx2(pa, pb, pd, po, 4);
+		std::copy(po, po + (n - i), out + i);
+		return;
+	}
+#endif
+	for (; i < n; i++) out[i] = RotateTowards(from[i], to[i], maxRadiansDelta[i]);
 }
 
-Vec3 Quat::GetForwardVec()
-{
-	Quat pure(Vec3::forward, 0);
-	std::cout << "Pure " << pure << std::endl;
-	std::cout << "Conj " << Conjugate() << std::endl;
-	Quat right = pure * Conjugate();
-	std::cout << "This Rot " << *this << std::endl;
-	std::cout << "Right " << right << std::endl;
-	Quat left = *this * right;
-	std::cout << "Left " << left << std::endl;
-	return Vec3(left.x, left.y, left.z);
-}
-
-Vec3 Quat::GetUpVec()
-{
-	Quat pure(Vec3::forward, 0);
-	Quat right = pure * Conjugate();
-	Quat left = *this * right;
-	return Vec3(left.x, left.y, left.z);
-}
-
-Vec3 Quat::GetLeftVec()
-{
-	Quat pure(Vec3::left, 0);
-	Quat right = pure * Conjugate();
-	Quat left = *this * right;
-	return Vec3(left.x, left.y, left.z);
-}
-
-/****OPERATORS****/
-Quat& Quat::operator+=(const double d)
-{
-	x += d;
-	y += d;
-	z += d;
-	w += d;
-	return *this;
-}
-
-Quat& Quat::operator-=(const double d)
-{
-	x -= d;
-	y -= d;
-	z -= d;
-	w -= d;
-	return *this;
-}
-
-Quat& Quat::operator*=(const double d)
-{
-	x *= d;
-	y *= d;
-	z *= d;
-	w *= d;
-	return *this;
-}
-
-Quat& Quat::operator/=(const double d)
-{
-	x /= d;
-	y /= d;
-	z /= d;
-	w /= d;
-	return *this;
-}
-
-Quat& Quat::operator+=(const Quat q)
+template<>
+void Quat::NormalizeBatch(const Quat* q, Quat* out, std::size_t n)
 {
-	x += q.x;
-	y += q.y;
-	z += q.z;
-	w += q.w;
-	return *this;
-}
+	std::size_t i = 0;
+#ifdef ECS_X86
+	if (UseAvx2()) {
+		i = Whole(n);
+		NormalizeAvx2(q, out, i);
+		if (i == n) return;
 
-Quat& Quat::operator-=(const Quat q)
-{
-	x -= q.x;
-	y -= q.y;
-	z -= q.z;
-	w -= q.w;
-	return *this;
-}
-
-Quat& Quat::operator*=(const Quat q)
-{
-	Quat nq;
-	nq.w = w * q.w - x * q.x - y * q.y - z * q.z;
-	nq.x = x * q.w + w * q.x + y * q.z - z * q.y;
-	nq.y = w * q.y - x * q.z + y * q.w + z * q.x;
-	nq.z = w * q.z + x * q.y - y * q.x + z * q.w;
-	*this = nq;
-	return *this;
+		Quat pq[4], po[4];
+		std::copy(q + i, q + n, pq);
+		NormalizeAvx2(pq, po, 4);
+		std::copy(po, po + (n - i), out + i);
+		return;
+	}
+#endif
+	for (; i < n; i++) out[i] = q[i].Normalize();
+}
+
+template<>
+void Quat::MultiplyBatch(const Quat* a, const Quat* b, Quat* out, std::size_t n)
+{
+	std::size_t i = 0;
+#ifdef ECS_X86
+	if (UseAvx2()) {
+		i = Whole(n);
+		MultiplyAvx2(a, b, out, i);
+		if (i == n) return;
+
+		Quat pa[4], pb[4], po[4];
+		std::copy(a + i, a + n, pa);
+		std::copy(b + i, b + n, pb);
+		MultiplyAvx2(pa, pb, po, 4);
+		std::copy(po, po + (n - i), out + i);
+		return;
+	}
+#endif
+	for (; i < n; i++) out[i] = a[i] * b[i];
+}
+
+template<>
+void Quat::RotateBatch(const Quat* q, const Vec3* v, Vec3* out, std::size_t n)
+{
+	std::size_t i = 0;
+#ifdef ECS_X86
+	if (UseAvx2()) {
+		i = Whole(n);
+		RotateAvx2(q, v, out, i);
+		if (i == n) return;
+
+		Quat pq[4];
+		Vec3 pv[4], po[4];
+		std::copy(q + i, q + n, pq);
+		std::copy(v + i, v + n, pv);
+		RotateAvx2(pq, pv, po, 4);
+		std::copy(po, po + (n - i), out + i);
+		return;
+	}
+#endif
+	for (; i < n; i++) out[i] = q[i] * v[i];
 }
-
-std::ostream& operator<<(std::ostream& os, const Quat& q)
-{
-	os << "(" << std::to_string(q.x) << ", " << std::to_string(q.y) << ", " << std::to_string(q.z) << ", " << std::to_string(q.w) << ") Mag: " << q.Magnitude();
-	return os;
-}
\ No newline at end of file
@@ -4,64 +4,74 @@
 #include "Vec3.h"
 #include <iostream>
 #include <array>
+#include <cstddef>
 
-class Quat {
+// Header only like Vec3T, use the Quat (double) and Quatf (float) aliases below.
+// Members are laid out w x y z, the batch functions rely on it.
+template<typename T>
+class QuatT {
 public:
-	Quat();
-	Quat(double x, double y, double z, double w);
-	Quat(Vec3 v, double w);
+	constexpr QuatT() : w(1), x(0), y(0), z(0) {}
+	constexpr QuatT(T x, T y, T z, T w) : w(w), x(x), y(y), z(z) {}
+	constexpr QuatT(Vec3T<T> v, T w) : w(w), x(v.x), y(v.y), z(v.z) {}
+	template<typename U>
+	constexpr explicit QuatT(const QuatT<U>& other) : w(static_cast<T>(other.w)), x(static_cast<T>(other.x)), y(static_cast<T>(other.y)), z(static_cast<T>(other.z)) {}
 
-	double Magnitude() const;
-	Quat Normalize() const;
-	static Quat Normalize(Quat q);
+	T Magnitude() const;
+	QuatT Normalize() const;
+	static QuatT Normalize(QuatT q);
 
-	double DotProd(const Quat other);
-	static double DotProd(const Quat a, const Quat b);
+	constexpr T DotProd(const QuatT other) const;
+	static constexpr T DotProd(const QuatT a, const QuatT b);
 
 	/**
 	 * Returns the angle between two quaternions.
 	 * The quaternions MUST be normalized.
 	 */
-	double AngleBetween(const Quat other);
+	T AngleBetween(const QuatT other) const;
 	/**
 	 * Returns the angle between two quaternions.
 	 * The quaternions MUST be normalized.
 	 */
-	static double AngleBetween(const Quat a, const Quat b);
+	static T AngleBetween(const QuatT a, const QuatT b);
 
 	/**
 	 * Returns the conjugate of a quaternion.
 	 * Inverts x, y, z.
 	 */
-	Quat Conjugate();
+	constexpr QuatT Conjugate() const;
 	/**
 	 * Returns the conjugate of a quaternion.
 	 * Inverts x, y, z.
 	 */
-	static Quat Conjugate(Quat r);
+	static constexpr QuatT Conjugate(QuatT r);
 
 	/**
      * Creates a new quaternion from the angle-axis representation of
      * a rotation.
      * Requires Radians for angle
      */
-	static Quat FromAngleAxis(double angle, Vec3 axis);
+	static QuatT FromAngleAxis(T angle, Vec3T<T> axis);
 
-	std::array<double, 16> ToMatrix();
+	constexpr std::array<T, 16> ToMatrix() const;
+	/**
+	 * Inverse of ToMatrix, the upper 3x3 of the matrix must be a pure rotation.
+	 */
+	static QuatT FromMatrix(const std::array<T, 16>& m);
 
 	/**
 	 * Create a quaternion rotation which rotates "fromVector" to "toVector".
 	 * @param fromVector: The vector from which to start the rotation.
 	 * @param toVector: The vector at which to end the rotation.
 	 */
-	static Quat FromToRotation(Vec3 from, Vec3 to);
-	
-	Quat Inverse();
-	static Quat Inverse(Quat rotation);
-	
-	static Quat Lerp(Quat a, Quat b, double t);
-	static Quat LerpUnclamped(Quat a, Quat b, double t);
-	
+	static QuatT FromToRotation(Vec3T<T> from, Vec3T<T> to);
+
+	QuatT Inverse() const;
+	static QuatT Inverse(QuatT rotation);
+
+	static QuatT Lerp(QuatT a, QuatT b, T t);
+	static QuatT LerpUnclamped(QuatT a, QuatT b, T t);
+
 	/**
 	 * Creates a rotation with the specified forward direction. This is the
 	 * same as calling LookRotation with (0, 1, 0) as the upwards vector.
@@ -69,8 +79,8 @@ public:
 	 * @param forward: The forward direction to look toward.
 	 * @return: A new quaternion.
 	 */
-	static Quat LookRotation(Vec3 forward);
-	
+	static QuatT LookRotation(Vec3T<T> forward);
+
 	/**
 	 * Creates a rotation with the specified forward and upwards directions.
 	 * The output is undefined for parallel vectors.
@@ -78,15 +88,33 @@ public:
 	 * @param upwards: The direction to treat as up.
 	 * @return: A new quaternion.
 	 */
-	static Quat LookRotation(Vec3 forward, Vec3 upwards);
-	
-	static Quat FromTo(Vec3 source, Vec3 dest);
+	static QuatT LookRotation(Vec3T<T> forward, Vec3T<T> upwards);
+
+	static QuatT FromTo(Vec3T<T> source, Vec3T<T> dest);
 
-	static Quat Slerp(Quat a, Quat b, double t);
-	static Quat FreeSlerp(Quat a, Quat b, double t);
+	static QuatT Slerp(QuatT a, QuatT b, T t);
+	static QuatT FreeSlerp(QuatT a, QuatT b, T t);
 
-	Quat RotateTowards(Quat to, double maxRadiansDelta);
-	static Quat RotateTowards(Quat from, Quat to, double maxRadiansDelta);
+	QuatT RotateTowards(QuatT to, T maxRadiansDelta) const;
+	static QuatT RotateTowards(QuatT from, QuatT to, T maxRadiansDelta);
+
+	/**
+	 * Array versions of the functions above, out[i] = f(a[i], b[i], ...).
+	 * out may be the same array as an input. For Quat on CPUs with AVX2 four quaternions
+	 * are processed per iteration, with acos approximated by Abramowitz & Stegun 4.4.46
+	 * (absolute error <= 2e-8) and sin by a degree 13 odd polynomial after range reduction
+	 * (absolute error <= 7e-10 on [-pi/2, pi/2]). Slerp and FreeSlerp results stay within 5e-8
+	 * per component of the scalar functions, RotateTowards divides by the approximate angle
+	 * and stays within 1e-7.
+	 * Exactly opposite inputs may come back as -q, the same rotation.
+	 * Other CPUs and Quatf fall back to the scalar functions.
+	 */
+	static void SlerpBatch(const QuatT* a, const QuatT* b, const float* t, QuatT* out, std::size_t n);
+	static void FreeSlerpBatch(const QuatT* a, const QuatT* b, const float* t, QuatT* out, std::size_t n);
+	static void RotateTowardsBatch(const QuatT* from, const QuatT* to, const float* maxRadiansDelta, QuatT* out, std::size_t n);
+	static void NormalizeBatch(const QuatT* q, QuatT* out, std::size_t n);
+	static void MultiplyBatch(const QuatT* a, const QuatT* b, QuatT* out, std::size_t n);
+	static void RotateBatch(const QuatT* q, const Vec3T<T>* v, Vec3T<T>* out, std::size_t n);
 
 	/**
 	 * Outputs the angle axis representation of the provided quaternion.
@@ -94,71 +122,461 @@ public:
 	 * @param angle: The output angle.
 	 * @param axis: The output axis.
 	 */
-	static void ToAngleAxis(Quat rot, double& angle, Vec3& axis);
+	static void ToAngleAxis(QuatT rot, T& angle, Vec3T<T>& axis);
+
+	Vec3T<T> GetForwardVec() const;
+	Vec3T<T> GetUpVec() const;
+	Vec3T<T> GetLeftVec() const;
+
+	constexpr QuatT& operator+=(const T d);
+	constexpr QuatT& operator-=(const T d);
+	constexpr QuatT& operator*=(const T d);
+	constexpr QuatT& operator/=(const T d);
+	constexpr QuatT& operator+=(const QuatT q);
+	constexpr QuatT& operator-=(const QuatT q);
+	constexpr QuatT& operator*=(const QuatT q);
+
+	friend constexpr QuatT operator+(QuatT q, const T d) { return q += d; }
+	friend constexpr QuatT operator-(QuatT q, const T d) { return q -= d; }
+	friend constexpr QuatT operator*(QuatT q, const T d) { return q *= d; }
+	friend constexpr QuatT operator/(QuatT q, const T d) { return q /= d; }
+	friend constexpr QuatT operator+(const T d, QuatT q) { return q += d; }
+	friend constexpr QuatT operator-(const T d, QuatT q) { return q -= d; }
+	friend constexpr QuatT operator*(const T d, QuatT q) { return q *= d; }
+	friend constexpr QuatT operator/(const T d, QuatT q) { return q /= d; }
+	friend constexpr QuatT operator-(QuatT q) { return q * -1; }
 
-	Vec3 GetForwardVec();
-	Vec3 GetUpVec();
-	Vec3 GetLeftVec();
+	friend constexpr QuatT operator+(QuatT a, const QuatT b) { return a += b; }
+	friend constexpr QuatT operator-(QuatT a, const QuatT b) { return a -= b; }
+	friend constexpr QuatT operator*(QuatT a, const QuatT b) { return a *= b; }
 
-	Quat& operator+=(const double d);
-	Quat& operator-=(const double d);
-	Quat& operator*=(const double d);
-	Quat& operator/=(const double d);
-	Quat& operator+=(const Quat q);
-	Quat& operator-=(const Quat q);
-	Quat& operator*=(const Quat q);
-	friend std::ostream& operator<<(std::ostream& os, const Quat& q);
+	friend constexpr Vec3T<T> operator*(QuatT q, Vec3T<T> v) {
+		Vec3T<T> u = Vec3T<T>(q.x, q.y, q.z);
+		T s = q.w;
+		return u * (Vec3T<T>::DotProd(u, v) * 2) + v * (s * s - Vec3T<T>::DotProd(u, u)) + Vec3T<T>::CrossProd(u, v) * (2 * s);
+	}
 
-	double w;
-	double x;
-	double y;
-	double z;
+	friend constexpr bool operator==(const QuatT a, const QuatT b) {
+		return a.x == b.x &&
+			a.y == b.y &&
+			a.z == b.z &&
+			a.w == b.w;
+	}
+	friend constexpr bool operator!=(const QuatT a, const QuatT b) { return !(a == b); }
 
-	static const Quat identity;
+	friend std::ostream& operator<<(std::ostream& os, const QuatT& q) {
+		os << "(" << std::to_string(q.x) << ", " << std::to_string(q.y) << ", " << std::to_string(q.z) << ", " << std::to_string(q.w) << ") Mag: " << q.Magnitude();
+		return os;
+	}
+
+	T w;
+	T x;
+	T y;
+	T z;
+
+	// defined constexpr below, usable in constant expressions
+	static const QuatT identity;
 
 };
 
-inline Quat operator+(Quat q, const double d) { return q += d; }
-inline Quat operator-(Quat q, const double d) { return q -= d; }
-inline Quat operator*(Quat q, const double d) { return q *= d; }
-inline Quat operator/(Quat q, const double d) { return q /= d; }
-inline Quat operator+(const double d, Quat q) { return q += d; }
-inline Quat operator-(const double d, Quat q) { return q -= d; }
-inline Quat operator*(const double d, Quat q) { return q *= d; }
-inline Quat operator/(const double d, Quat q) { return q /= d; }
-inline Quat operator-(Quat q) { return q * -1; }
+using Quat = QuatT<double>;
+using Quatf = QuatT<float>;
+
+template<typename T> constexpr QuatT<T> QuatT<T>::identity(0, 0, 0, 1);
+
+static_assert(std::is_trivially_copyable<Quat>::value && std::is_trivially_copyable<Quatf>::value, "Quat must stay trivially copyable");
 
-inline Quat operator+(Quat a, const Quat b)
+// SIMD versions live in Quat.cpp
+template<> void QuatT<double>::SlerpBatch(const QuatT* a, const QuatT* b, const float* t, QuatT* out, std::size_t n);
+template<> void QuatT<double>::FreeSlerpBatch(const QuatT* a, const QuatT* b, const float* t, QuatT* out, std::size_t n);
+template<> void QuatT<double>::RotateTowardsBatch(const QuatT* from, const QuatT* to, const float* maxRadiansDelta, QuatT* out, std::size_t n);
+template<> void QuatT<double>::NormalizeBatch(const QuatT* q, QuatT* out, std::size_t n);
+template<> void QuatT<double>::MultiplyBatch(const QuatT* a, const QuatT* b, QuatT* out, std::size_t n);
+template<> void QuatT<double>::RotateBatch(const QuatT* q, const Vec3T<double>* v, Vec3T<double>* out, std::size_t n);
+
+template<typename T>
+inline T QuatT<T>::Magnitude() const
+{
+	return std::sqrt(w*w + x*x + y*y + z*z);
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::Normalize() const
+{
+	return *this / Magnitude();
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::Normalize(QuatT q)
+{
+	return q / q.Magnitude();
+}
+
+template<typename T>
+inline constexpr T QuatT<T>::DotProd(const QuatT other) const
+{
+	return x * other.x + y * other.y + z * other.z + w * other.w;
+}
+
+template<typename T>
+inline constexpr T QuatT<T>::DotProd(const QuatT a, const QuatT b)
 {
-	return a += b;
+	return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
 }
-inline Quat operator-(Quat a, const Quat b)
+
+template<typename T>
+inline T QuatT<T>::AngleBetween(const QuatT other) const
 {
-	return a -= b;
+	T dot = DotProd(other);
+	return std::acos(std::fmin(std::fabs(dot), T(1))) * 2;
 }
-inline Quat operator*(Quat a, const Quat b)
+
+template<typename T>
+inline T QuatT<T>::AngleBetween(const QuatT a, const QuatT b)
+{
+	return a.AngleBetween(b);
+}
+
+template<typename T>
+inline constexpr QuatT<T> QuatT<T>::Conjugate() const
+{
+	return QuatT(-x, -y, -z, w);
+}
+
+template<typename T>
+inline constexpr QuatT<T> QuatT<T>::Conjugate(QuatT r)
+{
+	return QuatT(-r.x, -r.y, -r.z, r.w);
+}
+
+// WORLD ROT
+// FromAngleAxis * rotation = new rotation
+// LOCAL ROT
+// rotation * FromAngleAxis = new rotation
+template<typename T>
+inline QuatT<T> QuatT<T>::FromAngleAxis(T angle, Vec3T<T> axis)
+{
+	angle = static_cast<T>(ToRadians(angle));
+	T mag = axis.Magnitude();
+	T s = std::sin(angle * T(0.5)) / mag;
+
+	return QuatT(axis.x * s, axis.y * s, axis.z * s, std::cos(angle * T(0.5)));
+}
+
+// to give to opengl via glMultMatrix
+template<typename T>
+inline constexpr std::array<T, 16> QuatT<T>::ToMatrix() const
+{
+	return {
+		1 - 2 * (z * z + y * y), 2 * (x * y + w * z), 2 * (z * x - w * y), 0,
+		2 * (x * y - w * z), 1 - 2 * (x * x + z * z), 2 * (y * z + w * x), 0,
+		2 * (z * x + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y), 0,
+		0,                   0,                   0,                       1
+	};
+}
+
+// column major like ToMatrix, branches on the largest component to stay accurate
+template<typename T>
+inline QuatT<T> QuatT<T>::FromMatrix(const std::array<T, 16>& m)
+{
+	const T trace = m[0] + m[5] + m[10];
+	if (trace > 0) {
+		T s = std::sqrt(trace + 1) * 2;
+		return QuatT((m[6] - m[9]) / s, (m[8] - m[2]) / s, (m[1] - m[4]) / s, s / 4);
+	}
+	if (m[0] > m[5] && m[0] > m[10]) {
+		T s = std::sqrt(1 + m[0] - m[5] - m[10]) * 2;
+		return QuatT(s / 4, (m[4] + m[1]) / s, (m[8] + m[2]) / s, (m[6] - m[9]) / s);
+	}
+	if (m[5] > m[10]) {
+		T s = std::sqrt(1 + m[5] - m[0] - m[10]) * 2;
+		return QuatT((m[4] + m[1]) / s, s / 4, (m[9] + m[6]) / s, (m[8] - m[2]) / s);
+	}
+	T s = std::sqrt(1 + m[10] - m[0] - m[5]) * 2;
+	return QuatT((m[8] + m[2]) / s, (m[9] + m[6]) / s, s / 4, (m[1] - m[4]) / s);
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::FromToRotation(Vec3T<T> from, Vec3T<T> to)
+{
+	T dot = Vec3T<T>::DotProd(from, to);
+	T k = std::sqrt(Vec3T<T>::SqrMagnitude(from) * Vec3T<T>::SqrMagnitude(to));
+	if (std::fabs(dot / k + 1) < 0.00001)
+	{
+		Vec3T<T> ortho = Vec3T<T>::Ortho(from);
+		return QuatT(Vec3T<T>::Normalize(ortho), 0);
+	}
+
+	Vec3T<T> cross = Vec3T<T>::CrossProd(from, to);
+	return Normalize(QuatT(cross, dot + k));
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::Inverse() const
+{
+	T m = Magnitude();
+	return Conjugate() / (m * m);
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::Inverse(QuatT rotation)
+{
+	return rotation.Inverse();
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::Lerp(QuatT a, QuatT b, T t)
+{
+	if (t < 0) return Normalize(a);
+	else if (t > 1) return Normalize(b);
+	return LerpUnclamped(a, b, t);
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::LerpUnclamped(QuatT a, QuatT b, T t)
+{
+	QuatT quaternion;
+	if (DotProd(a, b) >= 0)
+		quaternion = a * (1 - t) + b * t;
+	else
+		quaternion = a * (1 - t) - b * t;
+	return Normalize(quaternion);
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::LookRotation(Vec3T<T> forward)
+{
+	return LookRotation(forward, Vec3T<T>::up);
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::LookRotation(Vec3T<T> forward, Vec3T<T> upwards)
+{
+	QuatT rot1 = QuatT::FromTo(Vec3T<T>::forward, forward);
+	QuatT rot2 = QuatT::FromTo(Vec3T<T>::up, upwards);
+
+	return rot2 * rot1;
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::FromTo(Vec3T<T> source, Vec3T<T> dest)
+{
+	T angle = source.AngleBetween(dest);
+	Vec3T<T> axis = source.CrossProd(dest);
+
+	return QuatT::FromAngleAxis(angle, axis);
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::Slerp(QuatT a, QuatT b, T t)
+{
+	if (t < 0) return a.Normalize();
+	else if (t > 1) return b.Normalize();
+	return FreeSlerp(a, b, t);
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::FreeSlerp(QuatT a, QuatT b, T t)
+{
+	T n1;
+	T n2;
+	T n3 = DotProd(a, b);
+	bool flag = false;
+	if (n3 < 0)
+	{
+		flag = true;
+		n3 = -n3;
+	}
+	if (n3 > T(0.999999))
+	{
+		n2 = 1 - t;
+		n1 = flag ? -t : t;
+	}
+	else
+	{
+		T n4 = std::acos(n3);
+		T n5 = 1 / std::sin(n4);
+		n2 = std::sin((1 - t) * n4) * n5;
+		n1 = flag ? -std::sin(t * n4) * n5 : std::sin(t * n4) * n5;
+	}
+	QuatT q;
+	q.x = (n2 * a.x) + (n1 * b.x);
+	q.y = (n2 * a.y) + (n1 * b.y);
+	q.z = (n2 * a.z) + (n1 * b.z);
+	q.w = (n2 * a.w) + (n1 * b.w);
+	return q.Normalize();
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::RotateTowards(QuatT to, T maxRadiansDelta) const
+{
+	T angle = AngleBetween(to);
+	if (angle == 0)
+		return to;
+	maxRadiansDelta = std::fmax(maxRadiansDelta, angle - T(M_PI));
+	T t = std::fmin(T(1), maxRadiansDelta / angle);
+	return QuatT::FreeSlerp(*this, to, t);
+}
+
+template<typename T>
+inline QuatT<T> QuatT<T>::RotateTowards(QuatT from, QuatT to, T maxRadiansDelta)
+{
+	return from.RotateTowards(to, maxRadiansDelta);
+}
+
+template<typename T>
+inline void QuatT<T>::SlerpBatch(const QuatT* a, const QuatT* b, const float* t, QuatT* out, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; i++) out[i] = Slerp(a[i], b[i], t[i]);
+}
+
+template<typename T>
+inline void QuatT<T>::FreeSlerpBatch(const QuatT* a, const QuatT* b, const float* t, QuatT* out, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; i++) out[i] = FreeSlerp(a[i], b[i], t[i]);
+}
+
+template<typename T>
+inline void QuatT<T>::RotateTowardsBatch(const QuatT* from, const QuatT* to, const float* maxRadiansDelta, QuatT* out, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; i++) out[i] = RotateTowards(from[i], to[i], maxRadiansDelta[i]);
+}
+
+template<typename T>
+inline void QuatT<T>::NormalizeBatch(const QuatT* q, QuatT* out, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; i++) out[i] = q[i].Normalize();
+}
+
+template<typename T>
+inline void QuatT<T>::MultiplyBatch(const QuatT* a, const QuatT* b, QuatT* out, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; i++) out[i] = a[i] * b[i];
+}
+
+template<typename T>
+inline void QuatT<T>::RotateBatch(const QuatT* q, const Vec3T<T>* v, Vec3T<T>* out, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; i++) out[i] = q[i] * v[i];
+}
+
+template<typename T>
+inline void QuatT<T>::ToAngleAxis(QuatT rot, T& angle, Vec3T<T>& axis)
+{
+	if (rot.w > 1)
+		rot = rot.Normalize();
+	angle = 2 * std::acos(rot.w);
+	T s = std::sqrt(1 - rot.w * rot.w);
+	if (s < SMALL_DOUBLE) {
+		axis.x = 1;
+		axis.y = 0;
+		axis.z = 0;
+	}
+	else {
+		axis.x = rot.x / s;
+		axis.y = rot.y / s;
+		axis.z = rot.z / s;
+	}
+}
+
+template<typename T>
+inline Vec3T<T> QuatT<T>::GetForwardVec() const
+{
+	QuatT pure(Vec3T<T>::forward, 0);
+	QuatT right = pure * Conjugate();
+	QuatT left = *this * right;
+	return Vec3T<T>(left.x, left.y, left.z);
+}
+
+template<typename T>
+inline Vec3T<T> QuatT<T>::GetUpVec() const
+{
+	QuatT pure(Vec3T<T>::forward, 0);
+	QuatT right = pure * Conjugate();
+	QuatT left = *this * right;
+	return Vec3T<T>(left.x, left.y, left.z);
+}
+
+template<typename T>
+inline Vec3T<T> QuatT<T>::GetLeftVec() const
+{
+	QuatT pure(Vec3T<T>::left, 0);
+	QuatT right = pure * Conjugate();
+	QuatT left = *this * right;
+	return Vec3T<T>(left.x, left.y, left.z);
+}
+
+/****OPERATORS****/
+template<typename T>
+inline constexpr QuatT<T>& QuatT<T>::operator+=(const T d)
+{
+	x += d;
+	y += d;
+	z += d;
+	w += d;
+	return *this;
+}
+
+template<typename T>
+inline constexpr QuatT<T>& QuatT<T>::operator-=(const T d)
+{
+	x -= d;
+	y -= d;
+	z -= d;
+	w -= d;
+	return *this;
+}
+
+template<typename T>
+inline constexpr QuatT<T>& QuatT<T>::operator*=(const T d)
+{
+	x *= d;
+	y *= d;
+	z *= d;
+	w *= d;
+	return *this;
+}
+
+template<typename T>
+inline constexpr QuatT<T>& QuatT<T>::operator/=(const T d)
 {
-	return a *= b;
+	x /= d;
+	y /= d;
+	z /= d;
+	w /= d;
+	return *this;
 }
 
-inline Vec3 operator*(Quat q, Vec3 v)
+template<typename T>
+inline constexpr QuatT<T>& QuatT<T>::operator+=(const QuatT q)
 {
-	Vec3 u = Vec3(q.x, q.y, q.z);
-	double s = q.w;
-	return u * (Vec3::DotProd(u, v) * 2) + v * (s * s - Vec3::DotProd(u, u)) + Vec3::CrossProd(u, v) * (2.0 * s);
+	x += q.x;
+	y += q.y;
+	z += q.z;
+	w += q.w;
+	return *this;
 }
 
-inline bool operator==(const Quat a, const Quat b)
+template<typename T>
+inline constexpr QuatT<T>& QuatT<T>::operator-=(const QuatT q)
 {
-	return a.x == b.x &&
-		a.y == b.y &&
-		a.z == b.z &&
-		a.w == b.w;
+	x -= q.x;
+	y -= q.y;
+	z -= q.z;
+	w -= q.w;
+	return *this;
 }
 
-inline bool operator!=(const Quat a, const Quat b)
+template<typename T>
+inline constexpr QuatT<T>& QuatT<T>::operator*=(const QuatT q)
 {
-	return !(a == b);
+	QuatT nq;
+	nq.w = w * q.w - x * q.x - y * q.y - z * q.z;
+	nq.x = x * q.w + w * q.x + y * q.z - z * q.y;
+	nq.y = w * q.y - x * q.z + y * q.w + z * q.x;
+	nq.z = w * q.z + x * q.y - y * q.x + z * q.w;
+	*this = nq;
+	return *this;
 }
 
 #endif
@@ -0,0 +1,60 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Fixed size single producer single consumer queue, lock free on both ends.
+// One thread pushes, one other thread drains. Pushing into a full ring drops the element
+// and counts it rather than blocking the producer.
+template<typename T, std::size_t Capacity>
+class RingBuffer {
+public:
+	static_assert((Capacity & (Capacity - 1)) == 0, "RingBuffer capacity must be a power of two");
+	static constexpr std::size_t capacity = Capacity;
+
+	RingBuffer() : head(0), tail(0), dropped(0) {};
+
+	// fill(T&) writes the element in place, false if the ring was full
+	template<typename F>
+	inline bool Emplace(F&& fill) {
+		const std::size_t h = head.load(std::memory_order_relaxed);
+		if (h - tail.load(std::memory_order_acquire) == Capacity) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		fill(elements[h & (Capacity - 1)]);
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	inline bool Push(const T& element) { return Emplace([&](T& slot) { slot = element; }); }
+
+	// Consumer side, hands every element pushed so far to f in order
+	template<typename F>
+	inline std::size_t Drain(F&& f) {
+		const std::size_t h = head.load(std::memory_order_acquire);
+		std::size_t t = tail.load(std::memory_order_relaxed);
+		const std::size_t count = h - t;
+		for (; t != h; t++) f(elements[t & (Capacity - 1)]);
+		tail.store(t, std::memory_order_release);
+		return count;
+	}
+
+	// Approximate from any thread other than the two using the ring
+	std::size_t Size() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+	std::uint64_t Dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+	RingBuffer(const RingBuffer&) = delete;
+	void operator=(const RingBuffer&) = delete;
+
+	// on their own cache lines, the two threads write one each
+	alignas(64) std::atomic<std::size_t> head;
+	alignas(64) std::atomic<std::size_t> tail;
+	std::atomic<std::uint64_t> dropped;
+	T elements[Capacity];
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "Scheduler.h"
+#include "Profiler.h"
+
+Scheduler::Scheduler(JobSystem& jobs) : dirty(true), jobs(jobs)
+{
+}
+
+Scheduler::~Scheduler()
+{
+}
+
+System& Scheduler::AddSystem(std::unique_ptr<System> system)
+{
+	systems.push_back(std::move(system));
+	dirty = true;
+	return *systems.back();
+}
+
+void Scheduler::RemoveSystem(System* system)
+{
+	for (std::size_t i = 0; i < systems.size(); i++) {
+		if (systems[i].get() == system) {
+			systems.erase(systems.begin() + i);
+			dirty = true;
+			return;
+		}
+	}
+}
+
+const std::vector<std::unique_ptr<System>>& Scheduler::GetSystems() const
+{
+	return systems;
+}
+
+void Scheduler::Run(EntityManager& manager)
+{
+	if (systems.empty()) return;
+	ECS_PROFILE_SCOPE("Scheduler::Run");
+
+	if (dirty) Build();
+
+	for (std::size_t i = 0; i < nodes.size(); i++)
+		remaining[i].store(nodes[i].dependencies, std::memory_order_relaxed);
+
+	JobHandle frame = jobs.CreateHandle();
+	for (std::size_t root : roots)
+		jobs.Schedule(frame, [this, &manager, &frame, root] { RunNode(manager, frame, root); });
+
+	// the calling thread runs jobs too instead of just waiting
+	jobs.Wait(frame);
+}
+
+void Scheduler::Build()
+{
+	nodes.assign(systems.size(), Node{ {}, 0 });
+	roots.clear();
+
+	// registration order decides who goes first when two systems conflict,
+	// so every edge points forward and the graph can't have cycles
+	for (std::size_t j = 0; j < systems.size(); j++) {
+		for (std::size_t i = 0; i < j; i++) {
+			if (systems[i]->ConflictsWith(*systems[j])) {
+				nodes[i].successors.push_back(j);
+				nodes[j].dependencies++;
+			}
+		}
+
+		if (nodes[j].dependencies == 0) roots.push_back(j);
+	}
+
+	remaining.reset(new std::atomic<std::size_t>[nodes.size()]);
+	dirty = false;
+}
+
+void Scheduler::RunNode(EntityManager& manager, const JobHandle& frame, std::size_t node)
+{
+	{
+		ECS_PROFILE_SCOPE(systems[node]->GetName());
+		systems[node]->Update(manager);
+	}
+
+	// scheduled before this job finishes, so the frame can't complete early
+	for (std::size_t next : nodes[node].successors) {
+		if (remaining[next].fetch_sub(1, std::memory_order_acq_rel) == 1)
+			jobs.Schedule(frame, [this, &manager, &frame, next] { RunNode(manager, frame, next); });
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "System.h"
+#include "JobSystem.h"
+
+// Runs every system once per frame as jobs on a JobSystem.
+// A system depends on every earlier registered system it conflicts with, the resulting
+// DAG is built once and reused until the set of systems changes.
+class Scheduler {
+public:
+	Scheduler(JobSystem& jobs);
+	~Scheduler();
+
+	template<typename T, typename... TArgs>
+	inline T& AddSystem(TArgs&&... args);
+	System& AddSystem(std::unique_ptr<System> system);
+	void RemoveSystem(System* system);
+
+	const std::vector<std::unique_ptr<System>>& GetSystems() const;
+
+	// Runs all systems and returns once every one of them has finished
+	void Run(EntityManager& manager);
+
+private:
+	Scheduler(Scheduler& other) = delete;
+	void operator=(const Scheduler&) = delete;
+
+	struct Node {
+		std::vector<std::size_t> successors;
+		std::size_t dependencies;
+	};
+
+	void Build();
+	void RunNode(EntityManager& manager, const JobHandle& frame, std::size_t node);
+
+	std::vector<std::unique_ptr<System>> systems;
+
+	// cached schedule, rebuilt when dirty
+	std::vector<Node> nodes;
+	std::vector<std::size_t> roots;
+	bool dirty;
+
+	// per frame dependency counters
+	std::unique_ptr<std::atomic<std::size_t>[]> remaining;
+
+	JobSystem& jobs;
+
+};
+
+template<typename T, typename... TArgs>
+inline T& Scheduler::AddSystem(TArgs&&... args)
+{
+	T* system = new T(std::forward<TArgs>(args)...);
+	AddSystem(std::unique_ptr<System>(system));
+	return *system;
+}
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef SPARSE_SET_H
+#define SPARSE_SET_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "ECS.h"
+
+// Untyped half of a sparse set, maps entity indices to slots in a packed array.
+// sparse[entity index] -> dense slot, packed[dense slot] -> entity index
+class SparseSetBase {
+public:
+	virtual ~SparseSetBase() {};
+
+	inline bool Contains(std::uint32_t index) const {
+		return Slot(index) != npos;
+	}
+
+	std::size_t Size() const { return packed.size(); }
+	bool Empty() const { return packed.empty(); }
+
+	// Entity index of every element, in the same order as the packed components
+	const std::vector<std::uint32_t>& Indices() const { return packed; }
+
+	// Last tick the entities component was written / added, only valid while Contains(index)
+	inline Tick ChangedTick(std::uint32_t index) const { return changedTicks[Slot(index)]; }
+	inline Tick AddedTick(std::uint32_t index) const { return addedTicks[Slot(index)]; }
+	inline void MarkChanged(std::uint32_t index, Tick tick) { changedTicks[Slot(index)] = tick; }
+
+	virtual void Remove(std::uint32_t index) = 0;
+	virtual Component* GetComponentBase(std::uint32_t index) = 0;
+	// Packed components, Size() of them in the same order as Indices()
+	virtual const void* PackedData() const = 0;
+	// Destroys every component and hands the packed memory back to the allocator
+	virtual void Clear() = 0;
+	// Appends count components copy constructed from their snapshot bytes at data, see
+	// ComponentInfo::restore. None of the entities may be in the pool already.
+	virtual void Restore(const std::uint32_t* indices, const void* data, std::size_t count, Entity* const* entities, Tick tick) = 0;
+
+protected:
+	static constexpr std::uint32_t npos = ~0u;
+	// sparse array is paged so a few entities with high indices don't cost a huge array
+	static constexpr std::uint32_t pageSize = 4096;
+
+	inline std::uint32_t Slot(std::uint32_t index) const {
+		std::uint32_t page = index / pageSize;
+		if (page >= sparse.size() || !sparse[page]) return npos;
+		return sparse[page][index % pageSize];
+	}
+
+	inline void SetSlot(std::uint32_t index, std::uint32_t slot) {
+		std::uint32_t page = index / pageSize;
+		if (page >= sparse.size()) sparse.resize(page + 1);
+		if (!sparse[page]) {
+			sparse[page].reset(new std::uint32_t[pageSize]);
+			std::fill(sparse[page].get(), sparse[page].get() + pageSize, npos);
+		}
+		sparse[page][index % pageSize] = slot;
+	}
+
+	std::vector<std::unique_ptr<std::uint32_t[]>> sparse;
+	std::vector<std::uint32_t> packed;
+	// parallel to packed
+	std::vector<Tick> changedTicks;
+	std::vector<Tick> addedTicks;
+};
+
+// One densely packed pool of a single component type.
+// Insertion and removal are O(1), removal swaps the last element into the hole.
+template<typename T, typename Alloc = std::allocator<T>>
+class SparseSet : public SparseSetBase {
+public:
+	SparseSet(const Alloc& alloc = Alloc()) : dense(alloc) {};
+
+	// Stamps the component as changed at tick, and as added if the entity didn't have one
+	inline T& Emplace(std::uint32_t index, T&& comp, Tick tick);
+	inline void Remove(std::uint32_t index) override;
+
+	inline T* TryGet(std::uint32_t index) {
+		std::uint32_t slot = Slot(index);
+		return slot == npos ? nullptr : &dense[slot];
+	}
+
+	inline T& Get(std::uint32_t index) { return dense[Slot(index)]; }
+
+	Component* GetComponentBase(std::uint32_t index) override { return TryGet(index); }
+	const void* PackedData() const override { return dense.data(); }
+
+	void Clear() override {
+		for (auto index : packed) SetSlot(index, npos);
+		packed.clear();
+		changedTicks.clear();
+		addedTicks.clear();
+		std::vector<T, Alloc>(dense.get_allocator()).swap(dense);
+	}
+
+	void Restore(const std::uint32_t* indices, const void* data, std::size_t count, Entity* const* entities, Tick tick) override;
+	// Appends count copies of prototype, one reserve for all of them, see Prefab.
+	// None of the entities may be in the pool already.
+	inline void Fill(const std::uint32_t* indices, const T& prototype, std::size_t count, Entity* const* entities, Tick tick);
+
+	T* Data() { return dense.data(); }
+	typename std::vector<T, Alloc>::iterator begin() { return dense.begin(); }
+	typename std::vector<T, Alloc>::iterator end() { return dense.end(); }
+
+private:
+	std::vector<T, Alloc> dense;
+};
+
+template<typename T, typename Alloc>
+inline T& SparseSet<T, Alloc>::Emplace(std::uint32_t index, T&& comp, Tick tick)
+{
+	std::uint32_t slot = Slot(index);
+	if (slot != npos) {
+		changedTicks[slot] = tick;
+		dense[slot].~T();
+		return *new (&dense[slot]) T(std::move(comp));
+	}
+
+	SetSlot(index, static_cast<std::uint32_t>(packed.size()));
+	packed.push_back(index);
+	changedTicks.push_back(tick);
+	addedTicks.push_back(tick);
+	dense.push_back(std::move(comp));
+	return dense.back();
+}
+
+template<typename T, typename Alloc>
+inline void SparseSet<T, Alloc>::Remove(std::uint32_t index)
+{
+	std::uint32_t slot = Slot(index);
+	if (slot == npos) return;
+
+	std::uint32_t last = static_cast<std::uint32_t>(packed.size() - 1);
+	if (slot != last) {
+		// swap and pop, the last element takes over the removed slot
+		dense[slot] = std::move(dense[last]);
+		packed[slot] = packed[last];
+		changedTicks[slot] = changedTicks[last];
+		addedTicks[slot] = addedTicks[last];
+		SetSlot(packed[slot], slot);
+	}
+
+	dense.pop_back();
+	packed.pop_back();
+	changedTicks.pop_back();
+	addedTicks.pop_back();
+	SetSlot(index, npos);
+}
+
+template<typename T, typename Alloc>
+inline void SparseSet<T, Alloc>::Restore(const std::uint32_t* indices, const void* data, std::size_t count, Entity* const* entities, Tick tick)
+{
+	if constexpr (T::bitwiseSnapshot) {
+		dense.reserve(dense.size() + count);
+		packed.reserve(packed.size() + count);
+
+		const T* from = static_cast<const T*>(data);
+		for (std::size_t i = 0; i < count; i++) {
+			SetSlot(indices[i], static_cast<std::uint32_t>(packed.size()));
+			packed.push_back(indices[i]);
+			dense.push_back(from[i]);
+			dense.back().entity = entities[i];
+		}
+
+		changedTicks.resize(packed.size(), tick);
+		addedTicks.resize(packed.size(), tick);
+	}
+	else throw std::logic_error("SparseSet::Restore, component can't be restored from a snapshot");
+}
+
+template<typename T, typename Alloc>
+inline void SparseSet<T, Alloc>::Fill(const std::uint32_t* indices, const T& prototype, std::size_t count, Entity* const* entities, Tick tick)
+{
+	dense.reserve(dense.size() + count);
+	packed.reserve(packed.size() + count);
+
+	for (std::size_t i = 0; i < count; i++) {
+		SetSlot(indices[i], static_cast<std::uint32_t>(packed.size()));
+		packed.push_back(indices[i]);
+		dense.push_back(prototype);
+		dense.back().entity = entities[i];
+	}
+
+	changedTicks.resize(packed.size(), tick);
+	addedTicks.resize(packed.size(), tick);
+}
+
+#endif
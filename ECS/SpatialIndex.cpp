@@ -0,0 +1,628 @@
+#include "SpatialIndex.h"
+#include "EntityManager.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+static bool IsFinite(const Vec3& p)
+{
+	return std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z);
+}
+
+std::unique_ptr<SpatialIndex> SpatialIndex::Create(SpatialIndexType type, double cellSize)
+{
+	if (!(cellSize > 0)) throw std::logic_error("SpatialIndex::Create, the cell size must be positive");
+
+	switch (type) {
+	case SpatialIndexType::HashGrid: return std::unique_ptr<SpatialIndex>(new HashGridIndex(cellSize));
+	case SpatialIndexType::LooseOctree: return std::unique_ptr<SpatialIndex>(new LooseOctreeIndex(cellSize));
+	}
+	return nullptr;
+}
+
+SpatialIndex::SpatialIndex(double cellSize) : cellSize(cellSize), since(0)
+{
+}
+
+SpatialIndex::~SpatialIndex()
+{
+}
+
+void SpatialIndex::Update(EntityManager& manager)
+{
+	ECS_PROFILE_SCOPE("SpatialIndex::Update");
+
+	const Tick now = manager.GetStorage()->GetTick();
+	const TransformHierarchy& hierarchy = *manager.GetHierarchy();
+	const bool anyLinked = hierarchy.Size() != 0;
+
+	// whole chunks pass the filter, Set skips the entities in them that didn't move
+	manager.view<const Transform>().filter<Changed<Transform>>(since).each([&](Entity& e, const Transform& t) {
+		if (anyLinked && hierarchy.GetWorldMatrix(e.GetId())) return;
+		Set(e.GetId(), t.position);
+	});
+
+	// linked entities also move with their ancestors, so all of them are looked at
+	for (auto id : hierarchy.GetNodes())
+		if (manager.IsValid(id)) Set(id, hierarchy.GetWorldPosition(id));
+
+	for (auto id : linked) {
+		if (hierarchy.GetWorldMatrix(id)) continue;
+		Entity* e = manager.GetEntity(id);
+		if (e && e->transform) Set(id, e->transform->position);
+	}
+	linked = hierarchy.GetNodes();
+
+	since = now;
+}
+
+void SpatialIndex::Set(EntityId id, const Vec3& position)
+{
+	// NaN or infinite positions can't be placed, the entity drops out until it is back
+	if (!IsFinite(position)) {
+		Remove(id);
+		return;
+	}
+
+	if (id.index >= slots.size()) slots.resize(id.index + 1, invalid);
+
+	std::uint32_t slot = slots[id.index];
+	if (slot == invalid) {
+		slot = static_cast<std::uint32_t>(ids.size());
+		slots[id.index] = slot;
+		ids.push_back(id);
+		positions.push_back(position);
+		Inserted(slot);
+		return;
+	}
+
+	// a reused index takes over the slot of the entity that had it before
+	ids[slot] = id;
+	if (positions[slot] == position) return;
+
+	positions[slot] = position;
+	Moved(slot);
+}
+
+void SpatialIndex::Remove(EntityId id)
+{
+	if (id.index >= slots.size()) return;
+
+	const std::uint32_t slot = slots[id.index];
+	if (slot == invalid || ids[slot] != id) return;
+
+	Removing(slot);
+
+	const std::uint32_t last = static_cast<std::uint32_t>(ids.size() - 1);
+	if (slot != last) {
+		ids[slot] = ids[last];
+		positions[slot] = positions[last];
+		slots[ids[slot].index] = slot;
+		SlotMoved(last, slot);
+	}
+
+	ids.pop_back();
+	positions.pop_back();
+	slots[id.index] = invalid;
+}
+
+bool SpatialIndex::Contains(EntityId id) const
+{
+	return id.index < slots.size() && slots[id.index] != invalid && ids[slots[id.index]] == id;
+}
+
+void SpatialIndex::Clear()
+{
+	ids.clear();
+	positions.clear();
+	slots.clear();
+	linked.clear();
+	since = 0;
+	Cleared();
+}
+
+void SpatialIndex::QueryRadius(const Vec3* centers, const double* radii, std::size_t count, SpatialResults& out) const
+{
+	out.Clear();
+	out.offsets.reserve(count + 1);
+
+	// reused across calls, queries may run on several threads at once
+	static thread_local std::vector<std::uint32_t> candidates;
+	for (std::size_t i = 0; i < count; i++) {
+		const Vec3 extent(radii[i], radii[i], radii[i]);
+		const double sqrRadius = radii[i] * radii[i];
+
+		candidates.clear();
+		Candidates(centers[i] - extent, centers[i] + extent, candidates);
+		for (auto slot : candidates)
+			if (positions[slot].SqrDistance(centers[i]) <= sqrRadius) out.ids.push_back(ids[slot]);
+
+		out.offsets.push_back(out.ids.size());
+	}
+}
+
+void SpatialIndex::QueryBox(const Vec3* mins, const Vec3* maxs, std::size_t count, SpatialResults& out) const
+{
+	out.Clear();
+	out.offsets.reserve(count + 1);
+
+	// reused across calls, queries may run on several threads at once
+	static thread_local std::vector<std::uint32_t> candidates;
+	for (std::size_t i = 0; i < count; i++) {
+		const Vec3& min = mins[i];
+		const Vec3& max = maxs[i];
+
+		candidates.clear();
+		Candidates(min, max, candidates);
+		for (auto slot : candidates) {
+			const Vec3& p = positions[slot];
+			if (p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y && p.z >= min.z && p.z <= max.z)
+				out.ids.push_back(ids[slot]);
+		}
+
+		out.offsets.push_back(out.ids.size());
+	}
+}
+
+void SpatialIndex::QueryNearest(const Vec3* points, std::size_t count, std::size_t k, SpatialResults& out) const
+{
+	out.Clear();
+	out.offsets.reserve(count + 1);
+
+	static thread_local std::vector<std::uint32_t> nearest;
+	for (std::size_t i = 0; i < count; i++) {
+		nearest.clear();
+		if (k > 0 && !ids.empty()) Nearest(points[i], std::min(k, ids.size()), nearest);
+		for (auto slot : nearest) out.ids.push_back(ids[slot]);
+
+		out.offsets.push_back(out.ids.size());
+	}
+}
+
+std::vector<EntityId> SpatialIndex::QueryRadius(const Vec3& center, double radius) const
+{
+	SpatialResults results;
+	QueryRadius(&center, &radius, 1, results);
+	return std::move(results.ids);
+}
+
+std::vector<EntityId> SpatialIndex::QueryBox(const Vec3& min, const Vec3& max) const
+{
+	SpatialResults results;
+	QueryBox(&min, &max, 1, results);
+	return std::move(results.ids);
+}
+
+std::vector<EntityId> SpatialIndex::QueryNearest(const Vec3& point, std::size_t k) const
+{
+	SpatialResults results;
+	QueryNearest(&point, 1, k, results);
+	return std::move(results.ids);
+}
+
+void SpatialIndex::Nearest(const Vec3& point, std::size_t k, std::vector<std::uint32_t>& out) const
+{
+	// reused across calls, queries may run on several threads at once
+	static thread_local std::vector<std::uint32_t> candidates;
+	static thread_local std::vector<std::pair<double, std::uint32_t>> found;
+
+	// everything outside the sphere is further than everything in it, so once the sphere
+	// holds k the k nearest are among them
+	for (double radius = cellSize;; radius *= 2) {
+		const Vec3 extent(radius, radius, radius);
+		const double sqrRadius = radius * radius;
+
+		candidates.clear();
+		found.clear();
+		Candidates(point - extent, point + extent, candidates);
+		for (auto slot : candidates) {
+			const double d = positions[slot].SqrDistance(point);
+			if (d <= sqrRadius) found.emplace_back(d, slot);
+		}
+
+		if (found.size() >= k) break;
+	}
+
+	std::partial_sort(found.begin(), found.begin() + k, found.end());
+	for (std::size_t i = 0; i < k; i++) out.push_back(found[i].second);
+}
+
+// Hash grid
+
+// 21 bits per axis in the key, positions further out share the border cells
+static constexpr std::int32_t gridLimit = (1 << 20) - 1;
+
+HashGridIndex::HashGridIndex(double cellSize) : SpatialIndex(cellSize), inverseCellSize(1.0 / cellSize)
+{
+}
+
+HashGridIndex::Cell HashGridIndex::CellOf(const Vec3& p) const
+{
+	auto axis = [this](double v) {
+		const double c = std::floor(v * inverseCellSize);
+		return static_cast<std::int32_t>(std::max<double>(-gridLimit, std::min<double>(gridLimit, c)));
+	};
+	return Cell{ axis(p.x), axis(p.y), axis(p.z) };
+}
+
+std::uint64_t HashGridIndex::Key(const Cell& c)
+{
+	const std::uint64_t bias = gridLimit + 1;
+	return ((c.x + bias) << 42) | ((c.y + bias) << 21) | (c.z + bias);
+}
+
+void HashGridIndex::AddToCell(std::uint32_t slot, std::uint64_t key)
+{
+	std::vector<std::uint32_t>& cell = cells[key];
+	cellOf[slot] = key;
+	indexInCell[slot] = static_cast<std::uint32_t>(cell.size());
+	cell.push_back(slot);
+}
+
+void HashGridIndex::RemoveFromCell(std::uint32_t slot)
+{
+	auto it = cells.find(cellOf[slot]);
+	std::vector<std::uint32_t>& cell = it->second;
+
+	const std::uint32_t i = indexInCell[slot];
+	cell[i] = cell.back();
+	indexInCell[cell[i]] = i;
+	cell.pop_back();
+
+	if (cell.empty()) cells.erase(it);
+}
+
+void HashGridIndex::Inserted(std::uint32_t slot)
+{
+	if (slot >= cellOf.size()) {
+		cellOf.resize(slot + 1);
+		indexInCell.resize(slot + 1);
+	}
+
+	AddToCell(slot, Key(CellOf(positions[slot])));
+}
+
+void HashGridIndex::Moved(std::uint32_t slot)
+{
+	const std::uint64_t key = Key(CellOf(positions[slot]));
+	if (key == cellOf[slot]) return;
+
+	RemoveFromCell(slot);
+	AddToCell(slot, key);
+}
+
+void HashGridIndex::Removing(std::uint32_t slot)
+{
+	RemoveFromCell(slot);
+}
+
+void HashGridIndex::SlotMoved(std::uint32_t from, std::uint32_t to)
+{
+	cells[cellOf[from]][indexInCell[from]] = to;
+	cellOf[to] = cellOf[from];
+	indexInCell[to] = indexInCell[from];
+}
+
+void HashGridIndex::Cleared()
+{
+	cells.clear();
+	cellOf.clear();
+	indexInCell.clear();
+}
+
+void HashGridIndex::Candidates(const Vec3& min, const Vec3& max, std::vector<std::uint32_t>& out) const
+{
+	if (cells.empty() || !IsFinite(min) || !IsFinite(max)) return;
+
+	const Cell a = CellOf(min);
+	const Cell b = CellOf(max);
+	if (a.x > b.x || a.y > b.y || a.z > b.z) return;
+
+	const double spanned = (b.x - a.x + 1.0) * (b.y - a.y + 1.0) * (b.z - a.z + 1.0);
+
+	// big boxes walk the occupied cells instead of every cell they cover
+	if (spanned > static_cast<double>(cells.size())) {
+		const std::uint64_t mask = (1u << 21) - 1;
+		const std::int64_t bias = gridLimit + 1;
+		for (auto& cell : cells) {
+			const std::int64_t x = static_cast<std::int64_t>((cell.first >> 42) & mask) - bias;
+			const std::int64_t y = static_cast<std::int64_t>((cell.first >> 21) & mask) - bias;
+			const std::int64_t z = static_cast<std::int64_t>(cell.first & mask) - bias;
+			if (x >= a.x && x <= b.x && y >= a.y && y <= b.y && z >= a.z && z <= b.z)
+				out.insert(out.end(), cell.second.begin(), cell.second.end());
+		}
+		return;
+	}
+
+	for (std::int32_t x = a.x; x <= b.x; x++) {
+		for (std::int32_t y = a.y; y <= b.y; y++) {
+			for (std::int32_t z = a.z; z <= b.z; z++) {
+				auto it = cells.find(Key(Cell{ x, y, z }));
+				if (it != cells.end()) out.insert(out.end(), it->second.begin(), it->second.end());
+			}
+		}
+	}
+}
+
+// Loose octree
+
+static int Octant(const Vec3& p, const Vec3& center)
+{
+	return (p.x >= center.x ? 1 : 0) | (p.y >= center.y ? 2 : 0) | (p.z >= center.z ? 4 : 0);
+}
+
+static Vec3 ChildCenter(const Vec3& center, double half, int octant)
+{
+	const double q = half * 0.5;
+	return Vec3(center.x + (octant & 1 ? q : -q), center.y + (octant & 2 ? q : -q), center.z + (octant & 4 ? q : -q));
+}
+
+LooseOctreeIndex::LooseOctreeIndex(double cellSize) : SpatialIndex(cellSize), root(-1), minHalf(cellSize / 1024)
+{
+}
+
+std::int32_t LooseOctreeIndex::AddNode(const Vec3& center, double half, std::int32_t parent)
+{
+	std::int32_t index;
+	if (!freeNodes.empty()) {
+		index = freeNodes.back();
+		freeNodes.pop_back();
+	}
+	else {
+		index = static_cast<std::int32_t>(nodes.size());
+		nodes.emplace_back();
+	}
+
+	// a reused node keeps the capacity of its items
+	Node& node = nodes[index];
+	node.center = center;
+	node.half = half;
+	std::fill(std::begin(node.children), std::end(node.children), -1);
+	node.parent = parent;
+	node.count = 0;
+	node.items.clear();
+	return index;
+}
+
+bool LooseOctreeIndex::InLooseBounds(const Node& node, const Vec3& p) const
+{
+	const double extent = node.half * looseness;
+	return std::abs(p.x - node.center.x) <= extent && std::abs(p.y - node.center.y) <= extent && std::abs(p.z - node.center.z) <= extent;
+}
+
+double LooseOctreeIndex::SqrDistanceTo(const Node& node, const Vec3& p) const
+{
+	const double extent = node.half * looseness;
+	const double dx = std::max(0.0, std::abs(p.x - node.center.x) - extent);
+	const double dy = std::max(0.0, std::abs(p.y - node.center.y) - extent);
+	const double dz = std::max(0.0, std::abs(p.z - node.center.z) - extent);
+	return dx * dx + dy * dy + dz * dz;
+}
+
+void LooseOctreeIndex::Enclose(const Vec3& p)
+{
+	if (root < 0) {
+		root = AddNode(p, cellSize, -1);
+		return;
+	}
+
+	for (;;) {
+		const Vec3 center = nodes[root].center;
+		const double half = nodes[root].half;
+		if (std::abs(p.x - center.x) <= half && std::abs(p.y - center.y) <= half && std::abs(p.z - center.z) <= half) return;
+
+		// twice the size, stepped towards p, the old root becomes one of its children
+		const Vec3 grown(center.x + (p.x >= center.x ? half : -half), center.y + (p.y >= center.y ? half : -half), center.z + (p.z >= center.z ? half : -half));
+		const std::int32_t next = AddNode(grown, half * 2, -1);
+		const int oldOctant = Octant(center, grown);
+
+		for (int o = 0; o < 8; o++) {
+			const std::int32_t child = o == oldOctant ? root : AddNode(ChildCenter(grown, half * 2, o), half, next);
+			nodes[next].children[o] = child;
+		}
+		nodes[root].parent = next;
+		nodes[next].count = nodes[root].count;
+		root = next;
+	}
+}
+
+void LooseOctreeIndex::Split(std::int32_t node)
+{
+	const Vec3 center = nodes[node].center;
+	const double half = nodes[node].half;
+
+	for (int o = 0; o < 8; o++) {
+		const std::int32_t child = AddNode(ChildCenter(center, half, o), half * 0.5, node);
+		nodes[node].children[o] = child;
+	}
+
+	// points that moved too far from the middle for their child stay here
+	std::vector<std::uint32_t> items;
+	items.swap(nodes[node].items);
+	for (auto slot : items) {
+		std::int32_t target = nodes[node].children[Octant(positions[slot], center)];
+		if (!InLooseBounds(nodes[target], positions[slot])) target = node;
+
+		nodeOf[slot] = target;
+		indexInNode[slot] = static_cast<std::uint32_t>(nodes[target].items.size());
+		nodes[target].items.push_back(slot);
+		if (target != node) nodes[target].count++;
+	}
+}
+
+void LooseOctreeIndex::Collapse(std::int32_t node)
+{
+	static thread_local std::vector<std::int32_t> stack;
+	stack.assign(std::begin(nodes[node].children), std::end(nodes[node].children));
+	std::fill(std::begin(nodes[node].children), std::end(nodes[node].children), -1);
+
+	while (!stack.empty()) {
+		const std::int32_t n = stack.back();
+		stack.pop_back();
+
+		// loose bounds of a child lie inside its parent's, so every point still fits up here
+		for (auto slot : nodes[n].items) {
+			nodeOf[slot] = node;
+			indexInNode[slot] = static_cast<std::uint32_t>(nodes[node].items.size());
+			nodes[node].items.push_back(slot);
+		}
+		if (nodes[n].children[0] >= 0) stack.insert(stack.end(), std::begin(nodes[n].children), std::end(nodes[n].children));
+		freeNodes.push_back(n);
+	}
+}
+
+void LooseOctreeIndex::Place(std::uint32_t slot)
+{
+	const Vec3& p = positions[slot];
+	Enclose(p);
+
+	std::int32_t n = root;
+	nodes[n].count++;
+	for (;;) {
+		const Node& node = nodes[n];
+		if (node.children[0] >= 0) {
+			n = node.children[Octant(p, node.center)];
+			nodes[n].count++;
+		}
+		else if (node.items.size() >= leafCapacity && node.half > minHalf) Split(n);
+		else break;
+	}
+
+	nodeOf[slot] = n;
+	indexInNode[slot] = static_cast<std::uint32_t>(nodes[n].items.size());
+	nodes[n].items.push_back(slot);
+}
+
+void LooseOctreeIndex::RemoveFromNode(std::uint32_t slot)
+{
+	std::vector<std::uint32_t>& items = nodes[nodeOf[slot]].items;
+
+	const std::uint32_t i = indexInNode[slot];
+	items[i] = items.back();
+	indexInNode[items[i]] = i;
+	items.pop_back();
+
+	// counts only shrink going down, so the highest ancestor light enough to fold covers all of them
+	std::int32_t fold = -1;
+	for (std::int32_t n = nodeOf[slot]; n >= 0; n = nodes[n].parent) {
+		nodes[n].count--;
+		if (nodes[n].children[0] >= 0 && nodes[n].count <= collapseCapacity) fold = n;
+	}
+	if (fold >= 0) Collapse(fold);
+}
+
+void LooseOctreeIndex::Inserted(std::uint32_t slot)
+{
+	if (slot >= nodeOf.size()) {
+		nodeOf.resize(slot + 1);
+		indexInNode.resize(slot + 1);
+	}
+
+	Place(slot);
+}
+
+void LooseOctreeIndex::Moved(std::uint32_t slot)
+{
+	// anywhere inside the loose bounds is still fine for the node it is in
+	if (InLooseBounds(nodes[nodeOf[slot]], positions[slot])) return;
+
+	RemoveFromNode(slot);
+	Place(slot);
+}
+
+void LooseOctreeIndex::Removing(std::uint32_t slot)
+{
+	RemoveFromNode(slot);
+}
+
+void LooseOctreeIndex::SlotMoved(std::uint32_t from, std::uint32_t to)
+{
+	nodes[nodeOf[from]].items[indexInNode[from]] = to;
+	nodeOf[to] = nodeOf[from];
+	indexInNode[to] = indexInNode[from];
+}
+
+void LooseOctreeIndex::Cleared()
+{
+	nodes.clear();
+	freeNodes.clear();
+	root = -1;
+	nodeOf.clear();
+	indexInNode.clear();
+}
+
+void LooseOctreeIndex::Candidates(const Vec3& min, const Vec3& max, std::vector<std::uint32_t>& out) const
+{
+	if (root < 0) return;
+
+	static thread_local std::vector<std::int32_t> stack;
+	stack.assign(1, root);
+	while (!stack.empty()) {
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+
+		const double extent = node.half * looseness;
+		if (node.center.x + extent < min.x || node.center.x - extent > max.x ||
+			node.center.y + extent < min.y || node.center.y - extent > max.y ||
+			node.center.z + extent < min.z || node.center.z - extent > max.z) continue;
+
+		out.insert(out.end(), node.items.begin(), node.items.end());
+		if (node.children[0] >= 0) stack.insert(stack.end(), std::begin(node.children), std::end(node.children));
+	}
+}
+
+void LooseOctreeIndex::Nearest(const Vec3& point, std::size_t k, std::vector<std::uint32_t>& out) const
+{
+	if (root < 0) return;
+
+	// heaps kept in reused vectors, queries may run on several threads at once.
+	// open has the closest node on top, best the furthest of the k best points so far.
+	using NodeEntry = std::pair<double, std::int32_t>;
+	using PointEntry = std::pair<double, std::uint32_t>;
+	static thread_local std::vector<NodeEntry> open;
+	static thread_local std::vector<PointEntry> best;
+	const auto closer = std::greater<NodeEntry>();
+
+	open.assign(1, { SqrDistanceTo(nodes[root], point), root });
+	best.clear();
+
+	// stops once the closest node left is further than the k-th best point
+	while (!open.empty()) {
+		const NodeEntry next = open.front();
+		if (best.size() == k && next.first > best.front().first) break;
+		std::pop_heap(open.begin(), open.end(), closer);
+		open.pop_back();
+
+		const Node& node = nodes[next.second];
+		for (auto slot : node.items) {
+			const double d = positions[slot].SqrDistance(point);
+			if (best.size() < k) {
+				best.emplace_back(d, slot);
+				std::push_heap(best.begin(), best.end());
+			}
+			else if (d < best.front().first) {
+				std::pop_heap(best.begin(), best.end());
+				best.back() = { d, slot };
+				std::push_heap(best.begin(), best.end());
+			}
+		}
+
+		if (node.children[0] < 0) continue;
+		for (auto child : node.children) {
+			// empty leaves are common, half the octants of a flat world are
+			if (nodes[child].children[0] < 0 && nodes[child].items.empty()) continue;
+
+			const double d = SqrDistanceTo(nodes[child], point);
+			if (best.size() < k || d <= best.front().first) {
+				open.emplace_back(d, child);
+				std::push_heap(open.begin(), open.end(), closer);
+			}
+		}
+	}
+
+	std::sort_heap(best.begin(), best.end());
+	for (auto& entry : best) out.push_back(entry.second);
+}
@@ -0,0 +1,210 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "ECS.h"
+#include "EntityId.h"
+#include "Vec3.h"
+
+class EntityManager;
+
+enum class SpatialIndexType {
+	// Uniform grid of cubic cells hashed into a map, best when entities are spread evenly
+	// and queries are about the size of a cell
+	HashGrid,
+	// Octree whose nodes hold points up to twice their size out, copes with clustered
+	// entities and widely varying query sizes, small moves don't touch the tree
+	LooseOctree,
+};
+
+// Results of a batch of queries, query i found ids[offsets[i], offsets[i + 1])
+struct SpatialResults {
+	std::vector<EntityId> ids;
+	std::vector<std::size_t> offsets;
+
+	std::size_t QueryCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+	std::size_t Count(std::size_t query) const { return offsets[query + 1] - offsets[query]; }
+	const EntityId* Begin(std::size_t query) const { return ids.data() + offsets[query]; }
+	const EntityId* End(std::size_t query) const { return ids.data() + offsets[query + 1]; }
+
+	void Clear() {
+		ids.clear();
+		offsets.assign(1, 0);
+	}
+};
+
+// Positions of entities, searchable by sphere, box and nearest neighbours. Created through
+// EntityManager::CreateSpatialIndex it follows every entity with a Transform: Update only
+// looks at chunks whose Transform changed since the last Update, destroyed entities are
+// dropped through OnDestroy / OnRemove observers. Positions are world positions: for entities
+// linked in the TransformHierarchy they come from its world matrices, which also follow their
+// ancestors, for the rest that is just Transform::position.
+// Queries reflect the world as of the last Update.
+class SpatialIndex {
+public:
+	// cellSize is the grid cell edge, or the octree's starting node size and nearest search step
+	static std::unique_ptr<SpatialIndex> Create(SpatialIndexType type, double cellSize);
+
+	SpatialIndex(double cellSize);
+	virtual ~SpatialIndex();
+
+	void Update(EntityManager& manager);
+
+	// Inserts or moves the entity
+	void Set(EntityId id, const Vec3& position);
+	// Ignored for stale ids, a newer entity in the same slot stays
+	void Remove(EntityId id);
+	bool Contains(EntityId id) const;
+	void Clear();
+
+	std::size_t Size() const { return ids.size(); }
+	double GetCellSize() const { return cellSize; }
+
+	// Batched queries, out is cleared and gets one result list per query, in no particular order
+	// except for QueryNearest, which sorts nearest first
+	void QueryRadius(const Vec3* centers, const double* radii, std::size_t count, SpatialResults& out) const;
+	void QueryBox(const Vec3* mins, const Vec3* maxs, std::size_t count, SpatialResults& out) const;
+	// The k closest entities to every point, fewer when the index holds fewer
+	void QueryNearest(const Vec3* points, std::size_t count, std::size_t k, SpatialResults& out) const;
+
+	std::vector<EntityId> QueryRadius(const Vec3& center, double radius) const;
+	std::vector<EntityId> QueryBox(const Vec3& min, const Vec3& max) const;
+	std::vector<EntityId> QueryNearest(const Vec3& point, std::size_t k) const;
+
+protected:
+	static constexpr std::uint32_t invalid = ~std::uint32_t(0);
+
+	// Backends keep their own per slot data next to the arrays below.
+	// positions[slot] is set before Inserted and Moved are called.
+	virtual void Inserted(std::uint32_t slot) = 0;
+	virtual void Moved(std::uint32_t slot) = 0;
+	// slot is about to go, then last is moved into it unless they are the same
+	virtual void Removing(std::uint32_t slot) = 0;
+	virtual void SlotMoved(std::uint32_t from, std::uint32_t to) = 0;
+	virtual void Cleared() = 0;
+
+	// Appends at least every slot inside the box, the caller does the exact test
+	virtual void Candidates(const Vec3& min, const Vec3& max, std::vector<std::uint32_t>& out) const = 0;
+	// Appends the k nearest slots, nearest first. Widens a box search until it holds k unless a
+	// backend knows better.
+	virtual void Nearest(const Vec3& point, std::size_t k, std::vector<std::uint32_t>& out) const;
+
+	const double cellSize;
+
+	// dense, swap and pop on removal
+	std::vector<EntityId> ids;
+	std::vector<Vec3> positions;
+	// id index -> slot
+	std::vector<std::uint32_t> slots;
+
+private:
+	SpatialIndex(SpatialIndex& other) = delete;
+	void operator=(const SpatialIndex&) = delete;
+
+	// Changed<Transform> ticks already looked at, compared inclusively so nothing stamped in
+	// the frame of the last Update is missed
+	Tick since;
+	// hierarchy nodes as of the last Update, ones unlinked since go back to their local position
+	std::vector<EntityId> linked;
+
+};
+
+class HashGridIndex : public SpatialIndex {
+public:
+	HashGridIndex(double cellSize);
+
+protected:
+	void Inserted(std::uint32_t slot) override;
+	void Moved(std::uint32_t slot) override;
+	void Removing(std::uint32_t slot) override;
+	void SlotMoved(std::uint32_t from, std::uint32_t to) override;
+	void Cleared() override;
+	void Candidates(const Vec3& min, const Vec3& max, std::vector<std::uint32_t>& out) const override;
+
+private:
+	struct Cell {
+		std::int32_t x, y, z;
+	};
+
+	Cell CellOf(const Vec3& p) const;
+	static std::uint64_t Key(const Cell& c);
+	void AddToCell(std::uint32_t slot, std::uint64_t key);
+	void RemoveFromCell(std::uint32_t slot);
+
+	const double inverseCellSize;
+	std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> cells;
+
+	// per slot
+	std::vector<std::uint64_t> cellOf;
+	std::vector<std::uint32_t> indexInCell;
+
+};
+
+class LooseOctreeIndex : public SpatialIndex {
+public:
+	LooseOctreeIndex(double cellSize);
+
+	// Nodes allocated, freed ones waiting for reuse included, for tests and diagnostics
+	std::size_t NodeCount() const { return nodes.size(); }
+
+protected:
+	void Inserted(std::uint32_t slot) override;
+	void Moved(std::uint32_t slot) override;
+	void Removing(std::uint32_t slot) override;
+	void SlotMoved(std::uint32_t from, std::uint32_t to) override;
+	void Cleared() override;
+	void Candidates(const Vec3& min, const Vec3& max, std::vector<std::uint32_t>& out) const override;
+	void Nearest(const Vec3& point, std::size_t k, std::vector<std::uint32_t>& out) const override;
+
+private:
+	// a node holds points within looseness times its half size of its center
+	static constexpr double looseness = 2.0;
+	// points a leaf takes before it splits
+	static constexpr std::size_t leafCapacity = 16;
+	// a subtree holding this many points or fewer folds back into its top node, well under
+	// leafCapacity so a node hovering around it doesn't split and collapse every frame
+	static constexpr std::size_t collapseCapacity = leafCapacity / 2;
+
+	struct Node {
+		Vec3 center;
+		double half;
+		// -1 for none, either all or none are set
+		std::int32_t children[8];
+		// -1 for the root
+		std::int32_t parent;
+		// points in this node and every node below it
+		std::size_t count;
+		std::vector<std::uint32_t> items;
+	};
+
+	// Reuses a freed node if there is one
+	std::int32_t AddNode(const Vec3& center, double half, std::int32_t parent);
+	// Grows the root until p is inside it
+	void Enclose(const Vec3& p);
+	void Place(std::uint32_t slot);
+	void Split(std::int32_t node);
+	// Moves every point below node into it and frees its descendants
+	void Collapse(std::int32_t node);
+	void RemoveFromNode(std::uint32_t slot);
+	bool InLooseBounds(const Node& node, const Vec3& p) const;
+	// squared distance from p to the nodes loose bounds, 0 inside
+	double SqrDistanceTo(const Node& node, const Vec3& p) const;
+
+	std::vector<Node> nodes;
+	// indices of collapsed nodes, handed out again by AddNode
+	std::vector<std::int32_t> freeNodes;
+	std::int32_t root;
+	// splitting stops at this half size, so piles of points in one spot end up in one leaf
+	const double minHalf;
+
+	// per slot
+	std::vector<std::int32_t> nodeOf;
+	std::vector<std::uint32_t> indexInNode;
+
+};
+
+#endif
@@ -0,0 +1,23 @@
+#include "System.h"
+#include "EntityManager.h"
+
+#include <algorithm>
+
+static bool Overlaps(const std::vector<TypeID>& a, const std::vector<TypeID>& b)
+{
+	for (TypeID id : a)
+		if (std::find(b.begin(), b.end(), id) != b.end()) return true;
+	return false;
+}
+
+bool System::ConflictsWith(const System& other) const
+{
+	if (exclusive || other.exclusive) return true;
+
+	return Overlaps(writes, other.writes) || Overlaps(writes, other.reads) || Overlaps(reads, other.writes);
+}
+
+void ComponentUpdateSystem::Update(EntityManager& manager)
+{
+	for (auto& e : *manager.GetEntities()) e->Update();
+}
@@ -0,0 +1,69 @@
+#ifndef SYSTEM_H
+#define SYSTEM_H
+
+#include <type_traits>
+#include <vector>
+
+#include "ECS.h"
+
+class EntityManager;
+
+// A unit of work the Scheduler runs once per frame.
+// Systems declare which component types they read and write, systems that don't
+// conflict are run at the same time. Structural changes (adding / removing components,
+// creating / destroying entities) are not safe from a non exclusive system.
+class System {
+public:
+	System() : exclusive(false), name("System") {};
+	virtual ~System() {};
+
+	virtual void Update(EntityManager& manager) = 0;
+
+	const std::vector<TypeID>& GetReads() const { return reads; }
+	const std::vector<TypeID>& GetWrites() const { return writes; }
+	bool IsExclusive() const { return exclusive; }
+	// Shown by the profiler
+	const char* GetName() const { return name; }
+
+	// Two systems conflict when either writes a type the other one touches
+	bool ConflictsWith(const System& other) const;
+
+protected:
+	template<typename... Ts>
+	inline void Reads() { (reads.push_back(getCompTypeID<Ts>()), ...); }
+
+	template<typename... Ts>
+	inline void Writes() { (writes.push_back(getCompTypeID<Ts>()), ...); }
+
+	// Same convention as View, const types are read, everything else is written
+	template<typename... Ts>
+	inline void Accesses() {
+		((std::is_const<Ts>::value ? reads.push_back(getCompTypeID<std::remove_const_t<Ts>>()) : writes.push_back(getCompTypeID<std::remove_const_t<Ts>>())), ...);
+	}
+
+	// Exclusive systems may touch anything and never run alongside another system
+	void SetExclusive() { exclusive = true; }
+
+	// name has to outlive the system, a string literal is the usual choice
+	void SetName(const char* name) { this->name = name; }
+
+private:
+	std::vector<TypeID> reads;
+	std::vector<TypeID> writes;
+	bool exclusive;
+	const char* name;
+
+};
+
+// Calls the virtual Update of every component on every entity, the old serial update
+class ComponentUpdateSystem : public System {
+public:
+	ComponentUpdateSystem() {
+		SetExclusive();
+		SetName("ComponentUpdateSystem");
+	}
+
+	void Update(EntityManager& manager) override;
+};
+
+#endif
@@ -10,6 +10,8 @@ public:
 	Transform() : position(Vec3::zero), rotation(Quat::identity), scale(Vec3::one) {};
 	Transform(Vec3 pos, Quat rot, Vec3 scl) : position(pos), rotation(rot), scale(scl) {};
 
+	static constexpr bool bitwiseSnapshot = true;
+
 	Vec3 position;
 	Quat rotation;
 	Vec3 scale;
@@ -19,4 +21,6 @@ private:
 
 };
 
+ECS_REGISTER_COMPONENT(Transform, 0)
+
 #endif
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "TransformBuffer.h"
+#include "EntityManager.h"
+#include "Profiler.h"
+
+#include <cmath>
+
+// Splits an affine world matrix back into translation, rotation and per axis scale. A mirrored
+// matrix gets a negative x scale, shear from non uniform scale under rotation is lost.
+static void Decompose(const TransformHierarchy::Matrix& m, Vec3& position, Quat& rotation, Vec3& scale)
+{
+	position = Vec3(m[12], m[13], m[14]);
+
+	double s[3];
+	for (int c = 0; c < 3; c++) s[c] = std::sqrt(m[c * 4] * m[c * 4] + m[c * 4 + 1] * m[c * 4 + 1] + m[c * 4 + 2] * m[c * 4 + 2]);
+
+	const double det = m[0] * (m[5] * m[10] - m[9] * m[6]) - m[4] * (m[1] * m[10] - m[9] * m[2]) + m[8] * (m[1] * m[6] - m[5] * m[2]);
+	if (det < 0) s[0] = -s[0];
+	scale = Vec3(s[0], s[1], s[2]);
+
+	// a zero scale leaves no rotation to recover
+	if (s[0] == 0 || s[1] == 0 || s[2] == 0) {
+		rotation = Quat::identity;
+		return;
+	}
+
+	TransformHierarchy::Matrix r{};
+	for (int c = 0; c < 3; c++)
+		for (int row = 0; row < 3; row++) r[c * 4 + row] = m[c * 4 + row] / s[c];
+	r[15] = 1;
+	rotation = Quat::FromMatrix(r).Normalize();
+}
+
+void TransformFrame::Interpolate(float alpha, std::vector<Vec3>& outPositions, std::vector<Quat>& outRotations, std::vector<Vec3>& outScales) const
+{
+	const std::size_t n = Size();
+	outPositions.resize(n);
+	outRotations.resize(n);
+	outScales.resize(n);
+
+	// plain loops over contiguous arrays, the compiler vectorizes them
+	for (std::size_t i = 0; i < n; i++) outPositions[i] = Vec3::Lerp(previousPositions[i], positions[i], alpha);
+	for (std::size_t i = 0; i < n; i++) outScales[i] = Vec3::Lerp(previousScales[i], scales[i], alpha);
+
+	// the batch takes a t per quaternion
+	static thread_local std::vector<float> t;
+	t.assign(n, alpha);
+	Quat::SlerpBatch(previousRotations.data(), rotations.data(), t.data(), outRotations.data(), n);
+}
+
+TransformBuffer::TransformBuffer() : latest(1), back(0), last(1), published(0), front(2)
+{
+}
+
+void TransformBuffer::Publish(EntityManager& manager)
+{
+	ECS_PROFILE_SCOPE("TransformBuffer::Publish");
+
+	TransformFrame& f = frames[back];
+	// frames[last] is either waiting in latest or held by the reader, both only read it
+	const TransformFrame& previous = frames[last];
+	const bool hasPrevious = published > 0;
+
+	f.ids.clear();
+	f.positions.clear();
+	f.previousPositions.clear();
+	f.rotations.clear();
+	f.previousRotations.clear();
+	f.scales.clear();
+	f.previousScales.clear();
+
+	const TransformHierarchy& hierarchy = *manager.GetHierarchy();
+	const bool anyLinked = hierarchy.Size() != 0;
+
+	manager.view<const Transform>().each([&](Entity& e, const Transform& t) {
+		const EntityId id = e.GetId();
+		if (id.index >= slots.size()) slots.resize(id.index + 1, 0);
+
+		// linked entities publish where they are in the world, not relative to their parent
+		Vec3 position = t.position;
+		Quat rotation = t.rotation;
+		Vec3 scale = t.scale;
+		if (anyLinked) {
+			const TransformHierarchy::Matrix* world = hierarchy.GetWorldMatrix(id);
+			if (world) Decompose(*world, position, rotation, scale);
+		}
+
+		const std::uint32_t slot = slots[id.index];
+		if (hasPrevious && slot < previous.Size() && previous.ids[slot] == id) {
+			f.previousPositions.push_back(previous.positions[slot]);
+			f.previousRotations.push_back(previous.rotations[slot]);
+			f.previousScales.push_back(previous.scales[slot]);
+		}
+		else {
+			f.previousPositions.push_back(position);
+			f.previousRotations.push_back(rotation);
+			f.previousScales.push_back(scale);
+		}
+
+		slots[id.index] = static_cast<std::uint32_t>(f.ids.size());
+		f.ids.push_back(id);
+		f.positions.push_back(position);
+		f.rotations.push_back(rotation);
+		f.scales.push_back(scale);
+	});
+
+	f.frame = ++published;
+
+	// hands the frame over and takes back whichever one was waiting, the reader never has it
+	last = back;
+	back = latest.exchange(back | fresh, std::memory_order_acq_rel) & indexMask;
+}
+
+const TransformFrame& TransformBuffer::Acquire()
+{
+	if (latest.load(std::memory_order_relaxed) & fresh)
+		front = latest.exchange(front, std::memory_order_acq_rel) & indexMask;
+
+	return frames[front];
+}
+
+bool TransformBuffer::HasNewFrame() const
+{
+	return (latest.load(std::memory_order_relaxed) & fresh) != 0;
+}
@@ -0,0 +1,77 @@
+#ifndef TRANSFORM_BUFFER_H
+#define TRANSFORM_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "EntityId.h"
+#include "Transform.h"
+
+class EntityManager;
+
+// Transforms of every entity as of the end of one Update, plus where each of them was at
+// the end of the Update before, in the same order. Entities new this frame have the
+// previous state equal to the current one.
+struct TransformFrame {
+	// counts publishes, 0 for a frame that was never published
+	std::uint64_t frame = 0;
+
+	std::vector<EntityId> ids;
+	std::vector<Vec3> positions, previousPositions;
+	std::vector<Quat> rotations, previousRotations;
+	std::vector<Vec3> scales, previousScales;
+
+	std::size_t Size() const { return ids.size(); }
+
+	// Blends previous towards current by alpha, 0 gives the previous frame and 1 this one.
+	// Positions and scales use Vec3::Lerp, rotations Quat::SlerpBatch. The outputs are resized
+	// to Size() and line up with ids.
+	void Interpolate(float alpha, std::vector<Vec3>& outPositions, std::vector<Quat>& outRotations, std::vector<Vec3>& outScales) const;
+};
+
+// Read only copy of Transform data published once a frame, so one other thread, e.g. a
+// renderer or the network, can read a consistent frame while the next one is simulated.
+// Created through EntityManager::CreateTransformBuffer it is published at the end of every
+// Update. Three frames rotate between the writer, the reader and the latest published one,
+// neither side ever waits for or locks the other.
+// Everything is in world space: entities linked in the TransformHierarchy are taken from its
+// world matrices, the rest straight from their Transform.
+class TransformBuffer {
+public:
+	TransformBuffer();
+
+	// Writer side, only ever called from the thread updating the world
+	void Publish(EntityManager& manager);
+
+	// Reader side, a single thread. Returns the latest published frame, which stays untouched
+	// until the next Acquire. Before the first Publish it is empty with frame 0.
+	const TransformFrame& Acquire();
+	// Whether a frame newer than the last acquired one is waiting
+	bool HasNewFrame() const;
+
+private:
+	TransformBuffer(TransformBuffer& other) = delete;
+	void operator=(const TransformBuffer&) = delete;
+
+	// set in latest when the frame there hasn't been acquired yet
+	static constexpr unsigned int fresh = 4;
+	static constexpr unsigned int indexMask = 3;
+
+	TransformFrame frames[3];
+
+	// frame index, plus fresh, swapped between the two sides
+	std::atomic<unsigned int> latest;
+	// owned by the writer
+	unsigned int back;
+	// the frame published last, the writer still reads its states for the next previous ones
+	unsigned int last;
+	std::uint64_t published;
+	// id index -> slot in the frame that id was last published in, checked against its ids
+	std::vector<std::uint32_t> slots;
+	// owned by the reader
+	unsigned int front;
+
+};
+
+#endif
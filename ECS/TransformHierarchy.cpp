@@ -0,0 +1,227 @@
+#include "TransformHierarchy.h"
+#include "EntityManager.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+// Scale, then rotate, then translate
+static void Compose(const Vec3& position, const Quat& rotation, const Vec3& scale, TransformHierarchy::Matrix& out)
+{
+	TransformHierarchy::Matrix r = rotation.ToMatrix();
+	const double s[3] = { scale.x, scale.y, scale.z };
+
+	for (int c = 0; c < 3; c++) {
+		for (int row = 0; row < 3; row++)
+			out[c * 4 + row] = r[c * 4 + row] * s[c];
+		out[c * 4 + 3] = 0;
+	}
+
+	out[12] = position.x;
+	out[13] = position.y;
+	out[14] = position.z;
+	out[15] = 1;
+}
+
+// out = a * b, both affine so the bottom row is always 0 0 0 1
+static void Multiply(const TransformHierarchy::Matrix& a, const TransformHierarchy::Matrix& b, TransformHierarchy::Matrix& out)
+{
+	for (int c = 0; c < 4; c++) {
+		for (int row = 0; row < 3; row++)
+			out[c * 4 + row] = a[row] * b[c * 4] + a[4 + row] * b[c * 4 + 1] + a[8 + row] * b[c * 4 + 2] + a[12 + row] * b[c * 4 + 3];
+		out[c * 4 + 3] = 0;
+	}
+	out[15] = 1;
+}
+
+// Destroyed entities and ones whose Transform was removed drop out of the hierarchy
+static bool IsLinkable(EntityManager& manager, EntityId id)
+{
+	Entity* e = manager.GetEntity(id);
+	return e != nullptr && e->transform != nullptr;
+}
+
+TransformHierarchy::TransformHierarchy() : structureChanged(false), transformsLost(0), since(0)
+{
+}
+
+bool TransformHierarchy::SetParent(EntityId child, EntityId parent)
+{
+	if (child.IsNull() || child == parent) return false;
+
+	// no cycles, child must not be above parent
+	for (EntityId p = parent; !p.IsNull(); p = GetParent(p))
+		if (p == child) return false;
+
+	Detach(child);
+
+	if (parent.IsNull()) Prune(child);
+	else {
+		links[child].parent = parent;
+		links[parent].children.push_back(child);
+	}
+
+	structureChanged = true;
+	return true;
+}
+
+EntityId TransformHierarchy::GetParent(EntityId child) const
+{
+	auto it = links.find(child);
+	return it != links.end() ? it->second.parent : EntityId::null;
+}
+
+const std::vector<EntityId>& TransformHierarchy::GetChildren(EntityId parent) const
+{
+	static const std::vector<EntityId> none;
+
+	auto it = links.find(parent);
+	return it != links.end() ? it->second.children : none;
+}
+
+bool TransformHierarchy::Contains(EntityId id) const
+{
+	return links.count(id) != 0;
+}
+
+void TransformHierarchy::Update(EntityManager& manager)
+{
+	ECS_PROFILE_SCOPE("TransformHierarchy::Update");
+
+	// nodes can only have gone if some entity lost its Transform since the last look
+	const std::uint64_t lost = manager.GetStorage()->GetTransformsLost();
+	if (lost != transformsLost) {
+		transformsLost = lost;
+		for (std::size_t i = 0; i < order.size() && !structureChanged; i++)
+			if (!IsLinkable(manager, order[i])) structureChanged = true;
+	}
+	// composes every local, so the nodes start out dirty
+	if (structureChanged) Rebuild(manager);
+
+	// whole chunks pass the filter, the compare skips the nodes in them that didn't move
+	const Tick now = manager.GetStorage()->GetTick();
+	if (!order.empty()) {
+		manager.view<const Transform>().filter<Changed<Transform>>(since).each([&](Entity& e, const Transform& t) {
+			const std::uint32_t i = FindSlot(e.GetId());
+			if (i == order.size()) return;
+			if (t.position == positions[i] && t.rotation == rotations[i] && t.scale == scales[i]) return;
+
+			positions[i] = t.position;
+			rotations[i] = t.rotation;
+			scales[i] = t.scale;
+			Compose(t.position, t.rotation, t.scale, locals[i]);
+			dirty[i] = 1;
+		});
+	}
+	since = now;
+
+	// parents come first, so a dirty parent is always resolved before its children look at it
+	for (std::size_t i = 0; i < order.size(); i++) {
+		std::int32_t p = parents[i];
+		if (p >= 0 && dirty[p]) dirty[i] = 1;
+		if (!dirty[i]) continue;
+
+		if (p < 0) worlds[i] = locals[i];
+		else Multiply(worlds[p], locals[i], worlds[i]);
+	}
+
+	std::fill(dirty.begin(), dirty.end(), 0);
+}
+
+const TransformHierarchy::Matrix* TransformHierarchy::GetWorldMatrix(EntityId id) const
+{
+	const std::uint32_t i = FindSlot(id);
+	return i != order.size() ? &worlds[i] : nullptr;
+}
+
+Vec3 TransformHierarchy::GetWorldPosition(EntityId id) const
+{
+	const Matrix* m = GetWorldMatrix(id);
+	return m ? Vec3((*m)[12], (*m)[13], (*m)[14]) : Vec3::zero;
+}
+
+void TransformHierarchy::Detach(EntityId child)
+{
+	auto it = links.find(child);
+	if (it == links.end() || it->second.parent.IsNull()) return;
+
+	EntityId parent = it->second.parent;
+	it->second.parent = EntityId::null;
+
+	auto& siblings = links[parent].children;
+	siblings.erase(std::find(siblings.begin(), siblings.end(), child));
+	Prune(parent);
+}
+
+void TransformHierarchy::Prune(EntityId id)
+{
+	// a node with no parent and no children is just an ordinary transform again
+	auto it = links.find(id);
+	if (it != links.end() && it->second.parent.IsNull() && it->second.children.empty())
+		links.erase(it);
+}
+
+void TransformHierarchy::Rebuild(EntityManager& manager)
+{
+	std::vector<EntityId> dead;
+	for (auto& link : links)
+		if (!IsLinkable(manager, link.first)) dead.push_back(link.first);
+
+	for (auto id : dead) {
+		auto it = links.find(id);
+		if (it == links.end()) continue;
+
+		std::vector<EntityId> children = std::move(it->second.children);
+		it->second.children.clear();
+		Detach(id);
+		links.erase(id);
+
+		for (auto child : children) {
+			links[child].parent = EntityId::null;
+			Prune(child);
+		}
+	}
+
+	order.clear();
+	parents.clear();
+	for (auto& link : links) {
+		if (!link.second.parent.IsNull()) continue;
+		order.push_back(link.first);
+		parents.push_back(-1);
+	}
+
+	// breadth first from the roots
+	for (std::size_t i = 0; i < order.size(); i++) {
+		for (auto child : links[order[i]].children) {
+			order.push_back(child);
+			parents.push_back(static_cast<std::int32_t>(i));
+		}
+	}
+
+	positions.resize(order.size());
+	rotations.resize(order.size());
+	scales.resize(order.size());
+	locals.resize(order.size());
+	worlds.resize(order.size());
+	dirty.assign(order.size(), 1);
+
+	// slots moved, so every local is taken again rather than only the changed ones
+	for (std::size_t i = 0; i < order.size(); i++) {
+		if (order[i].index >= slotOf.size()) slotOf.resize(order[i].index + 1);
+		slotOf[order[i].index] = static_cast<std::uint32_t>(i);
+
+		const Transform& t = *manager.GetEntity(order[i])->transform;
+		positions[i] = t.position;
+		rotations[i] = t.rotation;
+		scales[i] = t.scale;
+		Compose(t.position, t.rotation, t.scale, locals[i]);
+	}
+
+	structureChanged = false;
+}
+
+std::uint32_t TransformHierarchy::FindSlot(EntityId id) const
+{
+	if (id.index >= slotOf.size()) return static_cast<std::uint32_t>(order.size());
+	const std::uint32_t i = slotOf[id.index];
+	return i < order.size() && order[i] == id ? i : static_cast<std::uint32_t>(order.size());
+}
@@ -0,0 +1,82 @@
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ECS.h"
+#include "EntityId.h"
+#include "Transform.h"
+
+class EntityManager;
+
+// Parent / child links between entity transforms with cached local to world matrices.
+// Nodes are kept breadth first so every parent comes before its children and Update
+// is one linear pass. Only nodes whose local transform changed, or that sit below one
+// that did, are recomputed. Changes are found through Changed<Transform>, so a write through
+// Entity::transform needs markChanged<Transform>() to be seen. Entities that are not linked
+// to anything are not tracked, their world matrix is just their local one.
+class TransformHierarchy {
+public:
+	// Column major, same layout as Quat::ToMatrix
+	using Matrix = std::array<double, 16>;
+
+	TransformHierarchy();
+
+	// Links child under parent, a null parent detaches it. Returns false, changing
+	// nothing, if that would make child its own ancestor.
+	bool SetParent(EntityId child, EntityId parent);
+	EntityId GetParent(EntityId child) const;
+	const std::vector<EntityId>& GetChildren(EntityId parent) const;
+	bool Contains(EntityId id) const;
+	std::size_t Size() const { return order.size(); }
+	// Every linked entity as of the last Update, parents before their children
+	const std::vector<EntityId>& GetNodes() const { return order; }
+
+	// Recomputes the world matrices of everything that moved since the last call.
+	// Destroyed entities and ones whose Transform was removed are dropped here, their
+	// children become roots.
+	void Update(EntityManager& manager);
+
+	// nullptr until the entity has been linked and through an Update
+	const Matrix* GetWorldMatrix(EntityId id) const;
+	Vec3 GetWorldPosition(EntityId id) const;
+
+private:
+	struct Link {
+		EntityId parent;
+		std::vector<EntityId> children;
+	};
+
+	void Detach(EntityId child);
+	void Prune(EntityId id);
+	void Rebuild(EntityManager& manager);
+	// Slot of id in order, order.size() if it isn't linked
+	std::uint32_t FindSlot(EntityId id) const;
+
+	std::unordered_map<EntityId, Link> links;
+	bool structureChanged;
+	// ComponentStorage::GetTransformsLost as of the last look for destroyed or removed nodes
+	std::uint64_t transformsLost;
+	// Changed<Transform> ticks already looked at, compared inclusively like SpatialIndex
+	Tick since;
+
+	// breadth first, parents[i] < i
+	std::vector<EntityId> order;
+	std::vector<std::int32_t> parents;
+	// id index -> slot, only meaningful where order[slot] is that id
+	std::vector<std::uint32_t> slotOf;
+
+	// local transform the cached matrices were built from
+	std::vector<Vec3> positions;
+	std::vector<Quat> rotations;
+	std::vector<Vec3> scales;
+	std::vector<Matrix> locals;
+	std::vector<Matrix> worlds;
+	std::vector<unsigned char> dirty;
+
+};
+
+#endif
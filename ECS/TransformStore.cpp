@@ -0,0 +1,282 @@
+#include "TransformStore.h"
+#include "CpuFeatures.h"
+#include "EntityManager.h"
+
+/****SCALAR KERNELS****/
+static void TranslateScalar(float* x, float* y, float* z, const float* dx, const float* dy, const float* dz, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; i++) {
+		x[i] += dx[i];
+		y[i] += dy[i];
+		z[i] += dz[i];
+	}
+}
+
+static void RotateScalar(const float* qx, const float* qy, const float* qz, const float* qw, float* x, float* y, float* z, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; i++) {
+		float ux = qx[i], uy = qy[i], uz = qz[i], s = qw[i];
+		float vx = x[i], vy = y[i], vz = z[i];
+
+		// u * (2 * dot(u, v)) + v * (s * s - dot(u, u)) + cross(u, v) * (2 * s)
+		float d2 = 2 * (ux * vx + uy * vy + uz * vz);
+		float k = s * s - (ux * ux + uy * uy + uz * uz);
+		float s2 = 2 * s;
+
+		x[i] = ux * d2 + vx * k + (uy * vz - uz * vy) * s2;
+		y[i] = uy * d2 + vy * k + (uz * vx - ux * vz) * s2;
+		z[i] = uz * d2 + vz * k + (ux * vy - uy * vx) * s2;
+	}
+}
+
+static void ScaleScalar(float* x, float* y, float* z, const float* sx, const float* sy, const float* sz, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; i++) {
+		x[i] *= sx[i];
+		y[i] *= sy[i];
+		z[i] *= sz[i];
+	}
+}
+
+#ifdef ECS_X86
+/****SSE KERNELS****/
+static void TranslateSse(float* x, float* y, float* z, const float* dx, const float* dy, const float* dz, std::size_t n)
+{
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(dx + i)));
+		_mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_loadu_ps(dy + i)));
+		_mm_storeu_ps(z + i, _mm_add_ps(_mm_loadu_ps(z + i), _mm_loadu_ps(dz + i)));
+	}
+	TranslateScalar(x + i, y + i, z + i, dx + i, dy + i, dz + i, n - i);
+}
+
+static void RotateSse(const float* qx, const float* qy, const float* qz, const float* qw, float* x, float* y, float* z, std::size_t n)
+{
+	const __m128 two = _mm_set1_ps(2.0f);
+
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128 ux = _mm_loadu_ps(qx + i), uy = _mm_loadu_ps(qy + i), uz = _mm_loadu_ps(qz + i), s = _mm_loadu_ps(qw + i);
+		__m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i), vz = _mm_loadu_ps(z + i);
+
+		__m128 d2 = _mm_mul_ps(two, _mm_add_ps(_mm_add_ps(_mm_mul_ps(ux, vx), _mm_mul_ps(uy, vy)), _mm_mul_ps(uz, vz)));
+		__m128 k = _mm_sub_ps(_mm_mul_ps(s, s), _mm_add_ps(_mm_add_ps(_mm_mul_ps(ux, ux), _mm_mul_ps(uy, uy)), _mm_mul_ps(uz, uz)));
+		__m128 s2 = _mm_mul_ps(two, s);
+
+		__m128 cx = _mm_sub_ps(_mm_mul_ps(uy, vz), _mm_mul_ps(uz, vy));
+		__m128 cy = _mm_sub_ps(_mm_mul_ps(uz, vx), _mm_mul_ps(ux, vz));
+		__m128 cz = _mm_sub_ps(_mm_mul_ps(ux, vy), _mm_mul_ps(uy, vx));
+
+		_mm_storeu_ps(x + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(ux, d2), _mm_mul_ps(vx, k)), _mm_mul_ps(cx, s2)));
+		_mm_storeu_ps(y + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(uy, d2), _mm_mul_ps(vy, k)), _mm_mul_ps(cy, s2)));
+		_mm_storeu_ps(z + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(uz, d2), _mm_mul_ps(vz, k)), _mm_mul_ps(cz, s2)));
+	}
+	RotateScalar(qx + i, qy + i, qz + i, qw + i, x + i, y + i, z + i, n - i);
+}
+
+static void ScaleSse(float* x, float* y, float* z, const float* sx, const float* sy, const float* sz, std::size_t n)
+{
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(sx + i)));
+		_mm_storeu_ps(y + i, _mm_mul_ps(_mm_loadu_ps(y + i), _mm_loadu_ps(sy + i)));
+		_mm_storeu_ps(z + i, _mm_mul_ps(_mm_loadu_ps(z + i), _mm_loadu_ps(sz + i)));
+	}
+	ScaleScalar(x + i, y + i, z + i, sx + i, sy + i, sz + i, n - i);
+}
+
+/****AVX2 KERNELS****/
+ECS_TARGET_AVX2 static void TranslateAvx2(float* x, float* y, float* z, const float* dx, const float* dy, const float* dz, std::size_t n)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(dx + i)));
+		_mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_loadu_ps(dy + i)));
+		_mm256_storeu_ps(z + i, _mm256_add_ps(_mm256_loadu_ps(z + i), _mm256_loadu_ps(dz + i)));
+	}
+	TranslateScalar(x + i, y + i, z + i, dx + i, dy + i, dz + i, n - i);
+}
+
+ECS_TARGET_AVX2 static void RotateAvx2(const float* qx, const float* qy, const float* qz, const float* qw, float* x, float* y, float* z, std::size_t n)
+{
+	const __m256 two = _mm256_set1_ps(2.0f);
+
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 ux = _mm256_loadu_ps(qx + i), uy = _mm256_loadu_ps(qy + i), uz = _mm256_loadu_ps(qz + i), s = _mm256_loadu_ps(qw + i);
+		__m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i), vz = _mm256_loadu_ps(z + i);
+
+		__m256 d2 = _mm256_mul_ps(two, _mm256_fmadd_ps(uz, vz, _mm256_fmadd_ps(uy, vy, _mm256_mul_ps(ux, vx))));
+		__m256 k = _mm256_fnmadd_ps(uz, uz, _mm256_fnmadd_ps(uy, uy, _mm256_fnmadd_ps(ux, ux, _mm256_mul_ps(s, s))));
+		__m256 s2 = _mm256_mul_ps(two, s);
+
+		__m256 cx = _mm256_fmsub_ps(uy, vz, _mm256_mul_ps(uz, vy));
+		__m256 cy = _mm256_fmsub_ps(uz, vx, _mm256_mul_ps(ux, vz));
+		__m256 cz = _mm256_fmsub_ps(ux, vy, _mm256_mul_ps(uy, vx));
+
+		_mm256_storeu_ps(x + i, _mm256_fmadd_ps(cx, s2, _mm256_fmadd_ps(vx, k, _mm256_mul_ps(ux, d2))));
+		_mm256_storeu_ps(y + i, _mm256_fmadd_ps(cy, s2, _mm256_fmadd_ps(vy, k, _mm256_mul_ps(uy, d2))));
+		_mm256_storeu_ps(z + i, _mm256_fmadd_ps(cz, s2, _mm256_fmadd_ps(vz, k, _mm256_mul_ps(uz, d2))));
+	}
+	RotateScalar(qx + i, qy + i, qz + i, qw + i, x + i, y + i, z + i, n - i);
+}
+
+ECS_TARGET_AVX2 static void ScaleAvx2(float* x, float* y, float* z, const float* sx, const float* sy, const float* sz, std::size_t n)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(sx + i)));
+		_mm256_storeu_ps(y + i, _mm256_mul_ps(_mm256_loadu_ps(y + i), _mm256_loadu_ps(sy + i)));
+		_mm256_storeu_ps(z + i, _mm256_mul_ps(_mm256_loadu_ps(z + i), _mm256_loadu_ps(sz + i)));
+	}
+	ScaleScalar(x + i, y + i, z + i, sx + i, sy + i, sz + i, n - i);
+}
+#endif
+
+/****DISPATCH****/
+const TransformKernels& TransformKernels::Scalar()
+{
+	static const TransformKernels kernels = { TranslateScalar, RotateScalar, ScaleScalar, "scalar" };
+	return kernels;
+}
+
+const TransformKernels* TransformKernels::Sse()
+{
+#ifdef ECS_X86
+	static const TransformKernels kernels = { TranslateSse, RotateSse, ScaleSse, "sse" };
+	if (CpuFeatures::Get().sse2) return &kernels;
+#endif
+	return nullptr;
+}
+
+const TransformKernels* TransformKernels::Avx2()
+{
+#ifdef ECS_X86
+	static const TransformKernels kernels = { TranslateAvx2, RotateAvx2, ScaleAvx2, "avx2" };
+	if (CpuFeatures::Get().avx2 && CpuFeatures::Get().fma) return &kernels;
+#endif
+	return nullptr;
+}
+
+const TransformKernels& TransformKernels::Get()
+{
+	static const TransformKernels& best = Avx2() ? *Avx2() : Sse() ? *Sse() : Scalar();
+	return best;
+}
+
+/****STORE****/
+static const std::uint32_t NO_SLOT = ~0u;
+
+TransformStore::TransformStore() : kernels(TransformKernels::Get())
+{
+}
+
+std::size_t TransformStore::Add(EntityId id, const Transform& t)
+{
+	std::size_t slot = SlotOf(id);
+	if (slot == Size()) {
+		if (id.index >= slots.size()) slots.resize(id.index + 1, NO_SLOT);
+		slots[id.index] = static_cast<std::uint32_t>(slot);
+		ids.push_back(id);
+
+		px.push_back(0); py.push_back(0); pz.push_back(0);
+		rx.push_back(0); ry.push_back(0); rz.push_back(0); rw.push_back(1);
+		sx.push_back(1); sy.push_back(1); sz.push_back(1);
+	}
+
+	px[slot] = static_cast<float>(t.position.x);
+	py[slot] = static_cast<float>(t.position.y);
+	pz[slot] = static_cast<float>(t.position.z);
+	rx[slot] = static_cast<float>(t.rotation.x);
+	ry[slot] = static_cast<float>(t.rotation.y);
+	rz[slot] = static_cast<float>(t.rotation.z);
+	rw[slot] = static_cast<float>(t.rotation.w);
+	sx[slot] = static_cast<float>(t.scale.x);
+	sy[slot] = static_cast<float>(t.scale.y);
+	sz[slot] = static_cast<float>(t.scale.z);
+
+	return slot;
+}
+
+void TransformStore::Remove(EntityId id)
+{
+	std::size_t slot = SlotOf(id);
+	if (slot == Size()) return;
+
+	// swap and pop every array
+	std::size_t last = Size() - 1;
+	for (auto array : { &px, &py, &pz, &rx, &ry, &rz, &rw, &sx, &sy, &sz }) {
+		(*array)[slot] = (*array)[last];
+		array->pop_back();
+	}
+
+	ids[slot] = ids[last];
+	slots[ids[slot].index] = static_cast<std::uint32_t>(slot);
+	ids.pop_back();
+	slots[id.index] = NO_SLOT;
+}
+
+bool TransformStore::Contains(EntityId id) const
+{
+	return SlotOf(id) != Size();
+}
+
+void TransformStore::Clear()
+{
+	for (auto array : { &px, &py, &pz, &rx, &ry, &rz, &rw, &sx, &sy, &sz })
+		array->clear();
+
+	ids.clear();
+	slots.clear();
+}
+
+std::size_t TransformStore::SlotOf(EntityId id) const
+{
+	if (id.index >= slots.size() || slots[id.index] == NO_SLOT) return Size();
+
+	std::size_t slot = slots[id.index];
+	return ids[slot] == id ? slot : Size();
+}
+
+void TransformStore::Translate(const float* dx, const float* dy, const float* dz)
+{
+	kernels.translate(px.data(), py.data(), pz.data(), dx, dy, dz, Size());
+}
+
+void TransformStore::TranslateLocal(const float* dx, const float* dy, const float* dz)
+{
+	tx.assign(dx, dx + Size());
+	ty.assign(dy, dy + Size());
+	tz.assign(dz, dz + Size());
+
+	kernels.rotate(rx.data(), ry.data(), rz.data(), rw.data(), tx.data(), ty.data(), tz.data(), Size());
+	kernels.translate(px.data(), py.data(), pz.data(), tx.data(), ty.data(), tz.data(), Size());
+}
+
+void TransformStore::Scale(const float* sx, const float* sy, const float* sz)
+{
+	kernels.scale(this->sx.data(), this->sy.data(), this->sz.data(), sx, sy, sz, Size());
+}
+
+void TransformStore::Gather(EntityManager& manager)
+{
+	Clear();
+	manager.view<const Transform>().each([this](Entity& e, const Transform& t) {
+		Add(e.GetId(), t);
+	});
+}
+
+void TransformStore::Scatter(EntityManager& manager) const
+{
+	for (std::size_t i = 0; i < Size(); i++) {
+		Entity* e = manager.GetEntity(ids[i]);
+		if (e == nullptr || e->transform == nullptr) continue;
+
+		Transform& t = *e->transform;
+		t.position = Vec3(px[i], py[i], pz[i]);
+		t.rotation = Quat(rx[i], ry[i], rz[i], rw[i]);
+		t.scale = Vec3(sx[i], sy[i], sz[i]);
+		e->markChanged<Transform>();
+	}
+}
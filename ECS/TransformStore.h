@@ -0,0 +1,75 @@
+#ifndef TRANSFORM_STORE_H
+#define TRANSFORM_STORE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "EntityId.h"
+#include "Transform.h"
+
+class EntityManager;
+
+// Batch kernels over structure-of-arrays float data, n elements each.
+// Get picks the widest version the CPU supports, Scalar is always available.
+struct TransformKernels {
+	// x += dx
+	void (*translate)(float* x, float* y, float* z, const float* dx, const float* dy, const float* dz, std::size_t n);
+	// v = q * v, the same math as operator*(Quat, Vec3)
+	void (*rotate)(const float* qx, const float* qy, const float* qz, const float* qw, float* x, float* y, float* z, std::size_t n);
+	// x *= sx
+	void (*scale)(float* x, float* y, float* z, const float* sx, const float* sy, const float* sz, std::size_t n);
+
+	const char* name;
+
+	static const TransformKernels& Get();
+	static const TransformKernels& Scalar();
+	// nullptr when the CPU or build does not support them
+	static const TransformKernels* Sse();
+	static const TransformKernels* Avx2();
+};
+
+// Optional single precision copy of Transform data kept as separate arrays per field,
+// so whole batches of transforms can be moved with SIMD kernels.
+// Gather fills it from the Transform components, Scatter writes it back.
+class TransformStore {
+public:
+	TransformStore();
+
+	std::size_t Add(EntityId id, const Transform& t);
+	void Remove(EntityId id);
+	bool Contains(EntityId id) const;
+	void Clear();
+
+	std::size_t Size() const { return ids.size(); }
+	// dense slot of an entity, Size() if it is not in the store
+	std::size_t SlotOf(EntityId id) const;
+	const std::vector<EntityId>& GetIds() const { return ids; }
+
+	// Moves every entity by its own delta
+	void Translate(const float* dx, const float* dy, const float* dz);
+	// Moves every entity by a delta given in its own local space, rotated by its rotation first
+	void TranslateLocal(const float* dx, const float* dy, const float* dz);
+	// Multiplies every entities scale by its own factors
+	void Scale(const float* sx, const float* sy, const float* sz);
+
+	// Rebuilds the store from every entity with a Transform
+	void Gather(EntityManager& manager);
+	// Writes positions, rotations and scales back to the Transform components
+	void Scatter(EntityManager& manager) const;
+
+	std::vector<float> px, py, pz;
+	std::vector<float> rx, ry, rz, rw;
+	std::vector<float> sx, sy, sz;
+
+private:
+	const TransformKernels& kernels;
+
+	std::vector<EntityId> ids;
+	// id index -> dense slot
+	std::vector<std::uint32_t> slots;
+	// scratch space for TranslateLocal
+	std::vector<float> tx, ty, tz;
+
+};
+
+#endif
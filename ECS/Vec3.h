@@ -6,79 +6,377 @@
 #include <string>
 #include <iostream>
 #include <array>
+#include <type_traits>
 
 #define VEC_MIN 0.0000000001
 
-class Vec3 {
+// Header only so everything can inline, trivially copyable so arrays of them can be memcpy'd.
+// Use the Vec3 (double) and Vec3f (float) aliases below.
+template<typename T>
+class Vec3T {
 public:
-	Vec3();
-	Vec3(const Vec3& other);
-	Vec3(double x, double y, double z);
-	~Vec3();
-
-	double Magnitude() const;
-	double SqrMagnitude() const;
-	static double SqrMagnitude(const Vec3& v);
-	void ClampMagnitude(double d);
-
-	Vec3 Normalize() const;
-	static Vec3 Normalize(Vec3 v);
-
-	double Distance(const Vec3& other);
-
-	double DotProd(const Vec3& other);
-	static double DotProd(const Vec3& a, const Vec3& b);
-
-	double AngleBetween(const Vec3& other);
-
-	Vec3 CrossProd(const Vec3& other);
-	static Vec3 CrossProd(const Vec3& a, const Vec3& b);
-
-	Vec3 Ortho();
-	static Vec3 Ortho(Vec3 v);
-
-	Vec3 Rotate(Vec3 rot);
-	Vec3 Rotate(double rotx, double roty, double rotz);
-	Vec3& ApplyRotation(Vec3 rot);
-	Vec3& ApplyRotation(double rotx, double roty, double rotz);
-
-	std::array<double, 3> toArray();
-
-	static Vec3 Lerp(Vec3 v1, Vec3 v2, const double& time);
-
-	friend std::ostream& operator<<(std::ostream& os, const Vec3& v);
-
-	Vec3 operator* (const double d);
-	Vec3 operator/ (const double d);
-	Vec3 operator+ (const Vec3& other);
-	Vec3 operator- (const Vec3& other);
-	Vec3& operator*=(double d);
-	Vec3& operator/=(double d);
-	Vec3& operator+=(double d);
-	Vec3& operator-=(double d);
-	Vec3& operator*=(const Vec3& other);
-	Vec3& operator/=(const Vec3& other);
-	Vec3& operator+=(const Vec3& other);
-	Vec3& operator-=(const Vec3& other);
-	Vec3 operator-();
-
-	static const Vec3 one;
-	static const Vec3 zero;
-	static const Vec3 up;
-	static const Vec3 down;
-	static const Vec3 left;
-	static const Vec3 right;
-	static const Vec3 forward;
-	static const Vec3 backward;
-
-	double x;
-	double y;
-	double z;
+	constexpr Vec3T() : x(0), y(0), z(0) {}
+	constexpr Vec3T(T x, T y, T z) : x(x), y(y), z(z) {}
+	template<typename U>
+	constexpr explicit Vec3T(const Vec3T<U>& other) : x(static_cast<T>(other.x)), y(static_cast<T>(other.y)), z(static_cast<T>(other.z)) {}
+
+	T Magnitude() const;
+	constexpr T SqrMagnitude() const;
+	static constexpr T SqrMagnitude(const Vec3T& v);
+	void ClampMagnitude(T d);
+
+	Vec3T Normalize() const;
+	static Vec3T Normalize(Vec3T v);
+
+	T Distance(const Vec3T& other) const;
+	// Skips the square root, for comparing distances
+	constexpr T SqrDistance(const Vec3T& other) const;
+
+	constexpr T DotProd(const Vec3T& other) const;
+	static constexpr T DotProd(const Vec3T& a, const Vec3T& b);
+
+	T AngleBetween(const Vec3T& other) const;
+
+	constexpr Vec3T CrossProd(const Vec3T& other) const;
+	static constexpr Vec3T CrossProd(const Vec3T& a, const Vec3T& b);
+
+	constexpr Vec3T Ortho() const;
+	static constexpr Vec3T Ortho(Vec3T v);
+
+	Vec3T Rotate(Vec3T rot) const;
+	Vec3T Rotate(T rotx, T roty, T rotz) const;
+	Vec3T& ApplyRotation(Vec3T rot);
+	Vec3T& ApplyRotation(T rotx, T roty, T rotz);
+
+	constexpr std::array<T, 3> toArray() const;
+
+	static constexpr Vec3T Lerp(Vec3T v1, Vec3T v2, const T& time);
+
+	constexpr Vec3T operator* (const T d) const;
+	constexpr Vec3T operator/ (const T d) const;
+	constexpr Vec3T operator+ (const Vec3T& other) const;
+	constexpr Vec3T operator- (const Vec3T& other) const;
+	constexpr Vec3T& operator*=(T d);
+	constexpr Vec3T& operator/=(T d);
+	constexpr Vec3T& operator+=(T d);
+	constexpr Vec3T& operator-=(T d);
+	constexpr Vec3T& operator*=(const Vec3T& other);
+	constexpr Vec3T& operator/=(const Vec3T& other);
+	constexpr Vec3T& operator+=(const Vec3T& other);
+	constexpr Vec3T& operator-=(const Vec3T& other);
+	constexpr Vec3T operator-() const;
+
+	friend constexpr Vec3T operator+(const T d, Vec3T v) { return v += d; }
+	friend constexpr Vec3T operator-(const T d, Vec3T v) { return v -= d; }
+	friend constexpr Vec3T operator*(const T d, Vec3T v) { return v *= d; }
+	friend constexpr Vec3T operator/(const T d, Vec3T v) { return v /= d; }
+
+	friend constexpr bool operator==(const Vec3T& a, const Vec3T& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+	friend constexpr bool operator!=(const Vec3T& a, const Vec3T& b) { return !(a == b); }
+
+	friend std::ostream& operator<<(std::ostream& os, const Vec3T& v) {
+		os << "(" << std::to_string(v.x) << ", " << std::to_string(v.y) << ", " << std::to_string(v.z) << ")";
+		return os;
+	}
+
+	// defined constexpr below, usable in constant expressions
+	static const Vec3T one;
+	static const Vec3T zero;
+	static const Vec3T up;
+	static const Vec3T down;
+	static const Vec3T left;
+	static const Vec3T right;
+	static const Vec3T forward;
+	static const Vec3T backward;
+
+	T x;
+	T y;
+	T z;
 };
 
-inline Vec3 operator+(const double d, Vec3 v) { return v += d; }
-inline Vec3 operator-(const double d, Vec3 v) { return v -= d; }
-inline Vec3 operator*(const double d, Vec3 v) { return v *= d; }
-inline Vec3 operator/(const double d, Vec3 v) { return v /= d; }
+using Vec3 = Vec3T<double>;
+using Vec3f = Vec3T<float>;
+
+template<typename T> constexpr Vec3T<T> Vec3T<T>::one(1, 1, 1);
+template<typename T> constexpr Vec3T<T> Vec3T<T>::zero(0, 0, 0);
+template<typename T> constexpr Vec3T<T> Vec3T<T>::up(0, 1, 0);
+template<typename T> constexpr Vec3T<T> Vec3T<T>::down(0, -1, 0);
+template<typename T> constexpr Vec3T<T> Vec3T<T>::left(-1, 0, 0);
+template<typename T> constexpr Vec3T<T> Vec3T<T>::right(1, 0, 0);
+template<typename T> constexpr Vec3T<T> Vec3T<T>::forward(0, 0, -1);
+template<typename T> constexpr Vec3T<T> Vec3T<T>::backward(0, 0, 1);
+
+static_assert(std::is_trivially_copyable<Vec3>::value && std::is_trivially_copyable<Vec3f>::value, "Vec3 must stay trivially copyable");
+
+template<typename T>
+inline T Vec3T<T>::Magnitude() const
+{
+	// can return zeros
+	return std::sqrt((x * x) + (y * y) + (z * z));
+}
+
+template<typename T>
+inline constexpr T Vec3T<T>::SqrMagnitude() const
+{
+	return x * x + y * y + z * z;
+}
+
+template<typename T>
+inline constexpr T Vec3T<T>::SqrMagnitude(const Vec3T& v)
+{
+	return v.x * v.x + v.y * v.y + v.z * v.z;
+}
+
+template<typename T>
+inline void Vec3T<T>::ClampMagnitude(T d)
+{
+	*this = Normalize() * d;
+}
+
+template<typename T>
+inline Vec3T<T> Vec3T<T>::Normalize() const
+{
+	T mag(Magnitude());
+	if (mag == 0) return zero;
+	return Vec3T(x / mag, y / mag, z / mag);
+}
+
+template<typename T>
+inline Vec3T<T> Vec3T<T>::Normalize(Vec3T v)
+{
+	return v.Normalize();
+}
+
+template<typename T>
+inline T Vec3T<T>::Distance(const Vec3T& other) const
+{
+	return std::sqrt(SqrDistance(other));
+}
+
+template<typename T>
+inline constexpr T Vec3T<T>::SqrDistance(const Vec3T& other) const
+{
+	const T dx = x - other.x;
+	const T dy = y - other.y;
+	const T dz = z - other.z;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+template<typename T>
+inline constexpr T Vec3T<T>::DotProd(const Vec3T& other) const
+{
+	return (x * other.x) + (y * other.y) + (z * other.z);
+}
+
+template<typename T>
+inline constexpr T Vec3T<T>::DotProd(const Vec3T& a, const Vec3T& b)
+{
+	return (a.x * b.x) + (a.y * b.y) + (a.z * b.z);
+}
+
+template<typename T>
+inline T Vec3T<T>::AngleBetween(const Vec3T& other) const
+{
+	T rad = std::acos(DotProd(other) / (other.Magnitude() * Magnitude()));
+	return static_cast<T>(rad * 180 / M_PI);
+}
+
+template<typename T>
+inline constexpr Vec3T<T> Vec3T<T>::CrossProd(const Vec3T& other) const
+{
+	return Vec3T((y * other.z) - (z * other.y), (z * other.x) - (x * other.z), (x * other.y) - (y * other.x));
+}
+
+template<typename T>
+inline constexpr Vec3T<T> Vec3T<T>::CrossProd(const Vec3T& a, const Vec3T& b)
+{
+	return a.CrossProd(b);
+}
+
+template<typename T>
+inline constexpr Vec3T<T> Vec3T<T>::Ortho() const
+{
+	return (z < x) ? Vec3T(y, -x, 0) : Vec3T(0, -z, y);
+}
+
+template<typename T>
+inline constexpr Vec3T<T> Vec3T<T>::Ortho(Vec3T v)
+{
+	return v.Ortho();
+}
+
+template<typename T>
+inline Vec3T<T> Vec3T<T>::Rotate(Vec3T rot) const
+{
+	return Rotate(rot.x, rot.y, rot.z);
+}
+
+template<typename T>
+inline Vec3T<T> Vec3T<T>::Rotate(T rotx, T roty, T rotz) const
+{
+	Vec3T result(*this);
+	return result.ApplyRotation(rotx, roty, rotz);
+}
+
+template<typename T>
+inline Vec3T<T>& Vec3T<T>::ApplyRotation(Vec3T rot)
+{
+	return ApplyRotation(rot.x, rot.y, rot.z);
+}
+
+template<typename T>
+inline Vec3T<T>& Vec3T<T>::ApplyRotation(T rotx, T roty, T rotz)
+{
+	rotx = static_cast<T>(rotx * M_PI / 180.0);
+	roty = static_cast<T>(roty * M_PI / 180.0);
+	rotz = static_cast<T>(rotz * M_PI / 180.0);
+
+	Vec3T t(x, y, z);
+
+	if (rotx)
+	{
+		y = (t.y * std::cos(rotx) - t.z * std::sin(rotx));
+		z = (t.y * std::sin(rotx) + t.z * std::cos(rotx));
+
+		t.y = y;
+		t.z = z;
+	}
+
+	if (roty)
+	{
+		x = (t.x * std::cos(roty) + t.z * std::sin(roty));
+		z = (-t.x * std::sin(roty) + t.z * std::cos(roty));
+
+		t.x = x;
+		t.z = z;
+	}
+
+	if (rotz)
+	{
+		x = (t.x * std::cos(rotz) - t.y * std::sin(rotz));
+		y = (t.x * std::sin(rotz) + t.y * std::cos(rotz));
+	}
+
+	if (x < VEC_MIN && x > -VEC_MIN) x = 0;
+	if (y < VEC_MIN && y > -VEC_MIN) y = 0;
+	if (z < VEC_MIN && z > -VEC_MIN) z = 0;
+
+	return *this;
+}
+
+template<typename T>
+inline constexpr std::array<T, 3> Vec3T<T>::toArray() const
+{
+	return { x, y, z };
+}
+
+template<typename T>
+inline constexpr Vec3T<T> Vec3T<T>::Lerp(Vec3T v1, Vec3T v2, const T& time)
+{
+	return v1 + ((v2 - v1) * time);
+}
+
+/****OPERATORS****/
+template<typename T>
+inline constexpr Vec3T<T> Vec3T<T>::operator* (const T d) const
+{
+	return Vec3T(x * d, y * d, z * d);
+}
+
+template<typename T>
+inline constexpr Vec3T<T> Vec3T<T>::operator/ (const T d) const
+{
+	return Vec3T(x / d, y / d, z / d);
+}
+
+template<typename T>
+inline constexpr Vec3T<T> Vec3T<T>::operator+ (const Vec3T& other) const
+{
+	return Vec3T(x + other.x, y + other.y, z + other.z);
+}
+
+template<typename T>
+inline constexpr Vec3T<T> Vec3T<T>::operator- (const Vec3T& other) const
+{
+	return Vec3T(x - other.x, y - other.y, z - other.z);
+}
+
+template<typename T>
+inline constexpr Vec3T<T>& Vec3T<T>::operator*=(T d)
+{
+	x *= d;
+	y *= d;
+	z *= d;
+	return *this;
+}
+
+template<typename T>
+inline constexpr Vec3T<T>& Vec3T<T>::operator/=(T d)
+{
+	x /= d;
+	y /= d;
+	z /= d;
+	return *this;
+}
+
+template<typename T>
+inline constexpr Vec3T<T>& Vec3T<T>::operator+=(T d)
+{
+	x += d;
+	y += d;
+	z += d;
+	return *this;
+}
+
+template<typename T>
+inline constexpr Vec3T<T>& Vec3T<T>::operator-=(T d)
+{
+	x -= d;
+	y -= d;
+	z -= d;
+	return *this;
+}
+
+template<typename T>
+inline constexpr Vec3T<T>& Vec3T<T>::operator*=(const Vec3T& other)
+{
+	x *= other.x;
+	y *= other.y;
+	z *= other.z;
+	return *this;
+}
+
+template<typename T>
+inline constexpr Vec3T<T>& Vec3T<T>::operator/=(const Vec3T& other)
+{
+	x /= other.x;
+	y /= other.y;
+	z /= other.z;
+	return *this;
+}
+
+template<typename T>
+inline constexpr Vec3T<T>& Vec3T<T>::operator+=(const Vec3T& other)
+{
+	x += other.x;
+	y += other.y;
+	z += other.z;
+	return *this;
+}
+
+template<typename T>
+inline constexpr Vec3T<T>& Vec3T<T>::operator-=(const Vec3T& other)
+{
+	x -= other.x;
+	y -= other.y;
+	z -= other.z;
+	return *this;
+}
+
+template<typename T>
+inline constexpr Vec3T<T> Vec3T<T>::operator-() const
+{
+	return Vec3T(-x, -y, -z);
+}
 
-#endif    
\ No newline at end of file
+#endif
@@ -0,0 +1,346 @@
+#ifndef VIEW_H
+#define VIEW_H
+
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ComponentStorage.h"
+#include "Entity.h"
+#include "JobSystem.h"
+
+// Filters for View::filter, keep entities whose T was written / added since a tick.
+// Table components are tracked per chunk, so whole chunks that haven't changed are skipped
+// and a chunk that has passes every row in it. Sparse set components are tracked per entity.
+template<typename T>
+struct Changed {
+	using Type = T;
+	static constexpr bool added = false;
+};
+
+template<typename T>
+struct Added {
+	using Type = T;
+	static constexpr bool added = true;
+};
+
+// Iterates every entity that has all of Ts, e.g.
+//   manager->view<Transform, const ComponentOne>().each([](Transform& t, const ComponentOne& c) { ... });
+// The callback may also take the Entity& first. Table components are walked chunk by chunk
+// with their columns resolved once per chunk, sparse set components are looked up per entity.
+// Entities that also have any of the types passed to exclude are skipped:
+//   manager->view<Transform>().exclude<ComponentTwo>().each(...);
+// Required and excluded types are compiled into signatures, an archetype or entity is matched
+// with one AND and compare. Components must not be added or removed while iterating.
+// Iterating with non const access to a component stamps it as changed, see Changed.
+template<typename... Ts>
+class View {
+public:
+	View(ComponentStorage* storage, JobSystem* jobs) : storage(storage), jobs(jobs),
+		required(signatureOf<Bare<Ts>...>()), requiredTable(tableSignatureOf<Bare<Ts>...>()), since(0), sparseFilters(false) {}
+
+	// Copy of this view that also skips entities with any of Us
+	template<typename... Us>
+	inline View exclude() const {
+		View view(*this);
+		view.excluded |= signatureOf<Us...>();
+		view.excludedSparse |= signatureOf<Us...>() & ~tableSignatureOf<Us...>();
+		return view;
+	}
+
+	// Copy of this view that only keeps entities passing every filter, e.g.
+	//   manager->view<const Transform>().filter<Changed<Transform>>().each(...);
+	// Filtered types are required as well. since is compared against the ticks the
+	// components were stamped with, see ComponentStorage::GetTick.
+	template<typename... Fs>
+	inline View filter(Tick since) const {
+		View view(*this);
+		view.since = since;
+		(view.AddFilter<Fs>(), ...);
+		return view;
+	}
+	// Changed or added during this frame or the last one, a system that runs every frame sees
+	// every change at least once
+	template<typename... Fs>
+	inline View filter() const {
+		return filter<Fs...>(storage->GetTick() - 1);
+	}
+
+	template<typename F>
+	inline void each(F&& f);
+
+	// Same as each but split into jobs of about grain entities each. f is copied and may be
+	// called from several threads at once. Wait on the returned handle before touching the
+	// components from anywhere else, without a job system everything runs before returning.
+	template<typename F>
+	inline JobHandle parallel_each(F f, std::size_t grain = 1024);
+
+private:
+	template<typename T>
+	using Bare = std::remove_const_t<T>;
+
+	template<typename T>
+	static constexpr bool isSparse = Bare<T>::storagePolicy != StoragePolicy::Table;
+
+	static constexpr bool anyTable = (!isSparse<Ts> || ...);
+	static constexpr bool anySparse = (isSparse<Ts> || ...);
+
+	struct Filter {
+		TypeID id;
+		bool sparse;
+		bool added;
+	};
+
+	template<typename F>
+	inline void AddFilter() {
+		using U = typename F::Type;
+		static_assert(anyTable || isSparse<U>, "Error: a view of only sparse set components can't filter on a table component");
+		required.set(getCompTypeID<U>());
+		if constexpr (isSparse<U>) sparseFilters = true;
+		else requiredTable.set(getCompTypeID<U>());
+
+		filters.push_back(Filter{ getCompTypeID<U>(), isSparse<U>, F::added });
+	}
+
+	// Bits of the table components among Us, the only ones an archetype can have
+	template<typename... Us>
+	static inline Signature tableSignatureOf() {
+		Signature mask;
+		((Us::storagePolicy == StoragePolicy::Table ? mask.set(getCompTypeID<Us>()) : mask), ...);
+		return mask;
+	}
+
+	// How to reach one component type, set up once per chunk
+	template<typename T>
+	struct Accessor {
+		T* column;
+		PoolOf<Bare<T>>* pool;
+
+		// only called once the entity is known to have T
+		inline T* Get(std::size_t i, std::uint32_t index) const {
+			if constexpr (isSparse<T>) return &pool->Get(index);
+			else return column + i;
+		}
+
+		// table columns are stamped once per chunk by MarkChunk instead
+		inline void Mark(std::uint32_t index, Tick tick) const {
+			if constexpr (isSparse<T> && !std::is_const_v<T>) pool->MarkChanged(index, tick);
+		}
+	};
+
+	template<typename T>
+	inline Accessor<T> MakeAccessor(Archetype* archetype, const Chunk* chunk) const;
+
+	// Table half of the test, done once for a whole archetype
+	inline bool Matches(const Archetype* archetype) const {
+		const Signature& signature = archetype->GetSignature();
+		return (signature & requiredTable) == requiredTable && (signature & excluded).none();
+	}
+	// Full test, only needed per entity when sparse set types are involved
+	inline bool Matches(const Entity& e) const {
+		const Signature& signature = e.GetSignature();
+		if ((signature & required) != required || (signature & excluded).any()) return false;
+
+		for (auto& filter : filters) {
+			if (!filter.sparse) continue;
+
+			const SparseSetBase* pool = storage->GetPool(filter.id);
+			Tick tick = filter.added ? pool->AddedTick(e.GetId().index) : pool->ChangedTick(e.GetId().index);
+			if (tick < since) return false;
+		}
+		return true;
+	}
+	// Table filters, passes or skips a whole chunk
+	inline bool Matches(const Archetype* archetype, const Chunk& chunk) const {
+		for (auto& filter : filters) {
+			if (filter.sparse) continue;
+
+			int column = archetype->ColumnIndex(filter.id);
+			Tick tick = filter.added ? archetype->GetAddedTicks(chunk)[column] : archetype->GetChangedTicks(chunk)[column];
+			if (tick < since) return false;
+		}
+		return true;
+	}
+
+	// Stamps every table column the view writes to as changed in this chunk.
+	// Done from the calling thread, jobs sharing a chunk would race on it.
+	inline void MarkChunk(Archetype* archetype, const Chunk& chunk) const {
+		Tick* ticks = archetype->GetChangedTicks(chunk);
+		((isSparse<Ts> || std::is_const_v<Ts> ? void() : void(ticks[archetype->ColumnIndex(getCompTypeID<Bare<Ts>>())] = storage->GetTick())), ...);
+	}
+
+	// Part of a chunk handed to one job
+	struct Range {
+		Archetype* archetype;
+		Chunk chunk;
+		std::size_t begin;
+		std::size_t end;
+	};
+
+	template<typename F, std::size_t... I>
+	inline void EachChunk(F& f, Archetype* archetype, const Chunk& chunk, std::size_t begin, std::size_t end, std::index_sequence<I...>);
+
+	template<typename F, std::size_t... I>
+	inline void EachSparse(F& f, std::index_sequence<I...>);
+
+	template<typename F>
+	static inline void Invoke(F& f, Entity& e, Ts&... comps) {
+		if constexpr (std::is_invocable_v<F&, Entity&, Ts&...>) f(e, comps...);
+		else f(comps...);
+	}
+
+	ComponentStorage* storage;
+	JobSystem* jobs;
+
+	Signature required;
+	Signature requiredTable;
+	Signature excluded;
+	// excluded types an archetype can't rule out
+	Signature excludedSparse;
+
+	std::vector<Filter> filters;
+	Tick since;
+	bool sparseFilters;
+};
+
+template<typename... Ts>
+template<typename F>
+inline void View<Ts...>::each(F&& f)
+{
+	if constexpr (anyTable) {
+		for (auto& archetype : storage->GetArchetypes()) {
+			if (archetype->Size() == 0 || !Matches(archetype.get())) continue;
+
+			for (std::size_t c = 0; c < archetype->ChunkCount(); c++) {
+				const Chunk& chunk = archetype->GetChunk(c);
+				if (!Matches(archetype.get(), chunk)) continue;
+
+				MarkChunk(archetype.get(), chunk);
+				EachChunk(f, archetype.get(), chunk, 0, chunk.count, std::index_sequence_for<Ts...>());
+			}
+		}
+	}
+	else {
+		EachSparse(f, std::index_sequence_for<Ts...>());
+	}
+}
+
+template<typename... Ts>
+template<typename F>
+inline JobHandle View<Ts...>::parallel_each(F f, std::size_t grain)
+{
+	if (jobs == nullptr) {
+		each(f);
+		return JobHandle();
+	}
+
+	JobHandle handle = jobs->CreateHandle();
+	if (grain == 0) grain = 1;
+
+	if constexpr (anyTable) {
+		auto shared = std::make_shared<F>(std::move(f));
+		// jobs take a copy of the view, this one is usually a temporary
+		auto schedule = [this, &handle, &shared](std::vector<Range>& batch) {
+			jobs->Schedule(handle, [view = *this, shared, batch]() mutable {
+				for (auto& range : batch)
+					view.EachChunk(*shared, range.archetype, range.chunk, range.begin, range.end, std::index_sequence_for<Ts...>());
+			});
+			batch.clear();
+		};
+
+		// cut chunks into jobs of grain rows, small chunks get batched together
+		std::vector<Range> batch;
+		std::size_t batchRows = 0;
+		for (auto& archetype : storage->GetArchetypes()) {
+			if (archetype->Size() == 0 || !Matches(archetype.get())) continue;
+
+			for (std::size_t c = 0; c < archetype->ChunkCount(); c++) {
+				const Chunk& chunk = archetype->GetChunk(c);
+				if (!Matches(archetype.get(), chunk)) continue;
+
+				MarkChunk(archetype.get(), chunk);
+				for (std::size_t begin = 0; begin < chunk.count;) {
+					std::size_t end = std::min(chunk.count, begin + (grain - batchRows));
+					batch.push_back(Range{ archetype.get(), chunk, begin, end });
+					batchRows += end - begin;
+					begin = end;
+
+					if (batchRows == grain) {
+						schedule(batch);
+						batchRows = 0;
+					}
+				}
+			}
+		}
+		if (!batch.empty()) schedule(batch);
+	}
+	else {
+		// sparse only views have no chunks, run them as one job
+		jobs->Schedule(handle, [view = *this, f]() mutable { view.EachSparse(f, std::index_sequence_for<Ts...>()); });
+	}
+
+	return handle;
+}
+
+template<typename... Ts>
+template<typename T>
+inline typename View<Ts...>::template Accessor<T> View<Ts...>::MakeAccessor(Archetype* archetype, const Chunk* chunk) const
+{
+	Accessor<T> accessor{ nullptr, nullptr };
+
+	if constexpr (isSparse<T>)
+		accessor.pool = static_cast<PoolOf<Bare<T>>*>(storage->GetPool(getCompTypeID<Bare<T>>()));
+	else
+		accessor.column = static_cast<T*>(archetype->GetColumn(*chunk, archetype->ColumnIndex(getCompTypeID<Bare<T>>())));
+
+	return accessor;
+}
+
+template<typename... Ts>
+template<typename F, std::size_t... I>
+inline void View<Ts...>::EachChunk(F& f, Archetype* archetype, const Chunk& chunk, std::size_t begin, std::size_t end, std::index_sequence<I...>)
+{
+	// resolved once for the whole chunk
+	std::tuple<Accessor<Ts>...> accessors(MakeAccessor<Ts>(archetype, &chunk)...);
+	Entity** entities = archetype->GetEntities(chunk);
+
+	// chunks only ever fail on sparse set types, a table only view never checks entities
+	const bool checkEntities = anySparse || excludedSparse.any() || sparseFilters;
+	const Tick tick = storage->GetTick();
+
+	for (std::size_t i = begin; i < end; i++) {
+		if (checkEntities && !Matches(*entities[i])) continue;
+
+		std::uint32_t index = anySparse ? entities[i]->GetId().index : 0;
+		if constexpr (anySparse) (std::get<I>(accessors).Mark(index, tick), ...);
+		Invoke(f, *entities[i], *std::get<I>(accessors).Get(i, index)...);
+	}
+}
+
+template<typename... Ts>
+template<typename F, std::size_t... I>
+inline void View<Ts...>::EachSparse(F& f, std::index_sequence<I...>)
+{
+	std::tuple<Accessor<Ts>...> accessors(MakeAccessor<Ts>(nullptr, nullptr)...);
+	if (!(std::get<I>(accessors).pool && ...)) return;
+
+	// walk the smallest pool, every other type is a lookup
+	const SparseSetBase* pools[] = { std::get<I>(accessors).pool... };
+	const SparseSetBase* smallest = pools[0];
+	for (auto pool : pools)
+		if (pool->Size() < smallest->Size()) smallest = pool;
+
+	const Tick tick = storage->GetTick();
+	const auto& indices = smallest->Indices();
+	for (std::size_t i = 0; i < indices.size(); i++) {
+		Entity& e = *storage->GetEntity(indices[i]);
+		if (!Matches(e)) continue;
+
+		(std::get<I>(accessors).Mark(indices[i], tick), ...);
+		Invoke(f, e, *std::get<I>(accessors).Get(i, indices[i])...);
+	}
+}
+
+#endif
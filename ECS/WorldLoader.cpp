@@ -0,0 +1,83 @@
+#include "WorldLoader.h"
+#include "EntityManager.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+WorldLoader::WorldLoader(EntityManager& manager, const std::string& path, std::size_t batchSize) :
+	manager(manager), snapshot(path, *manager.GetStorage()), batchSize(std::max<std::size_t>(1, batchSize)),
+	remap(snapshot.SlotCount()), block(0), row(0), loaded(0), total(0)
+{
+	for (auto& b : snapshot.GetBlocks()) total += b.rows;
+
+	for (auto& p : snapshot.GetPoolBlocks()) {
+		total += p.count;
+
+		std::vector<std::uint32_t> of(snapshot.SlotCount(), invalid);
+		for (std::uint32_t i = 0; i < p.count; i++)
+			if (p.indices[i] < of.size()) of[p.indices[i]] = i;
+		elementOf.push_back(std::move(of));
+	}
+
+	restored.reserve(this->batchSize);
+}
+
+bool WorldLoader::Step(std::chrono::microseconds budget)
+{
+	const auto deadline = std::chrono::steady_clock::now() + budget;
+
+	while (!Done()) {
+		loaded += RestoreBatch();
+		if (std::chrono::steady_clock::now() >= deadline) break;
+	}
+
+	return Done();
+}
+
+std::size_t WorldLoader::RestoreBatch()
+{
+	const auto& blocks = snapshot.GetBlocks();
+	ComponentStorage* storage = manager.GetStorage();
+
+	// skip finished and empty blocks
+	while (block < blocks.size() && row == blocks[block].rows) {
+		block++;
+		row = 0;
+	}
+
+	if (block == blocks.size()) {
+		// every row is in, anything left over belongs to no entity
+		if (loaded != total) throw std::runtime_error("WorldLoader, a snapshot has sparse set components of entities without a row");
+		return 0;
+	}
+
+	const WorldSnapshot::Block& b = blocks[block];
+	std::size_t end = std::min<std::size_t>(b.rows, row + batchSize);
+	snapshot.RestoreRows(*storage, b, row, end, restored, remap.data());
+	std::size_t count = end - row;
+
+	// the same entities' sparse set components, before anything can see them
+	const auto& pools = snapshot.GetPoolBlocks();
+	for (std::size_t p = 0; p < pools.size(); p++) {
+		elements.clear();
+		for (std::size_t r = row; r < end; r++) {
+			const std::uint32_t element = elementOf[p][b.indices[r]];
+			if (element != invalid) elements.push_back(element);
+		}
+
+		snapshot.RestorePoolElements(*storage, pools[p], elements.data(), elements.size(), remap.data());
+		count += elements.size();
+	}
+
+	for (auto e : restored) manager.AddEntity(e);
+	restored.clear();
+
+	row = end;
+	return count;
+}
+
+EntityId WorldLoader::Remap(EntityId saved) const
+{
+	if (saved.index >= remap.size() || snapshot.SavedId(saved.index) != saved) return EntityId::null;
+	return remap[saved.index];
+}
@@ -0,0 +1,69 @@
+#ifndef WORLD_LOADER_H
+#define WORLD_LOADER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "WorldSnapshot.h"
+
+class EntityManager;
+
+// Streams a world snapshot into a running world a few batches per frame, e.g.
+//   WorldLoader loader(*manager, "region.world");
+//   every frame: loader.Step(std::chrono::microseconds(2000)); manager->Update();
+// Entities get fresh ids and are handed to EntityManager::AddEntity, they join the update on the
+// next AddNewEntities like any other new entity. Each batch restores a run of rows together with
+// the sparse set components of those entities, so systems never see a half loaded entity.
+// The file stays mapped until the loader is destroyed. Step must be called between updates.
+class WorldLoader {
+public:
+	// Maps and checks the file, see WorldSnapshot. batchSize is the number of rows or sparse set
+	// components restored between looks at the clock.
+	WorldLoader(EntityManager& manager, const std::string& path, std::size_t batchSize = 1024);
+
+	// Restores batches until budget is used up or everything is in, returns Done.
+	// Throws std::runtime_error if the file has sparse set components of entities without a row.
+	// A batch that is started is finished, so a step can overrun by up to one batch.
+	bool Step(std::chrono::microseconds budget);
+
+	bool Done() const { return loaded == total; }
+	// Rows plus sparse set components restored so far, out of Total
+	std::size_t Loaded() const { return loaded; }
+	std::size_t Total() const { return total; }
+	float Progress() const { return total == 0 ? 1.0f : static_cast<float>(loaded) / static_cast<float>(total); }
+
+	// Id the entity saved as saved has in this world, null if it isn't loaded yet
+	EntityId Remap(EntityId saved) const;
+
+private:
+	static constexpr std::uint32_t invalid = ~std::uint32_t(0);
+
+	WorldLoader(WorldLoader& other) = delete;
+	void operator=(const WorldLoader&) = delete;
+
+	// Restores the next batch, returns how many rows / components it took
+	std::size_t RestoreBatch();
+
+	EntityManager& manager;
+	WorldSnapshot snapshot;
+	std::size_t batchSize;
+
+	// saved index -> id in this world
+	std::vector<EntityId> remap;
+	std::vector<Entity*> restored;
+
+	// next block and row to restore
+	std::size_t block;
+	std::size_t row;
+
+	// per pool block, saved index -> element of that entity, invalid if it has none
+	std::vector<std::vector<std::uint32_t>> elementOf;
+	std::vector<std::uint32_t> elements;
+
+	std::size_t loaded;
+	std::size_t total;
+
+};
+
+#endif
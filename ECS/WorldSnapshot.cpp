@@ -0,0 +1,390 @@
+#include "WorldSnapshot.h"
+#include "Entity.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static const char MAGIC[4] = { 'E', 'C', 'S', 'W' };
+// written as is, reads back differently on a machine with the other byte order
+static const std::uint32_t BYTE_ORDER_MARK = 0x01020304u;
+static const std::size_t SECTION_ALIGN = 64;
+
+// slot flags
+static const std::uint32_t SLOT_USED = 1u;
+static const std::uint32_t SLOT_ALIVE = 2u;
+
+struct SnapshotHeader {
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t byteOrder;
+	std::uint32_t typeCount;
+	std::uint32_t slotCount;
+	std::uint32_t blockCount;
+	std::uint32_t poolCount;
+	std::uint32_t entityCount;
+};
+
+struct TypeRecord {
+	std::uint32_t id;
+	std::uint32_t nameHash;
+	std::uint32_t size;
+	std::uint32_t align;
+};
+
+struct BlockRecord {
+	std::uint32_t typeCount;
+	std::uint32_t rows;
+};
+
+struct PoolRecord {
+	std::uint32_t id;
+	std::uint32_t count;
+};
+
+// Appends arrays to the file, each padded out to SECTION_ALIGN
+class SnapshotWriter {
+public:
+	SnapshotWriter(const std::string& path) : out(path, std::ios::binary | std::ios::trunc), offset(0) {
+		if (!out) throw std::runtime_error("WorldSnapshot::Save, can't open " + path);
+	}
+
+	void Write(const void* data, std::size_t bytes) {
+		out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+		offset += bytes;
+	}
+
+	template<typename T>
+	void Write(const T& value) { Write(&value, sizeof(T)); }
+
+	void Align() {
+		static const char zeros[SECTION_ALIGN] = {};
+		std::size_t padding = (SECTION_ALIGN - offset % SECTION_ALIGN) % SECTION_ALIGN;
+		Write(zeros, padding);
+	}
+
+	void Finish(const std::string& path) {
+		out.flush();
+		if (!out) throw std::runtime_error("WorldSnapshot::Save, failed writing " + path);
+	}
+
+private:
+	std::ofstream out;
+	std::size_t offset;
+};
+
+// Walks the mapped file, every read is bounds checked
+class SnapshotReader {
+public:
+	SnapshotReader(const unsigned char* data, std::size_t size) : data(data), size(size), offset(0) {}
+
+	template<typename T>
+	const T* Take(std::size_t count) {
+		if (count > (size - offset) / sizeof(T)) throw std::runtime_error("WorldSnapshot, file is truncated");
+
+		const T* at = reinterpret_cast<const T*>(data + offset);
+		offset += count * sizeof(T);
+		return at;
+	}
+
+	void Align() {
+		offset = std::min(size, (offset + SECTION_ALIGN - 1) / SECTION_ALIGN * SECTION_ALIGN);
+	}
+
+private:
+	const unsigned char* data;
+	std::size_t size;
+	std::size_t offset;
+};
+
+void WorldSnapshot::Save(const ComponentStorage& storage, const std::string& path)
+{
+	std::vector<Archetype*> archetypes;
+	std::vector<TypeID> pools;
+	Signature used;
+	std::uint32_t entityCount = 0;
+
+	for (auto& archetype : storage.GetArchetypes()) {
+		if (archetype->Size() == 0) continue;
+
+		archetypes.push_back(archetype.get());
+		used |= archetype->GetSignature();
+		entityCount += static_cast<std::uint32_t>(archetype->Size());
+	}
+	for (TypeID id = 0; id < ECS_MAX_COMPONENTS; id++) {
+		SparseSetBase* pool = storage.GetPool(id);
+		if (pool == nullptr || pool->Empty() || storage.IsTransient(id)) continue;
+
+		pools.push_back(id);
+		used.set(id);
+	}
+
+	std::vector<TypeRecord> types;
+	forEachComponentId(used, [&](TypeID id) {
+		const ComponentInfo* info = storage.GetInfo(id);
+		if (info->restore == nullptr)
+			throw std::logic_error(std::string("WorldSnapshot::Save, ") + info->name + " can't be snapshotted");
+
+		types.push_back(TypeRecord{ static_cast<std::uint32_t>(id), info->nameHash, static_cast<std::uint32_t>(info->size), static_cast<std::uint32_t>(info->align) });
+	});
+
+	SnapshotWriter out(path);
+
+	SnapshotHeader header;
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = version;
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.typeCount = static_cast<std::uint32_t>(types.size());
+	header.slotCount = storage.SlotCount();
+	header.blockCount = static_cast<std::uint32_t>(archetypes.size());
+	header.poolCount = static_cast<std::uint32_t>(pools.size());
+	header.entityCount = entityCount;
+	out.Write(header);
+	out.Align();
+
+	out.Write(types.data(), types.size() * sizeof(TypeRecord));
+	out.Align();
+
+	std::vector<std::uint32_t> words(header.slotCount);
+	for (std::uint32_t i = 0; i < header.slotCount; i++) words[i] = storage.SlotGeneration(i);
+	out.Write(words.data(), words.size() * sizeof(std::uint32_t));
+	out.Align();
+
+	for (std::uint32_t i = 0; i < header.slotCount; i++) {
+		Entity* e = storage.GetEntity(i);
+		words[i] = e ? (SLOT_USED | (e->isAlive() ? SLOT_ALIVE : 0u)) : 0u;
+	}
+	out.Write(words.data(), words.size() * sizeof(std::uint32_t));
+	out.Align();
+
+	for (auto archetype : archetypes) {
+		const auto& columns = archetype->GetTypes();
+
+		out.Write(BlockRecord{ static_cast<std::uint32_t>(columns.size()), static_cast<std::uint32_t>(archetype->Size()) });
+		for (auto t : columns) out.Write(static_cast<std::uint32_t>(t->id));
+		out.Align();
+
+		words.clear();
+		for (std::size_t c = 0; c < archetype->ChunkCount(); c++) {
+			const Chunk& chunk = archetype->GetChunk(c);
+			Entity** entities = archetype->GetEntities(chunk);
+			for (std::size_t i = 0; i < chunk.count; i++) words.push_back(entities[i]->GetId().index);
+		}
+		out.Write(words.data(), words.size() * sizeof(std::uint32_t));
+		out.Align();
+
+		// each column as one run, chunk after chunk
+		for (std::size_t column = 0; column < columns.size(); column++) {
+			for (std::size_t c = 0; c < archetype->ChunkCount(); c++) {
+				const Chunk& chunk = archetype->GetChunk(c);
+				out.Write(archetype->GetColumn(chunk, column), chunk.count * columns[column]->size);
+			}
+			out.Align();
+		}
+	}
+
+	for (TypeID id : pools) {
+		const SparseSetBase* pool = storage.GetPool(id);
+		const auto& indices = pool->Indices();
+
+		out.Write(PoolRecord{ static_cast<std::uint32_t>(id), static_cast<std::uint32_t>(indices.size()) });
+		out.Align();
+		out.Write(indices.data(), indices.size() * sizeof(std::uint32_t));
+		out.Align();
+		out.Write(pool->PackedData(), indices.size() * storage.GetInfo(id)->size);
+		out.Align();
+	}
+
+	out.Finish(path);
+}
+
+WorldSnapshot::WorldSnapshot(const std::string& path, ComponentStorage& storage) : path(path), file(new MappedFile(path)), generations(nullptr), flags(nullptr), slotCount(0), entityCount(0)
+{
+	SnapshotReader in(file->Data(), file->Size());
+
+	const SnapshotHeader& header = *in.Take<SnapshotHeader>(1);
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) throw std::runtime_error("WorldSnapshot, " + path + " is not a world snapshot");
+	if (header.byteOrder != BYTE_ORDER_MARK) throw std::runtime_error("WorldSnapshot, " + path + " was written with another byte order");
+	if (header.version != version) throw std::runtime_error("WorldSnapshot, " + path + " is version " + std::to_string(header.version));
+	in.Align();
+
+	// every type in the file has to be known here with the same layout
+	const TypeRecord* types = in.Take<TypeRecord>(header.typeCount);
+	Signature known;
+	for (std::uint32_t i = 0; i < header.typeCount; i++) {
+		const TypeRecord& record = types[i];
+		const ComponentInfo* info = record.id < ECS_MAX_COMPONENTS ? storage.GetInfo(record.id) : nullptr;
+
+		if (info == nullptr || info->nameHash != record.nameHash)
+			throw std::runtime_error("WorldSnapshot, component id " + std::to_string(record.id) + " in " + path + " is not registered as the same type");
+		if (info->size != record.size || info->align != record.align || info->restore == nullptr)
+			throw std::runtime_error(std::string("WorldSnapshot, ") + info->name + " in " + path + " has a different layout");
+		known.set(record.id);
+	}
+	in.Align();
+
+	slotCount = header.slotCount;
+	generations = in.Take<std::uint32_t>(slotCount);
+	in.Align();
+	flags = in.Take<std::uint32_t>(slotCount);
+	in.Align();
+
+	for (std::uint32_t b = 0; b < header.blockCount; b++) {
+		const BlockRecord& record = *in.Take<BlockRecord>(1);
+		const std::uint32_t* ids = in.Take<std::uint32_t>(record.typeCount);
+		in.Align();
+
+		std::vector<const ComponentInfo*> columns;
+		for (std::uint32_t i = 0; i < record.typeCount; i++) {
+			// written in column order, which is id order
+			if (ids[i] >= ECS_MAX_COMPONENTS || !known.test(ids[i]) || (i > 0 && ids[i] <= ids[i - 1]) || storage.GetPool(ids[i]))
+				throw std::runtime_error("WorldSnapshot, " + path + " has an archetype that doesn't match the component types");
+			columns.push_back(storage.GetInfo(ids[i]));
+		}
+
+		Block block;
+		block.archetype = storage.GetArchetype(columns);
+		block.rows = record.rows;
+		block.indices = in.Take<std::uint32_t>(record.rows);
+		in.Align();
+
+		for (auto info : columns) {
+			block.columns.push_back(in.Take<unsigned char>(record.rows * info->size));
+			in.Align();
+		}
+
+		entityCount += record.rows;
+		blocks.push_back(std::move(block));
+	}
+
+	for (std::uint32_t p = 0; p < header.poolCount; p++) {
+		const PoolRecord& record = *in.Take<PoolRecord>(1);
+		in.Align();
+
+		bool pooled = record.id < ECS_MAX_COMPONENTS && known.test(record.id) && storage.GetPool(record.id);
+		if (!pooled || storage.IsTransient(record.id))
+			throw std::runtime_error("WorldSnapshot, " + path + " has a pool for a component that isn't kept in one");
+
+		PoolBlock block;
+		block.id = record.id;
+		block.count = record.count;
+		block.indices = in.Take<std::uint32_t>(record.count);
+		in.Align();
+		block.data = in.Take<unsigned char>(record.count * storage.GetInfo(record.id)->size);
+		in.Align();
+
+		poolBlocks.push_back(block);
+	}
+}
+
+void WorldSnapshot::RestoreSlots(ComponentStorage& storage) const
+{
+	std::vector<std::uint32_t> generation(generations, generations + slotCount);
+	std::vector<bool> used(slotCount);
+	for (std::uint32_t i = 0; i < slotCount; i++) used[i] = (flags[i] & SLOT_USED) != 0;
+
+	storage.RestoreSlots(generation, used);
+}
+
+void WorldSnapshot::CheckIndices(const std::uint32_t* indices, std::size_t count) const
+{
+	for (std::size_t i = 0; i < count; i++)
+		if (indices[i] >= slotCount || !(flags[indices[i]] & SLOT_USED)) throw std::runtime_error("WorldSnapshot, " + path + " has a row for a free id");
+}
+
+void WorldSnapshot::RestoreRows(ComponentStorage& storage, const Block& block, std::size_t begin, std::size_t end, std::vector<Entity*>& restored, EntityId* remap) const
+{
+	if (begin >= end) return;
+	CheckIndices(block.indices + begin, end - begin);
+
+	Archetype* archetype = block.archetype;
+	const std::size_t first = restored.size();
+	const std::size_t firstRow = archetype->Size();
+	const std::size_t count = end - begin;
+
+	std::vector<EntityId> ids(count);
+	if (remap) storage.Reserve(ids.data(), count);
+	for (std::size_t i = 0; i < count; i++) {
+		std::uint32_t index = block.indices[begin + i];
+		if (remap) remap[index] = ids[i];
+		else ids[i] = EntityId(index, generations[index]);
+	}
+
+	storage.Restore(ids.data(), count, archetype, restored);
+	for (std::size_t i = 0; i < count; i++)
+		if (!(flags[block.indices[begin + i]] & SLOT_ALIVE)) restored[first + i]->kill();
+
+	// the new rows are contiguous, restore them a chunk at a time
+	const auto& columns = archetype->GetTypes();
+	const Tick tick = storage.GetTick();
+	for (std::size_t done = 0; done < count;) {
+		std::size_t row = firstRow + done;
+		std::size_t run = std::min(count - done, archetype->ChunkCapacity() - row % archetype->ChunkCapacity());
+
+		for (std::size_t c = 0; c < columns.size(); c++) {
+			columns[c]->restore(archetype->GetComponent(c, row), block.columns[c] + (begin + done) * columns[c]->size, run, restored.data() + first + done);
+			archetype->MarkAdded(c, row, tick);
+		}
+		done += run;
+	}
+
+	Observers* observers = storage.GetObservers();
+	const Signature observed = archetype->GetSignature() & observers->Observed(ObserverEvent::Add);
+	forEachComponentId(observed, [&](TypeID id) {
+		for (std::size_t i = first; i < restored.size(); i++) observers->Record(ObserverEvent::Add, id, restored[i]->GetId());
+	});
+}
+
+void WorldSnapshot::RestorePool(ComponentStorage& storage, const PoolBlock& block, std::size_t begin, std::size_t end, const EntityId* remap) const
+{
+	if (begin >= end) return;
+	CheckIndices(block.indices + begin, end - begin);
+
+	const std::size_t size = storage.GetInfo(block.id)->size;
+	if (remap == nullptr) {
+		storage.RestorePool(block.id, block.indices + begin, block.data + begin * size, end - begin);
+		return;
+	}
+
+	// entities may have been destroyed since their rows came in, restore the runs still alive
+	std::vector<std::uint32_t> remapped;
+	std::size_t runBegin = begin;
+	for (std::size_t i = begin; i <= end; i++) {
+		if (i < end && storage.IsValid(remap[block.indices[i]])) {
+			remapped.push_back(remap[block.indices[i]].index);
+			continue;
+		}
+
+		if (!remapped.empty()) storage.RestorePool(block.id, remapped.data(), block.data + runBegin * size, remapped.size());
+		remapped.clear();
+		runBegin = i + 1;
+	}
+}
+
+void WorldSnapshot::RestorePoolElements(ComponentStorage& storage, const PoolBlock& block, const std::uint32_t* elements, std::size_t count, const EntityId* remap) const
+{
+	if (count == 0) return;
+
+	const ComponentInfo* info = storage.GetInfo(block.id);
+
+	// gather the elements into one aligned run, restore copy constructs from it like from the file
+	std::vector<unsigned char> scratch(count * info->size + info->align);
+	unsigned char* data = scratch.data() + (info->align - reinterpret_cast<std::uintptr_t>(scratch.data()) % info->align) % info->align;
+
+	std::vector<std::uint32_t> indices;
+	indices.reserve(count);
+	for (std::size_t i = 0; i < count; i++) {
+		const std::uint32_t index = block.indices[elements[i]];
+		CheckIndices(&index, 1);
+
+		const std::uint32_t target = remap ? remap[index].index : index;
+		if (remap && !storage.IsValid(remap[index])) continue;
+
+		std::memcpy(data + indices.size() * info->size, block.data + elements[i] * info->size, info->size);
+		indices.push_back(target);
+	}
+
+	storage.RestorePool(block.id, indices.data(), data, indices.size());
+}
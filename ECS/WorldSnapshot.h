@@ -0,0 +1,100 @@
+#ifndef WORLD_SNAPSHOT_H
+#define WORLD_SNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ComponentStorage.h"
+#include "MappedFile.h"
+
+// Binary image of every entity and component in a ComponentStorage, laid out like the storage itself:
+//   header, one record per component type (id, name hash, size, align),
+//   one generation + flags per entity id slot,
+//   one block per archetype: its type ids, the entity index of every row, then every column as
+//   the rows components back to back exactly as they sit in the chunks,
+//   one block per sparse set pool: the entity indices, then the packed components.
+// Every array starts on a 64 byte boundary so it can be used in place once the file is mapped.
+// Components are stored as raw bytes and copy constructed straight out of the mapping on load,
+// so only types that opt in through Component::bitwiseSnapshot can be saved. Transient
+// components, the transform hierarchy and any Entity subclass are not saved, entities come
+// back as plain Entity.
+// Ids survive a save and load, handles held by components stay valid.
+class WorldSnapshot {
+public:
+	static constexpr std::uint32_t version = 1;
+
+	// Writes everything in the storage to path. Throws std::logic_error if a live component type
+	// can't be snapshotted and std::runtime_error if the file can't be written.
+	static void Save(const ComponentStorage& storage, const std::string& path);
+
+	// Maps the file and checks it against the component types known to the storage, nothing is
+	// restored yet. Throws std::runtime_error if the file is damaged, from another version, or holds
+	// a type the storage doesn't know (see ComponentStorage::Register) or knows with another layout.
+	WorldSnapshot(const std::string& path, ComponentStorage& storage);
+
+	// Rows of one archetype
+	struct Block {
+		Archetype* archetype;
+		std::uint32_t rows;
+		// entity index of every row
+		const std::uint32_t* indices;
+		// one per archetype column, rows components each
+		std::vector<const unsigned char*> columns;
+	};
+
+	// Packed components of one sparse set pool
+	struct PoolBlock {
+		TypeID id;
+		std::uint32_t count;
+		const std::uint32_t* indices;
+		const unsigned char* data;
+	};
+
+	const std::vector<Block>& GetBlocks() const { return blocks; }
+	const std::vector<PoolBlock>& GetPoolBlocks() const { return poolBlocks; }
+	// Entities in the file, live or killed
+	std::size_t EntityCount() const { return entityCount; }
+	// Id slots in the file, one past the highest saved index
+	std::uint32_t SlotCount() const { return slotCount; }
+	// Id the entity in slot index had when saved
+	EntityId SavedId(std::uint32_t index) const { return EntityId(index, generations[index]); }
+
+	// Puts the saved id slots in place, must be done first and only while the storage has no entities
+	void RestoreSlots(ComponentStorage& storage) const;
+	// Creates the entities of rows [begin, end) of the block and restores their table components,
+	// one bulk copy per chunk and column. The new entities are appended to restored.
+	// Entities keep their saved ids unless remap is given, then each gets a fresh one which is
+	// written to remap[saved index], so a file can be loaded into a world that is in use.
+	// remap needs SlotCount entries.
+	void RestoreRows(ComponentStorage& storage, const Block& block, std::size_t begin, std::size_t end, std::vector<Entity*>& restored, EntityId* remap = nullptr) const;
+	// Restores elements [begin, end) of a pool block, their entities must have been restored already.
+	// With a remap, the one RestoreRows filled, elements of entities destroyed since are skipped.
+	void RestorePool(ComponentStorage& storage, const PoolBlock& block, std::size_t begin, std::size_t end, const EntityId* remap = nullptr) const;
+	// Same for the count elements of the block listed in elements, in any order, e.g. the ones
+	// belonging to a batch of rows just restored
+	void RestorePoolElements(ComponentStorage& storage, const PoolBlock& block, const std::uint32_t* elements, std::size_t count, const EntityId* remap = nullptr) const;
+
+private:
+	WorldSnapshot(WorldSnapshot& other) = delete;
+	void operator=(const WorldSnapshot&) = delete;
+
+	// Indices are checked as they are restored, checking them all up front would touch the whole file
+	void CheckIndices(const std::uint32_t* indices, std::size_t count) const;
+
+	std::string path;
+	std::unique_ptr<MappedFile> file;
+
+	// per slot, see RestoreSlots
+	const std::uint32_t* generations;
+	const std::uint32_t* flags;
+	std::uint32_t slotCount;
+
+	std::vector<Block> blocks;
+	std::vector<PoolBlock> poolBlocks;
+	std::size_t entityCount;
+
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include <iostream>
 
 #include "EntityManager.h"
+#include "Profiler.h"
 
 #include "ComponentOne.h"
 #include "ComponentTwo.h"
@@ -9,10 +10,21 @@ int main()
 {
 	EntityManager* manager = new EntityManager();
 
-	Entity* first = new Entity(Vec3(1,2,3), Quat(0,0,0,1), Vec3(1,1,1));
+#ifdef ECS_PROFILE
+	Profiler::Get().StartCapture();
+#endif
 
-	ComponentOne* compOne = &first->add<ComponentOne>(3, 5);
-	first->add<ComponentTwo>(7, 9, compOne);
+	manager->GetObservers()->OnAdd<ComponentOne>([](EntityManager&, const std::vector<EntityId>& added) {
+		std::cout << "ComponentOne added to " << added.size() << " entities" << std::endl;
+	});
+	manager->GetObservers()->OnDestroy<Transform>([](EntityManager&, const std::vector<EntityId>& destroyed) {
+		for (auto id : destroyed) std::cout << "Entity " << id << " destroyed" << std::endl;
+	});
+
+	Entity* first = new Entity(*manager, Vec3(1,2,3), Quat(0,0,0,1), Vec3(1,1,1));
+
+	first->add<ComponentOne>(3, 5);
+	first->add<ComponentTwo>(7, 9);
 
 	std::cout << "Transform Component ID: " << first->get<Transform>().id << std::endl;
 	std::cout << "ComponentOne ID: " << first->get<ComponentOne>().id << std::endl;
@@ -37,11 +49,11 @@ int main()
 	first->Update();
 	first->Update();
 
-	Entity* second = new Entity(Vec3(1, 2, 3), Quat(0, 0, 0, 1), Vec3(1, 1, 1));
-	compOne = &second->add<ComponentOne>(3, 5);
-	second->add<ComponentTwo>(7, 9, compOne);
+	Entity* second = new Entity(*manager, Vec3(1, 2, 3), Quat(0, 0, 0, 1), Vec3(1, 1, 1));
+	second->add<ComponentOne>(3, 5);
+	second->add<ComponentTwo>(7, 9);
 
-	Entity* third = new Entity(Vec3(1, 2, 3), Quat(0, 0, 0, 1), Vec3(1, 1, 1));
+	Entity* third = new Entity(*manager, Vec3(1, 2, 3), Quat(0, 0, 0, 1), Vec3(1, 1, 1));
 	third->add<ComponentOne>(3, 5);
 
 	manager->AddEntity(first);
@@ -52,14 +64,48 @@ int main()
 	manager->AddNewEntities();
 
 	manager->Update();
+	ECS_PROFILE_FRAME();
 	manager->Update();
+	ECS_PROFILE_FRAME();
+	manager->Update();
+	ECS_PROFILE_FRAME();
+
+	manager->view<const Transform, ComponentOne>().each([](Entity& e, const Transform& t, ComponentOne& c) {
+		std::cout << "View entity " << e.GetId() << " at " << t.position << " with ";
+		c.Print();
+	});
+
+	manager->view<const ComponentOne>().exclude<ComponentTwo>().each([](Entity& e, const ComponentOne&) {
+		std::cout << "Entity " << e.GetId() << " has ComponentOne but not ComponentTwo" << std::endl;
+	});
+
+	// third follows first around
+	manager->GetHierarchy()->SetParent(third->GetId(), first->GetId());
+	first->transform->position = Vec3(10, 0, 0);
+	first->markChanged<Transform>();
 	manager->Update();
+	ECS_PROFILE_FRAME();
+	std::cout << "Third world position: " << manager->GetHierarchy()->GetWorldPosition(third->GetId()) << std::endl;
 
 	second->kill();
 
+	// a wave of identical entities in one batch
+	Prefab wave(Vec3(0, 0, 5), Quat::identity, Vec3::one);
+	wave.add<ComponentOne>(1, 1);
+	std::vector<EntityId> spawned = manager->Instantiate(wave, 4);
+	std::cout << "Spawned " << spawned.size() << " entities from a prefab, first " << spawned.front() << std::endl;
+
 	manager->Update();
+	ECS_PROFILE_FRAME();
 	manager->Update();
+	ECS_PROFILE_FRAME();
 	manager->Update();
+	ECS_PROFILE_FRAME();
+
+#ifdef ECS_PROFILE
+	Profiler::Get().PrintStats(std::cout);
+	Profiler::Get().WriteTrace("ecs_trace.json");
+#endif
 
 	manager->Purge();
 
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <vector>
+
+#include "EntityManager.h"
+#include "Test.h"
+#include "TestComponents.h"
+
+namespace {
+	template<typename... Fs>
+	std::vector<EntityId> Passing(EntityManager& world, Tick since)
+	{
+		std::vector<EntityId> ids;
+		world.view<const Transform>().filter<Fs...>(since).each([&](Entity& e, const Transform&) { ids.push_back(e.GetId()); });
+		return ids;
+	}
+
+	bool Holds(const std::vector<EntityId>& ids, EntityId id)
+	{
+		return std::find(ids.begin(), ids.end(), id) != ids.end();
+	}
+}
+
+ECS_TEST(ChangeTracking, UpdateDoesNotStampComponents)
+{
+	EntityManager world(0);
+	std::vector<Entity*> created;
+	for (int i = 0; i < 20; i++) {
+		created.push_back(world.CreateEntity(Vec3(i, 0, 0)));
+		created.back()->add<TestTable>(i);
+	}
+	world.Update();
+
+	const Tick since = world.GetStorage()->GetTick();
+	world.Update();
+	world.Update();
+
+	// every component was updated, none of them wrote anything
+	for (auto e : created) ECS_CHECK(e->get<TestTable>().updates > 0);
+	ECS_CHECK(Passing<Changed<TestTable>>(world, since).empty());
+	ECS_CHECK(Passing<Changed<Transform>>(world, since).empty());
+	ECS_CHECK(Passing<Added<TestTable>>(world, since).empty());
+}
+
+ECS_TEST(ChangeTracking, TableChangesPassWholeChunks)
+{
+	EntityManager world(0);
+	std::vector<Entity*> bare;
+	std::vector<Entity*> withTable;
+	for (int i = 0; i < 10; i++) {
+		bare.push_back(world.CreateEntity());
+		withTable.push_back(world.CreateEntity());
+		withTable.back()->add<TestTable>(i);
+	}
+	world.Update();
+
+	Tick since = world.GetStorage()->GetTick();
+	bare[3]->transform->position = Vec3(1, 1, 1);
+	bare[3]->markChanged<Transform>();
+
+	// the other archetype's chunk is skipped, the written one passes as a whole
+	std::vector<EntityId> passing = Passing<Changed<Transform>>(world, since);
+	ECS_CHECK(Holds(passing, bare[3]->GetId()));
+	for (auto e : withTable) ECS_CHECK(!Holds(passing, e->GetId()));
+
+	// const access reads without stamping, non const access stamps what it iterates
+	world.Update();
+	since = world.GetStorage()->GetTick();
+	world.view<const TestTable>().each([](const TestTable&) {});
+	ECS_CHECK(Passing<Changed<TestTable>>(world, since).empty());
+	world.view<TestTable>().each([](TestTable& t) { t.value += 1; });
+	ECS_CHECK_EQ(Passing<Changed<TestTable>>(world, since).size(), withTable.size());
+}
+
+ECS_TEST(ChangeTracking, SparseChangesArePerEntity)
+{
+	EntityManager world(0);
+	std::vector<Entity*> created;
+	for (int i = 0; i < 20; i++) {
+		created.push_back(world.CreateEntity());
+		if (i < 10) created.back()->add<TestSparse>(i);
+	}
+	world.Update();
+
+	const Tick since = world.GetStorage()->GetTick();
+	created[4]->get<TestSparse>().value = 40;
+	created[4]->markChanged<TestSparse>();
+	created[15]->add<TestSparse>(15);
+
+	// adding counts as a change, the other entities' components were left alone
+	std::vector<EntityId> changed = Passing<Changed<TestSparse>>(world, since);
+	std::sort(changed.begin(), changed.end(), [](EntityId a, EntityId b) { return a.index < b.index; });
+	ECS_CHECK(changed == (std::vector<EntityId>{ created[4]->GetId(), created[15]->GetId() }));
+
+	ECS_CHECK(Passing<Added<TestSparse>>(world, since) == std::vector<EntityId>{ created[15]->GetId() });
+}
+
+ECS_TEST(ChangeTracking, DefaultFilterSeesThisFrameAndTheLast)
+{
+	EntityManager world(0);
+	Entity* e = world.CreateEntity();
+	e->add<TestSparse>(1);
+	world.Update();
+	world.Update();
+
+	auto changed = [&]() {
+		std::size_t count = 0;
+		world.view<const TestSparse>().filter<Changed<TestSparse>>().each([&](const TestSparse&) { count++; });
+		return count;
+	};
+
+	ECS_CHECK_EQ(changed(), 0u);
+	e->markChanged<TestSparse>();
+	ECS_CHECK_EQ(changed(), 1u);
+	world.Update();
+	ECS_CHECK_EQ(changed(), 1u);
+	world.Update();
+	ECS_CHECK_EQ(changed(), 0u);
+}
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Quat.h"
+#include "Test.h"
+#include "TransformStore.h"
+
+namespace {
+	// lengths around every vector width, so both full blocks and tails are covered
+	const std::size_t lengths[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 257, 4099 };
+
+	Quat RandomQuat(std::mt19937& rng)
+	{
+		std::normal_distribution<double> normal(0, 1);
+		return Quat(normal(rng), normal(rng), normal(rng), normal(rng)).Normalize();
+	}
+
+	double Difference(const Quat& a, const Quat& b)
+	{
+		return std::max({ std::fabs(a.x - b.x), std::fabs(a.y - b.y), std::fabs(a.z - b.z), std::fabs(a.w - b.w) });
+	}
+
+	// q and -q are the same rotation, batches may return either for opposite inputs
+	double RotationDifference(const Quat& a, const Quat& b)
+	{
+		return std::min(Difference(a, b), Difference(a, -b));
+	}
+
+	// Pairs to interpolate between: random ones, plus a == b and a == -b mixed in at every lane position
+	void RandomPairs(std::mt19937& rng, std::size_t n, std::vector<Quat>& a, std::vector<Quat>& b)
+	{
+		a.clear();
+		b.clear();
+		for (std::size_t i = 0; i < n; i++) {
+			a.push_back(RandomQuat(rng));
+			if (i % 5 == 1) b.push_back(a.back());
+			else if (i % 7 == 3) b.push_back(-a.back());
+			else b.push_back(RandomQuat(rng));
+		}
+	}
+
+	void CheckKernelsMatchScalar(const TransformKernels& kernels)
+	{
+		const TransformKernels& scalar = TransformKernels::Scalar();
+		std::mt19937 rng(11);
+		std::uniform_real_distribution<float> value(-100, 100);
+
+		for (std::size_t n : lengths) {
+			std::vector<float> in[10];
+			for (auto& column : in)
+				for (std::size_t i = 0; i < n; i++) column.push_back(value(rng));
+			// unit rotations in the first four columns
+			for (std::size_t i = 0; i < n; i++) {
+				Quat q = RandomQuat(rng);
+				in[0][i] = float(q.x); in[1][i] = float(q.y); in[2][i] = float(q.z); in[3][i] = float(q.w);
+			}
+
+			// one padding value past the end, kernels must leave it alone
+			std::vector<float> expected[3];
+			std::vector<float> actual[3];
+			auto reset = [&]() {
+				for (int c = 0; c < 3; c++) {
+					expected[c].assign(in[4 + c].begin(), in[4 + c].end());
+					expected[c].push_back(12345.0f);
+					actual[c] = expected[c];
+				}
+			};
+
+			reset();
+			scalar.translate(expected[0].data(), expected[1].data(), expected[2].data(), in[7].data(), in[8].data(), in[9].data(), n);
+			kernels.translate(actual[0].data(), actual[1].data(), actual[2].data(), in[7].data(), in[8].data(), in[9].data(), n);
+			for (int c = 0; c < 3; c++) ECS_CHECK(actual[c] == expected[c]);
+
+			reset();
+			scalar.scale(expected[0].data(), expected[1].data(), expected[2].data(), in[7].data(), in[8].data(), in[9].data(), n);
+			kernels.scale(actual[0].data(), actual[1].data(), actual[2].data(), in[7].data(), in[8].data(), in[9].data(), n);
+			for (int c = 0; c < 3; c++) ECS_CHECK(actual[c] == expected[c]);
+
+			// fused multiply adds round differently, a few ulps apart is the same answer
+			reset();
+			scalar.rotate(in[0].data(), in[1].data(), in[2].data(), in[3].data(), expected[0].data(), expected[1].data(), expected[2].data(), n);
+			kernels.rotate(in[0].data(), in[1].data(), in[2].data(), in[3].data(), actual[0].data(), actual[1].data(), actual[2].data(), n);
+			for (int c = 0; c < 3; c++) {
+				ECS_CHECK_EQ(actual[c][n], 12345.0f);
+				for (std::size_t i = 0; i < n; i++) ECS_CHECK(std::fabs(actual[c][i] - expected[c][i]) <= 1e-4f);
+			}
+		}
+	}
+}
+
+ECS_TEST(Kernels, SseMatchesScalar)
+{
+	if (TransformKernels::Sse()) CheckKernelsMatchScalar(*TransformKernels::Sse());
+}
+
+ECS_TEST(Kernels, Avx2MatchesScalar)
+{
+	if (TransformKernels::Avx2()) CheckKernelsMatchScalar(*TransformKernels::Avx2());
+}
+
+ECS_TEST(Kernels, SlerpBatchWithinDocumentedBound)
+{
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> unit(0, 1);
+	std::uniform_real_distribution<float> wide(-0.5f, 1.5f);
+	std::vector<Quat> a, b, out;
+
+	double slerpError = 0;
+	double freeError = 0;
+	for (std::size_t n : lengths) {
+		RandomPairs(rng, n, a, b);
+		std::vector<float> t;
+		// t outside [0, 1] clamps for Slerp and extrapolates for FreeSlerp
+		for (std::size_t i = 0; i < n; i++) t.push_back(i % 4 == 2 ? wide(rng) : unit(rng));
+
+		out.assign(n + 1, Quat(9, 9, 9, 9));
+		Quat::SlerpBatch(a.data(), b.data(), t.data(), out.data(), n);
+		ECS_CHECK(out[n] == Quat(9, 9, 9, 9));
+		for (std::size_t i = 0; i < n; i++) slerpError = std::max(slerpError, RotationDifference(out[i], Quat::Slerp(a[i], b[i], t[i])));
+
+		Quat::FreeSlerpBatch(a.data(), b.data(), t.data(), out.data(), n);
+		for (std::size_t i = 0; i < n; i++) freeError = std::max(freeError, RotationDifference(out[i], Quat::FreeSlerp(a[i], b[i], t[i])));
+
+		// in place
+		std::vector<Quat> inPlace = a;
+		Quat::SlerpBatch(inPlace.data(), b.data(), t.data(), inPlace.data(), n);
+		for (std::size_t i = 0; i < n; i++) ECS_CHECK(RotationDifference(inPlace[i], Quat::Slerp(a[i], b[i], t[i])) <= 5e-8);
+	}
+
+	// the acos and sin approximations are only reachable through the batches, these are the bounds
+	// Quat.h gives for the results once their 2e-8 and 7e-10 have gone through Slerp
+	ECS_CHECK(slerpError <= 5e-8);
+	ECS_CHECK(freeError <= 5e-8);
+}
+
+ECS_TEST(Kernels, RotateTowardsBatchWithinDocumentedBound)
+{
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> delta(0, 4);
+	std::vector<Quat> a, b, out;
+
+	double error = 0;
+	for (std::size_t n : lengths) {
+		RandomPairs(rng, n, a, b);
+		std::vector<float> deltas;
+		// negative steps back away, up to pi past the target
+		for (std::size_t i = 0; i < n; i++) deltas.push_back(i % 6 == 4 ? -delta(rng) : delta(rng));
+
+		out.assign(n + 1, Quat(9, 9, 9, 9));
+		Quat::RotateTowardsBatch(a.data(), b.data(), deltas.data(), out.data(), n);
+		ECS_CHECK(out[n] == Quat(9, 9, 9, 9));
+		for (std::size_t i = 0; i < n; i++) error = std::max(error, RotationDifference(out[i], Quat::RotateTowards(a[i], b[i], deltas[i])));
+	}
+
+	ECS_CHECK(error <= 1e-7);
+}
+
+ECS_TEST(Kernels, ExactBatchesMatchScalar)
+{
+	std::mt19937 rng(9);
+	std::uniform_real_distribution<double> value(-50, 50);
+	std::vector<Quat> a, b, out;
+
+	for (std::size_t n : lengths) {
+		RandomPairs(rng, n, a, b);
+		// not unit length, for Normalize
+		std::vector<Quat> scaled;
+		std::vector<Vec3> v;
+		for (std::size_t i = 0; i < n; i++) {
+			scaled.push_back(a[i] * (1 + std::fabs(value(rng))));
+			v.push_back(Vec3(value(rng), value(rng), value(rng)));
+		}
+
+		out.assign(n + 1, Quat(9, 9, 9, 9));
+		Quat::NormalizeBatch(scaled.data(), out.data(), n);
+		ECS_CHECK(out[n] == Quat(9, 9, 9, 9));
+		for (std::size_t i = 0; i < n; i++) ECS_CHECK(Difference(out[i], scaled[i].Normalize()) <= 1e-15);
+
+		Quat::MultiplyBatch(a.data(), b.data(), out.data(), n);
+		for (std::size_t i = 0; i < n; i++) ECS_CHECK(Difference(out[i], a[i] * b[i]) <= 1e-15);
+
+		std::vector<Vec3> rotated(n + 1, Vec3(9, 9, 9));
+		Quat::RotateBatch(a.data(), v.data(), rotated.data(), n);
+		ECS_CHECK(rotated[n] == Vec3(9, 9, 9));
+		for (std::size_t i = 0; i < n; i++) ECS_CHECK(rotated[i].SqrDistance(a[i] * v[i]) <= 1e-24);
+	}
+}
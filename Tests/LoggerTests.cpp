@@ -0,0 +1,186 @@
+// compiled at info whatever the build picked, so the stripping below is known
+#undef ECS_LOG_LEVEL
+#define ECS_LOG_LEVEL 2
+#include "Logger.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EntityId.h"
+#include "Quat.h"
+#include "Test.h"
+#include "Vec3.h"
+
+#define ECS_TEST_STRING(...) #__VA_ARGS__
+#define ECS_TEST_EXPANDED(...) ECS_TEST_STRING(__VA_ARGS__)
+
+namespace {
+	constexpr bool Same(const char* a, const char* b)
+	{
+		return *a == *b && (*a == 0 || Same(a + 1, b + 1));
+	}
+
+	// below the level a call is nothing at all, at or above it is a Write
+	static_assert(Same(ECS_TEST_EXPANDED(ECS_LOG_TRACE("x {}", 1)), "((void)0)"), "ECS_LOG_TRACE is compiled in at info");
+	static_assert(Same(ECS_TEST_EXPANDED(ECS_LOG_DEBUG("x {}", 1)), "((void)0)"), "ECS_LOG_DEBUG is compiled in at info");
+	static_assert(!Same(ECS_TEST_EXPANDED(ECS_LOG_INFO("x {}", 1)), "((void)0)"), "ECS_LOG_INFO is stripped at info");
+	static_assert(!Same(ECS_TEST_EXPANDED(ECS_LOG_ERROR("x {}", 1)), "((void)0)"), "ECS_LOG_ERROR is stripped at info");
+
+	const std::string path = "ecs_tests_log.txt";
+
+	struct Line {
+		double time;
+		std::string level;
+		std::string text;
+	};
+
+	// Flushes what was logged into path, then goes back to throwing records away
+	std::vector<Line> Collect()
+	{
+		Logger::Get().Discard();
+
+		std::vector<Line> lines;
+		std::ifstream in(path);
+		std::string line;
+		while (std::getline(in, line)) {
+			Line parsed{ 0, "", line };
+			// [time] [level] text, the logger's own notes have no time
+			const std::size_t timeEnd = line.find("] [");
+			if (!line.empty() && line[0] == '[' && timeEnd != std::string::npos) {
+				const std::size_t levelEnd = line.find("] ", timeEnd + 3);
+				parsed.time = std::stod(line.substr(1, timeEnd - 1));
+				parsed.level = line.substr(timeEnd + 3, levelEnd - timeEnd - 3);
+				parsed.text = line.substr(levelEnd + 2);
+			}
+			lines.push_back(parsed);
+		}
+		in.close();
+		std::remove(path.c_str());
+		return lines;
+	}
+}
+
+ECS_TEST(Logger, StrippedCallsDontEvaluateTheirArguments)
+{
+	int evaluated = 0;
+	ECS_LOG_TRACE("{}", ++evaluated);
+	ECS_LOG_DEBUG("{}", ++evaluated);
+	ECS_CHECK_EQ(evaluated, 0);
+}
+
+ECS_TEST(Logger, FormatsEveryArgumentType)
+{
+	Logger::Get().Open(path);
+
+	const EntityId id(12, 3);
+	const Vec3 v(1.5, -2, 0.25);
+	const Quat q(0, 0, 0, 1);
+	int value = 4;
+	Logger::Get().Write(LogLevel::Warning, "ints {} {} {}", -5, 7u, std::int64_t(-9000000000));
+	Logger::Get().Write(LogLevel::Info, "floats {} {}", 2.5, 0.25f);
+	Logger::Get().Write(LogLevel::Info, "bool {} char {} text {}", true, 'x', "literal");
+	Logger::Get().Write(LogLevel::Error, "id {} v {} q {}", id, v, q);
+	Logger::Get().Write(LogLevel::Info, "pointer {}", static_cast<const void*>(&value));
+	Logger::Get().Write(LogLevel::Debug, "missing {} {}", 1);
+	Logger::Get().Write(LogLevel::Info, "extra {}", 1, 2);
+	ECS_LOG_INFO("macro {}", value);
+
+	std::ostringstream objects;
+	objects << "id " << id << " v " << v << " q " << q;
+	std::ostringstream pointer;
+	pointer << "pointer " << static_cast<const void*>(&value);
+
+	const std::vector<Line> lines = Collect();
+	ECS_REQUIRE(lines.size() == 8);
+	ECS_CHECK(lines[0].level == "warning");
+	ECS_CHECK(lines[0].text == "ints -5 7 -9000000000");
+	ECS_CHECK(lines[1].text == "floats 2.5 0.25");
+	ECS_CHECK(lines[2].text == "bool 1 char x text literal");
+	ECS_CHECK(lines[3].level == "error");
+	ECS_CHECK(lines[3].text == objects.str());
+	ECS_CHECK(lines[4].text == pointer.str());
+	ECS_CHECK(lines[5].level == "debug");
+	ECS_CHECK(lines[5].text == "missing 1 {}");
+	ECS_CHECK(lines[6].text == "extra 1");
+	ECS_CHECK(lines[7].level == "info");
+	ECS_CHECK(lines[7].text == "macro 4");
+}
+
+ECS_TEST(Logger, ThreadsAreInterleavedInTimeOrder)
+{
+	Logger::Get().Open(path);
+
+	// the two threads take turns, so every record is stamped after the one before it was written
+	const int count = 2000;
+	std::atomic<int> turn(0);
+	auto writer = [&](int parity) {
+		for (int i = parity; i < count; i += 2) {
+			while (turn.load() != i) std::this_thread::yield();
+			Logger::Get().Write(LogLevel::Info, "{}", i);
+			turn.store(i + 1);
+		}
+	};
+	std::thread even(writer, 0);
+	std::thread odd(writer, 1);
+	even.join();
+	odd.join();
+
+	const std::vector<Line> lines = Collect();
+	ECS_REQUIRE(lines.size() == std::size_t(count));
+	for (int i = 0; i < count; i++) {
+		ECS_CHECK(lines[i].text == std::to_string(i));
+		if (i > 0) ECS_CHECK(lines[i - 1].time <= lines[i].time);
+	}
+}
+
+ECS_TEST(Logger, FullRingsCountWhatTheyDrop)
+{
+	Logger::Get().Open(path);
+	const std::uint64_t droppedBefore = Logger::Get().Dropped();
+
+	// far more than a ring holds, written faster than the text can be built
+	const std::size_t count = 50000;
+	std::thread writer([&] {
+		for (std::size_t i = 0; i < count; i++) Logger::Get().Write(LogLevel::Info, "record {}", i);
+	});
+	writer.join();
+
+	const std::uint64_t dropped = Logger::Get().Dropped() - droppedBefore;
+	const std::vector<Line> lines = Collect();
+
+	// every record was either written or counted, and the sink says how many went missing
+	std::size_t written = 0;
+	std::uint64_t reported = 0;
+	for (auto& line : lines) {
+		if (line.text.compare(0, 9, "[logger] ") == 0) reported += std::stoull(line.text.substr(9));
+		else written++;
+	}
+	ECS_CHECK(dropped > 0);
+	ECS_CHECK_EQ(written + dropped, count);
+	ECS_CHECK_EQ(reported, dropped);
+}
+
+ECS_TEST(Logger, ExitedThreadsRingsAreFreed)
+{
+	Logger::Get().Open(path);
+	Logger::Get().Write(LogLevel::Info, "main");
+	Logger::Get().Flush();
+	const std::size_t before = Logger::Get().RingCount();
+
+	for (int round = 0; round < 4; round++) {
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 8; i++) threads.emplace_back([i] { Logger::Get().Write(LogLevel::Info, "thread {}", i); });
+		for (auto& thread : threads) thread.join();
+	}
+
+	// the exited threads' records still make it out before their rings go
+	Logger::Get().Flush();
+	ECS_CHECK_EQ(Logger::Get().RingCount(), before);
+	ECS_CHECK_EQ(Collect().size(), 33u);
+}
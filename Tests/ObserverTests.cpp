@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "EntityManager.h"
+#include "Test.h"
+#include "TestComponents.h"
+
+namespace {
+	std::vector<EntityId> Sorted(std::vector<EntityId> ids)
+	{
+		std::sort(ids.begin(), ids.end(), [](EntityId a, EntityId b) { return a.index < b.index; });
+		return ids;
+	}
+}
+
+ECS_TEST(Observers, OneBatchPerTypePerDispatch)
+{
+	EntityManager world(0);
+	std::vector<Entity*> created;
+	for (int i = 0; i < 30; i++) created.push_back(world.CreateEntity());
+	world.Update();
+
+	std::vector<std::vector<EntityId>> tableBatches;
+	std::vector<std::vector<EntityId>> sparseBatches;
+	std::size_t secondObserver = 0;
+	world.GetObservers()->OnAdd<TestTable>([&](EntityManager&, const std::vector<EntityId>& ids) { tableBatches.push_back(ids); });
+	world.GetObservers()->OnAdd<TestTable>([&](EntityManager&, const std::vector<EntityId>&) { secondObserver++; });
+	world.GetObservers()->OnAdd<TestSparse>([&](EntityManager&, const std::vector<EntityId>& ids) { sparseBatches.push_back(ids); });
+
+	// adds spread over the frame, interleaved with other types, all go out together
+	std::vector<EntityId> expected;
+	for (std::size_t i = 0; i < created.size(); i++) {
+		created[i]->add<TestTable>(double(i));
+		expected.push_back(created[i]->GetId());
+		if (i % 4 == 0) created[i]->add<TestSparse>(int(i));
+	}
+	world.Update();
+
+	ECS_REQUIRE(tableBatches.size() == 1);
+	ECS_CHECK(tableBatches[0] == expected);
+	ECS_CHECK_EQ(secondObserver, 1u);
+	ECS_CHECK_EQ(sparseBatches.size(), 1u);
+
+	// nothing happened, nothing is called
+	world.Update();
+	ECS_CHECK_EQ(tableBatches.size(), 1u);
+	ECS_CHECK_EQ(sparseBatches.size(), 1u);
+}
+
+ECS_TEST(Observers, UnobservedTypesAreNotQueued)
+{
+	EntityManager world(0);
+	Entity* e = world.CreateEntity();
+	world.Update();
+
+	std::size_t calls = 0;
+	world.GetObservers()->OnRemove<TestSparse>([&](EntityManager&, const std::vector<EntityId>&) { calls++; });
+
+	// no add observer for either type and no remove observer for the table one
+	e->add<TestTable>(1);
+	e->add<TestSparse>(2);
+	e->remove<TestTable>();
+	ECS_CHECK(!world.GetObservers()->Pending());
+
+	e->remove<TestSparse>();
+	ECS_CHECK(world.GetObservers()->Pending());
+	world.Update();
+	ECS_CHECK_EQ(calls, 1u);
+	ECS_CHECK(!world.GetObservers()->Pending());
+}
+
+ECS_TEST(Observers, EventsFromCallbacksGoOutInALaterRound)
+{
+	EntityManager world(0);
+	Entity* first = world.CreateEntity();
+	Entity* second = world.CreateEntity();
+	world.Update();
+
+	std::vector<std::string> log;
+	std::vector<std::vector<EntityId>> tableBatches;
+	world.GetObservers()->OnAdd<TestTable>([&](EntityManager& manager, const std::vector<EntityId>& ids) {
+		log.push_back("table");
+		tableBatches.push_back(ids);
+		// the second entity gets its component from inside the first batch
+		if (tableBatches.size() == 1) manager.GetEntity(second->GetId())->add<TestTable>(2);
+		for (auto id : ids) manager.GetEntity(id)->add<TestSparse>(1);
+	});
+	world.GetObservers()->OnAdd<TestSparse>([&](EntityManager&, const std::vector<EntityId>& ids) {
+		log.push_back("sparse");
+		ECS_CHECK_EQ(ids.size(), 1u);
+	});
+
+	first->add<TestTable>(1);
+	world.Update();
+
+	// each round hands out what the round before raised, never adding to a batch being dispatched
+	ECS_CHECK(log == (std::vector<std::string>{ "table", "table", "sparse", "sparse" }));
+	ECS_REQUIRE(tableBatches.size() == 2);
+	ECS_CHECK(tableBatches[0] == std::vector<EntityId>{ first->GetId() });
+	ECS_CHECK(tableBatches[1] == std::vector<EntityId>{ second->GetId() });
+	ECS_CHECK(second->has<TestSparse>());
+	ECS_CHECK(!world.GetObservers()->Pending());
+}
+
+ECS_TEST(Observers, ClearedTransientsRaiseRemove)
+{
+	EntityManager world(0);
+	std::vector<Entity*> created;
+	for (int i = 0; i < 10; i++) created.push_back(world.CreateEntity());
+	world.Update();
+
+	std::vector<EntityId> removed;
+	world.GetObservers()->OnRemove<TestTransient>([&](EntityManager&, const std::vector<EntityId>& ids) { removed.insert(removed.end(), ids.begin(), ids.end()); });
+
+	std::vector<EntityId> expected;
+	for (std::size_t i = 0; i < created.size(); i += 3) {
+		created[i]->add<TestTransient>(int(i));
+		expected.push_back(created[i]->GetId());
+	}
+	// one removed by hand before the end of the frame is only reported once
+	created[0]->remove<TestTransient>();
+
+	// cleared after this frame's dispatch, so reported with the next one
+	world.Update();
+	for (auto e : created) ECS_CHECK(!e->has<TestTransient>());
+	ECS_CHECK(removed == std::vector<EntityId>{ created[0]->GetId() });
+
+	world.Update();
+	ECS_CHECK(Sorted(removed) == Sorted(expected));
+}
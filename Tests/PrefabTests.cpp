@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <vector>
+
+#include "EntityManager.h"
+#include "Test.h"
+#include "TestComponents.h"
+
+namespace {
+	void CheckInstance(EntityManager& world, EntityId id, const Vec3& position, bool table, bool sparse)
+	{
+		Entity* e = world.GetEntity(id);
+		ECS_REQUIRE(e != nullptr);
+		ECS_CHECK(e->transform == &e->get<Transform>());
+		ECS_CHECK(e->transform->position == position);
+		ECS_CHECK(e->transform->entity == e);
+		ECS_CHECK_EQ(e->has<TestTable>(), table);
+		ECS_CHECK_EQ(e->has<TestSparse>(), sparse);
+		if (table && e->has<TestTable>()) {
+			ECS_CHECK_EQ(e->get<TestTable>().value, 2.5);
+			ECS_CHECK(e->get<TestTable>().entity == e);
+		}
+		if (sparse && e->has<TestSparse>()) {
+			ECS_CHECK_EQ(e->get<TestSparse>().value, 9);
+			ECS_CHECK(e->get<TestSparse>().entity == e);
+		}
+	}
+
+	// Instantiates enough to span several chunks, into a world that already has entities and holes
+	void InstantiateMatchesPrefab(bool table, bool sparse)
+	{
+		EntityManager world(0);
+		std::vector<EntityId> existing;
+		for (int i = 0; i < 40; i++) existing.push_back(world.CreateEntity(Vec3(-1, 0, 0))->GetId());
+		world.Update();
+		for (int i = 0; i < 40; i += 3) world.DestroyEntity(existing[i]);
+		world.Update();
+
+		std::size_t addedTable = 0;
+		std::size_t addedSparse = 0;
+		world.GetObservers()->OnAdd<TestTable>([&](EntityManager&, const std::vector<EntityId>& ids) { addedTable += ids.size(); });
+		world.GetObservers()->OnAdd<TestSparse>([&](EntityManager&, const std::vector<EntityId>& ids) { addedSparse += ids.size(); });
+
+		Prefab prefab(Vec3(3, 4, 5), Quat::identity, Vec3::one);
+		if (table) prefab.add<TestTable>(2.5);
+		if (sparse) prefab.add<TestSparse>(9);
+
+		const std::size_t count = 2500;
+		std::vector<EntityId> ids = world.Instantiate(prefab, count);
+		ECS_REQUIRE(ids.size() == count);
+		world.Update();
+
+		// fresh ids, no two alike, freed slots reused before new ones
+		std::vector<EntityId> sorted = ids;
+		std::sort(sorted.begin(), sorted.end(), [](EntityId a, EntityId b) { return a.index < b.index; });
+		for (std::size_t i = 1; i < sorted.size(); i++) ECS_CHECK(sorted[i - 1].index != sorted[i].index);
+		ECS_CHECK(sorted.front().index == existing[0].index);
+
+		for (auto id : ids) CheckInstance(world, id, Vec3(3, 4, 5), table, sparse);
+		ECS_CHECK_EQ(addedTable, table ? count : 0);
+		ECS_CHECK_EQ(addedSparse, sparse ? count : 0);
+		if (sparse) ECS_CHECK_EQ(world.GetStorage()->GetPool<TestSparse>().Size(), count);
+
+		std::size_t viewed = 0;
+		world.view<const Transform>().each([&](const Transform& t) { if (t.position == Vec3(3, 4, 5)) viewed++; });
+		ECS_CHECK_EQ(viewed, count);
+
+		// instances are copies, changing one or the prefab leaves the rest alone
+		if (table) {
+			world.GetEntity(ids[0])->get<TestTable>().value = -1;
+			prefab.get<TestTable>().value = -2;
+			CheckInstance(world, ids[1], Vec3(3, 4, 5), table, sparse);
+		}
+
+		// and they are ordinary entities from then on
+		for (std::size_t i = 0; i < count; i += 2) world.DestroyEntity(ids[i]);
+		world.Update();
+		for (std::size_t i = 0; i < count; i++) ECS_CHECK_EQ(world.IsValid(ids[i]), i % 2 == 1);
+		if (sparse) ECS_CHECK_EQ(world.GetStorage()->GetPool<TestSparse>().Size(), count / 2);
+	}
+}
+
+ECS_TEST(Prefab, InstantiateIntoTable)
+{
+	InstantiateMatchesPrefab(true, false);
+}
+
+ECS_TEST(Prefab, InstantiateIntoSparseSet)
+{
+	InstantiateMatchesPrefab(false, true);
+}
+
+ECS_TEST(Prefab, InstantiateIntoBoth)
+{
+	InstantiateMatchesPrefab(true, true);
+}
+
+ECS_TEST(Prefab, InstantiateTransformOnly)
+{
+	InstantiateMatchesPrefab(false, false);
+}
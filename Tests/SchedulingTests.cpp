@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "EntityManager.h"
+#include "Test.h"
+#include "TestComponents.h"
+
+namespace {
+	// Appends its name to a shared log, optionally waiting until another system has started
+	class LoggingSystem : public System {
+	public:
+		LoggingSystem(std::vector<const char*>& log, std::mutex& mutex, const char* name) : log(log), mutex(mutex), started(nullptr), partner(nullptr), sawPartner(false) {
+			SetName(name);
+		}
+
+		void Update(EntityManager&) override {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				log.push_back(GetName());
+			}
+			if (started) started->store(true);
+			if (!partner) return;
+
+			// serialised systems would time out here, overlapping ones see each other start
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+			while (!partner->load() && std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+			sawPartner = partner->load();
+		}
+
+		template<typename... Ts>
+		void Access() { Accesses<Ts...>(); }
+
+		std::vector<const char*>& log;
+		std::mutex& mutex;
+		std::atomic<bool>* started;
+		std::atomic<bool>* partner;
+		bool sawPartner;
+	};
+
+	std::size_t Position(const std::vector<const char*>& log, const char* name)
+	{
+		return std::find(log.begin(), log.end(), name) - log.begin();
+	}
+}
+
+ECS_TEST(Scheduling, ConflictingSystemsRunInOrder)
+{
+	EntityManager world(2);
+	std::vector<const char*> log;
+	std::mutex mutex;
+
+	// a writer, a reader of what it writes, a second writer of the same, and one unrelated system
+	LoggingSystem& writer = world.AddSystem<LoggingSystem>(log, mutex, "writer");
+	writer.Access<TestTable>();
+	LoggingSystem& reader = world.AddSystem<LoggingSystem>(log, mutex, "reader");
+	reader.Access<const TestTable, const Transform>();
+	LoggingSystem& rewriter = world.AddSystem<LoggingSystem>(log, mutex, "rewriter");
+	rewriter.Access<TestTable>();
+	LoggingSystem& other = world.AddSystem<LoggingSystem>(log, mutex, "other");
+	other.Access<TestSparse>();
+
+	for (int frame = 0; frame < 20; frame++) {
+		log.clear();
+		world.Update();
+		ECS_REQUIRE(log.size() == 4);
+		ECS_CHECK(Position(log, "writer") < Position(log, "reader"));
+		ECS_CHECK(Position(log, "reader") < Position(log, "rewriter"));
+	}
+}
+
+ECS_TEST(Scheduling, IndependentSystemsOverlap)
+{
+	EntityManager world(1);
+	std::vector<const char*> log;
+	std::mutex mutex;
+	std::atomic<bool> firstStarted(false);
+	std::atomic<bool> secondStarted(false);
+
+	// each waits for the other, which only finishes if the two run at the same time
+	LoggingSystem& first = world.AddSystem<LoggingSystem>(log, mutex, "first");
+	first.Access<TestTable>();
+	first.started = &firstStarted;
+	first.partner = &secondStarted;
+	LoggingSystem& second = world.AddSystem<LoggingSystem>(log, mutex, "second");
+	second.Access<TestSparse, const Transform>();
+	second.started = &secondStarted;
+	second.partner = &firstStarted;
+
+	world.Update();
+	ECS_CHECK(first.sawPartner);
+	ECS_CHECK(second.sawPartner);
+}
+
+ECS_TEST(Scheduling, WaitInsideAJobDoesNotDeadlock)
+{
+	// more nested waits than threads, with and without workers
+	for (unsigned int workers : { 0u, 1u, 3u }) {
+		JobSystem jobs(workers);
+		std::atomic<std::size_t> inner(0);
+
+		JobHandle outer = jobs.CreateHandle();
+		for (int i = 0; i < 16; i++) {
+			jobs.Schedule(outer, [&jobs, &inner] {
+				JobHandle nested = jobs.ParallelFor(100, 7, [&inner](std::size_t begin, std::size_t end) { inner += end - begin; });
+				jobs.Wait(nested);
+			});
+		}
+		jobs.Wait(outer);
+
+		ECS_CHECK(outer.IsDone());
+		ECS_CHECK_EQ(inner.load(), 1600u);
+	}
+}
+
+ECS_TEST(Scheduling, ParallelEachVisitsEveryEntityOnce)
+{
+	EntityManager world(3);
+	std::vector<Entity*> created;
+	// two archetypes, several chunks each, so ranges cut through and across chunks
+	for (int i = 0; i < 5000; i++) {
+		created.push_back(world.CreateEntity(Vec3(i, 0, 0)));
+		created.back()->add<TestTable>(0);
+		if (i % 3 == 0) created.back()->add<TestSparse>(0);
+	}
+	world.Update();
+
+	for (std::size_t grain : { std::size_t(1), std::size_t(37), std::size_t(1024), std::size_t(100000) }) {
+		JobHandle handle = world.view<TestTable>().parallel_each([](TestTable& t) { t.value += 1; }, grain);
+		world.GetJobs()->Wait(handle);
+		handle = world.view<TestSparse>().parallel_each([](TestSparse& s) { s.value += 1; }, grain);
+		world.GetJobs()->Wait(handle);
+	}
+
+	for (std::size_t i = 0; i < created.size(); i++) {
+		ECS_CHECK_EQ(created[i]->get<TestTable>().value, 4.0);
+		if (i % 3 == 0) ECS_CHECK_EQ(created[i]->get<TestSparse>().value, 4);
+	}
+}
+
+ECS_TEST(Scheduling, FlushAppliesCreatesThenChangesThenDestroys)
+{
+	EntityManager world(0);
+	Entity* doomed = world.CreateEntity();
+	Entity* gone = world.CreateEntity();
+	world.Update();
+	const EntityId doomedId = doomed->GetId();
+	const EntityId goneId = gone->GetId();
+	world.DestroyEntity(goneId);
+	world.Update();
+
+	std::vector<EntityId> added;
+	world.GetObservers()->OnAdd<TestTable>([&](EntityManager&, const std::vector<EntityId>& ids) { added.insert(added.end(), ids.begin(), ids.end()); });
+
+	// recorded in the opposite order, and from two threads' buffers
+	CommandBuffer& commands = world.GetCommandBuffer();
+	commands.Destroy(doomedId);
+	commands.Add<TestTable>(doomedId, 1.0);
+	const EntityId createdId = commands.Create(Vec3(1, 2, 3), Quat::identity, Vec3::one);
+	std::thread recorder([&] {
+		CommandBuffer& own = world.GetCommandBuffer();
+		own.Add<TestTable>(createdId, 2.0);
+		own.Add<TestNamed>(createdId, "created");
+		// a dead id, its payload is discarded rather than applied
+		own.Add<TestNamed>(goneId, "never applied");
+		own.Add<TestSparse>(goneId, 3);
+	});
+	recorder.join();
+	ECS_CHECK(world.GetEntity(createdId) == nullptr);
+
+	world.Update();
+
+	// the change reached the entity before it was destroyed
+	ECS_CHECK(!world.IsValid(doomedId));
+	ECS_CHECK(std::find(added.begin(), added.end(), doomedId) != added.end());
+
+	// created before the other thread's changes were applied
+	Entity* created = world.GetEntity(createdId);
+	ECS_REQUIRE(created != nullptr);
+	ECS_CHECK(created->transform->position == Vec3(1, 2, 3));
+	ECS_CHECK_EQ(created->get<TestTable>().value, 2.0);
+	ECS_CHECK(created->get<TestNamed>().name == "created");
+
+	ECS_CHECK(!world.IsValid(goneId));
+	ECS_CHECK(world.GetStorage()->GetPool(getCompTypeID<TestSparse>()) == nullptr || world.GetStorage()->GetPool(getCompTypeID<TestSparse>())->Size() == 0);
+	ECS_CHECK(world.GetCommandBuffer().Empty());
+}
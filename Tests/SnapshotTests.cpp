@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "EntityManager.h"
+#include "Test.h"
+#include "TestComponents.h"
+#include "WorldLoader.h"
+
+namespace {
+	const std::string path = "ecs_tests_snapshot.world";
+
+	struct Saved {
+		EntityId id;
+		Vec3 position;
+		bool hasTable;
+		double table;
+		bool hasSparse;
+		int sparse;
+	};
+
+	// A world with every mix of table and sparse components and a few holes from destroyed
+	// entities, saved to path. Returns what each surviving entity held.
+	std::vector<Saved> SaveWorld()
+	{
+		EntityManager world(0);
+		std::vector<Entity*> created;
+		for (int i = 0; i < 300; i++) {
+			Entity* e = world.CreateEntity(Vec3(i, i * 2.0, -i), Quat::identity, Vec3::one);
+			if (i % 2 == 0) e->add<TestTable>(i * 0.5);
+			if (i % 3 == 0) e->add<TestSparse>(i);
+			created.push_back(e);
+		}
+		world.Update();
+
+		std::vector<EntityId> destroyed;
+		for (int i = 0; i < 300; i += 7) destroyed.push_back(created[i]->GetId());
+		for (auto id : destroyed) world.DestroyEntity(id);
+		world.Update();
+
+		std::vector<Saved> saved;
+		world.view<const Transform>().each([&](Entity& e, const Transform& t) {
+			Saved s{ e.GetId(), t.position, e.has<TestTable>(), 0, e.has<TestSparse>(), 0 };
+			if (s.hasTable) s.table = e.get<TestTable>().value;
+			if (s.hasSparse) s.sparse = e.get<TestSparse>().value;
+			saved.push_back(s);
+		});
+
+		world.SaveSnapshot(path);
+		return saved;
+	}
+
+	void CheckEntity(EntityManager& world, EntityId id, const Saved& s)
+	{
+		Entity* e = world.GetEntity(id);
+		ECS_REQUIRE(e != nullptr);
+		ECS_CHECK(e->transform->position == s.position);
+		ECS_CHECK_EQ(e->has<TestTable>(), s.hasTable);
+		ECS_CHECK_EQ(e->has<TestSparse>(), s.hasSparse);
+		if (s.hasTable && e->has<TestTable>()) {
+			ECS_CHECK_EQ(e->get<TestTable>().value, s.table);
+			ECS_CHECK(e->get<TestTable>().entity == e);
+		}
+		if (s.hasSparse && e->has<TestSparse>()) {
+			ECS_CHECK_EQ(e->get<TestSparse>().value, s.sparse);
+			ECS_CHECK(e->get<TestSparse>().entity == e);
+		}
+	}
+}
+
+ECS_TEST(Snapshot, RoundTripKeepsIdsAndComponents)
+{
+	const std::vector<Saved> saved = SaveWorld();
+
+	// a fresh world, Transform needs no registering
+	EntityManager world(0);
+	world.RegisterComponents<TestTable, TestSparse>();
+	world.LoadSnapshot(path);
+	std::remove(path.c_str());
+
+	for (auto& s : saved) CheckEntity(world, s.id, s);
+
+	std::size_t count = 0;
+	world.view<const Transform>().each([&](const Transform&) { count++; });
+	ECS_CHECK_EQ(count, saved.size());
+
+	// the world keeps running after a load
+	world.Update();
+	for (auto& s : saved) CheckEntity(world, s.id, s);
+}
+
+ECS_TEST(Snapshot, StreamedLoadRemapsIds)
+{
+	const std::vector<Saved> saved = SaveWorld();
+
+	EntityManager world(0);
+	world.RegisterComponents<TestTable, TestSparse>();
+	std::vector<EntityId> existing;
+	for (int i = 0; i < 50; i++) {
+		Entity* e = world.CreateEntity(Vec3(-1000.0 - i, 0, 0));
+		e->add<TestTable>(-i);
+		existing.push_back(e->GetId());
+	}
+	world.Update();
+
+	{
+		// small batches so rows and sparse components are split across many steps
+		WorldLoader loader(world, path, 7);
+		while (!loader.Step(std::chrono::microseconds(50))) world.Update();
+		world.Update();
+		ECS_CHECK(loader.Done());
+		ECS_CHECK_EQ(loader.Loaded(), loader.Total());
+
+		std::vector<EntityId> remapped;
+		for (auto& s : saved) {
+			EntityId id = loader.Remap(s.id);
+			ECS_CHECK(!id.IsNull());
+			CheckEntity(world, id, s);
+			remapped.push_back(id);
+		}
+
+		// no two saved entities landed on the same id, and none on an existing one
+		std::vector<EntityId> all = remapped;
+		all.insert(all.end(), existing.begin(), existing.end());
+		std::sort(all.begin(), all.end(), [](EntityId a, EntityId b) { return a.index < b.index; });
+		for (std::size_t i = 1; i < all.size(); i++) ECS_CHECK(all[i - 1].index != all[i].index);
+	}
+	std::remove(path.c_str());
+
+	for (int i = 0; i < 50; i++) {
+		Entity* e = world.GetEntity(existing[i]);
+		ECS_REQUIRE(e != nullptr);
+		ECS_CHECK(e->transform->position == Vec3(-1000.0 - i, 0, 0));
+		ECS_CHECK_EQ(e->get<TestTable>().value, -i);
+	}
+
+	std::size_t count = 0;
+	world.view<const Transform>().each([&](const Transform&) { count++; });
+	ECS_CHECK_EQ(count, saved.size() + existing.size());
+}
+
+ECS_TEST(Snapshot, SaveRefusesTypesThatDidNotOptIn)
+{
+	std::remove(path.c_str());
+
+	EntityManager world(0);
+	Entity* e = world.CreateEntity();
+	e->add<TestTable>(1);
+	e->add<TestNamed>("heap backed");
+	world.Update();
+
+	// a std::string copied from another process's bytes would point at nothing
+	bool refused = false;
+	try {
+		world.SaveSnapshot(path);
+	}
+	catch (const std::logic_error&) {
+		refused = true;
+	}
+	ECS_CHECK(refused);
+	ECS_CHECK(!std::ifstream(path).good());
+
+	// without the component the same world saves
+	e->remove<TestNamed>();
+	world.Update();
+	world.SaveSnapshot(path);
+	ECS_CHECK(std::ifstream(path).good());
+	std::remove(path.c_str());
+}
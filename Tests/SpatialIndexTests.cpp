@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "EntityManager.h"
+#include "Test.h"
+
+namespace {
+	struct Point {
+		EntityId id;
+		Vec3 position;
+	};
+
+	std::vector<Point> AllPoints(EntityManager& world)
+	{
+		std::vector<Point> points;
+		world.view<const Transform>().each([&](Entity& e, const Transform& t) { points.push_back(Point{ e.GetId(), t.position }); });
+		return points;
+	}
+
+	bool ByIndex(EntityId a, EntityId b) { return a.index < b.index; }
+
+	std::vector<EntityId> Sorted(std::vector<EntityId> ids)
+	{
+		std::sort(ids.begin(), ids.end(), ByIndex);
+		return ids;
+	}
+
+	// Every query kind against a scan over all points, on random queries of mixed sizes
+	void CheckAgainstBruteForce(EntityManager& world, std::mt19937& rng)
+	{
+		const SpatialIndex& index = *world.GetSpatialIndex();
+		const std::vector<Point> points = AllPoints(world);
+		ECS_CHECK_EQ(index.Size(), points.size());
+
+		std::uniform_real_distribution<double> coord(-120, 120);
+		std::uniform_real_distribution<double> size(0.5, 60);
+		for (int q = 0; q < 60; q++) {
+			const Vec3 center(coord(rng), coord(rng), coord(rng));
+			const double radius = size(rng);
+
+			std::vector<EntityId> expected;
+			for (auto& p : points)
+				if (p.position.SqrDistance(center) <= radius * radius) expected.push_back(p.id);
+			ECS_CHECK(Sorted(index.QueryRadius(center, radius)) == Sorted(expected));
+
+			const Vec3 extent(size(rng), size(rng), size(rng));
+			const Vec3 min = center - extent;
+			const Vec3 max = center + extent;
+			expected.clear();
+			for (auto& p : points) {
+				const Vec3& v = p.position;
+				if (v.x >= min.x && v.x <= max.x && v.y >= min.y && v.y <= max.y && v.z >= min.z && v.z <= max.z) expected.push_back(p.id);
+			}
+			ECS_CHECK(Sorted(index.QueryBox(min, max)) == Sorted(expected));
+
+			// ties could be broken either way, so compare distances rather than ids
+			const std::size_t k = 1 + q % 12;
+			std::vector<double> expectedDistances;
+			for (auto& p : points) expectedDistances.push_back(p.position.SqrDistance(center));
+			std::sort(expectedDistances.begin(), expectedDistances.end());
+			expectedDistances.resize(std::min(k, expectedDistances.size()));
+
+			std::vector<double> distances;
+			for (auto id : index.QueryNearest(center, k)) distances.push_back(world.GetEntity(id)->transform->position.SqrDistance(center));
+			ECS_CHECK(distances == expectedDistances);
+		}
+	}
+
+	void QueriesMatchBruteForce(SpatialIndexType type)
+	{
+		std::mt19937 rng(7);
+		std::uniform_real_distribution<double> spread(-100, 100);
+		std::normal_distribution<double> cluster(0, 3);
+
+		EntityManager world(0);
+		world.CreateSpatialIndex(type, 8.0);
+
+		// spread out plus one dense clump, the cases the two backends are each good at
+		std::vector<EntityId> ids;
+		for (int i = 0; i < 1500; i++) {
+			Vec3 p = i % 3 == 0 ? Vec3(40 + cluster(rng), cluster(rng), -30 + cluster(rng)) : Vec3(spread(rng), spread(rng), spread(rng));
+			ids.push_back(world.CreateEntity(p)->GetId());
+		}
+		world.Update();
+		CheckAgainstBruteForce(world, rng);
+
+		// moves, including some far outside the starting bounds, and destroys
+		for (std::size_t i = 0; i < ids.size(); i += 2) {
+			Entity* e = world.GetEntity(ids[i]);
+			e->transform->position = i % 10 == 0 ? Vec3(spread(rng) * 3, spread(rng), spread(rng)) : e->transform->position + Vec3(cluster(rng), cluster(rng), cluster(rng));
+			e->markChanged<Transform>();
+		}
+		for (std::size_t i = 1; i < ids.size(); i += 5) world.DestroyEntity(ids[i]);
+		world.Update();
+		CheckAgainstBruteForce(world, rng);
+	}
+
+	void ChildrenIndexedInWorldSpace(SpatialIndexType type)
+	{
+		EntityManager world(0);
+		world.CreateSpatialIndex(type, 4.0);
+
+		Entity* parent = world.CreateEntity(Vec3(50, 0, 0));
+		Entity* child = world.CreateEntity(Vec3(1, 0, 0));
+		world.Update();
+		world.GetHierarchy()->SetParent(child->GetId(), parent->GetId());
+		world.Update();
+
+		const SpatialIndex& index = *world.GetSpatialIndex();
+		ECS_CHECK(index.QueryRadius(Vec3(51, 0, 0), 0.1) == std::vector<EntityId>{ child->GetId() });
+
+		// the child's own Transform doesn't change when its parent moves
+		parent->transform->position = Vec3(-50, 0, 0);
+		parent->markChanged<Transform>();
+		world.Update();
+		ECS_CHECK(index.QueryRadius(Vec3(-49, 0, 0), 0.1) == std::vector<EntityId>{ child->GetId() });
+		ECS_CHECK(index.QueryRadius(Vec3(51, 0, 0), 0.1).empty());
+
+		// unlinked it is back at its local position
+		world.GetHierarchy()->SetParent(child->GetId(), EntityId::null);
+		world.Update();
+		ECS_CHECK(index.QueryRadius(Vec3(1, 0, 0), 0.1) == std::vector<EntityId>{ child->GetId() });
+	}
+}
+
+ECS_TEST(SpatialIndex, LooseOctreeStaysBoundedAsAClusterMoves)
+{
+	std::mt19937 rng(13);
+	std::normal_distribution<double> cluster(0, 3);
+
+	EntityManager world(0);
+	world.CreateSpatialIndex(SpatialIndexType::LooseOctree, 8.0);
+	std::vector<Entity*> created;
+	for (int i = 0; i < 400; i++) created.push_back(world.CreateEntity(Vec3(cluster(rng), cluster(rng), cluster(rng))));
+	world.Update();
+
+	const LooseOctreeIndex& index = static_cast<const LooseOctreeIndex&>(*world.GetSpatialIndex());
+	auto drift = [&](const Vec3& step, int frames) {
+		for (int frame = 0; frame < frames; frame++) {
+			for (auto e : created) {
+				e->transform->position = e->transform->position + step;
+				e->markChanged<Transform>();
+			}
+			world.Update();
+		}
+	};
+
+	// the whole clump crosses 1200 units, splitting nodes ahead of it and leaving empty ones behind.
+	// Only the root growing to cover the trip adds nodes for good, a few per doubling.
+	const std::size_t settled = index.NodeCount();
+	drift(Vec3(4, 0, 0), 300);
+	const std::size_t away = index.NodeCount();
+	ECS_CHECK(away <= settled + 160);
+	CheckAgainstBruteForce(world, rng);
+
+	// on the way back the root is already big enough, the nodes folded behind it are reused
+	drift(Vec3(-4, 0, 0), 300);
+	ECS_CHECK(index.NodeCount() <= away);
+	CheckAgainstBruteForce(world, rng);
+}
+
+ECS_TEST(SpatialIndex, HashGridMatchesBruteForce)
+{
+	QueriesMatchBruteForce(SpatialIndexType::HashGrid);
+}
+
+ECS_TEST(SpatialIndex, LooseOctreeMatchesBruteForce)
+{
+	QueriesMatchBruteForce(SpatialIndexType::LooseOctree);
+}
+
+ECS_TEST(SpatialIndex, HashGridIndexesChildrenInWorldSpace)
+{
+	ChildrenIndexedInWorldSpace(SpatialIndexType::HashGrid);
+}
+
+ECS_TEST(SpatialIndex, LooseOctreeIndexesChildrenInWorldSpace)
+{
+	ChildrenIndexedInWorldSpace(SpatialIndexType::LooseOctree);
+}
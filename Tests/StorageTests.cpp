@@ -0,0 +1,171 @@
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "EntityManager.h"
+#include "PoolAllocator.h"
+#include "SparseSet.h"
+#include "Test.h"
+#include "TestComponents.h"
+
+namespace {
+	bool Aligned(const void* p, std::size_t align)
+	{
+		return reinterpret_cast<std::uintptr_t>(p) % align == 0;
+	}
+
+	// Everything the set holds against a plain map of what it should hold
+	void CheckPool(SparseSet<TestSparse>& pool, const std::map<std::uint32_t, std::pair<int, Tick>>& expected, std::uint32_t range)
+	{
+		ECS_REQUIRE(pool.Size() == expected.size());
+
+		const TestSparse* packed = static_cast<const TestSparse*>(pool.PackedData());
+		for (std::size_t slot = 0; slot < pool.Size(); slot++) {
+			const std::uint32_t index = pool.Indices()[slot];
+			auto found = expected.find(index);
+			ECS_REQUIRE(found != expected.end());
+			ECS_CHECK_EQ(packed[slot].value, found->second.first);
+			ECS_CHECK(pool.TryGet(index) == &packed[slot]);
+			ECS_CHECK_EQ(pool.AddedTick(index), found->second.second);
+		}
+		for (std::uint32_t index = 0; index < range; index++) ECS_CHECK_EQ(pool.Contains(index), expected.count(index) == 1);
+	}
+}
+
+ECS_TEST(Storage, SparseSetSwapAndPopAcrossPages)
+{
+	// indices on both sides of several 4096 wide pages, with a page never touched in between
+	std::vector<std::uint32_t> indices;
+	for (std::uint32_t page : { 0u, 1u, 3u })
+		for (std::uint32_t offset : { 0u, 1u, 2047u, 4094u, 4095u })
+			indices.push_back(page * 4096 + offset);
+	const std::uint32_t range = 4 * 4096;
+
+	SparseSet<TestSparse> pool;
+	std::map<std::uint32_t, std::pair<int, Tick>> expected;
+	std::mt19937 rng(17);
+	for (Tick tick = 1; tick < 400; tick++) {
+		const std::uint32_t index = indices[rng() % indices.size()];
+		if (rng() % 3 == 0) {
+			pool.Remove(index);
+			expected.erase(index);
+		}
+		else {
+			pool.Emplace(index, TestSparse(int(tick)), tick);
+			// replacing keeps the added tick
+			if (expected.count(index)) expected[index].first = int(tick);
+			else expected[index] = { int(tick), tick };
+		}
+		CheckPool(pool, expected, range);
+	}
+
+	// emptied from the front, so every removal moves the last element
+	while (!expected.empty()) {
+		const std::uint32_t index = pool.Indices().front();
+		pool.Remove(index);
+		expected.erase(index);
+		CheckPool(pool, expected, range);
+	}
+	pool.Remove(indices[0]);
+	ECS_CHECK(pool.Empty());
+}
+
+ECS_TEST(Storage, StaleIdsStayInvalidAfterReuse)
+{
+	EntityManager world(0);
+	Entity* first = world.CreateEntity(Vec3(1, 0, 0));
+	const EntityId original = first->GetId();
+	world.Update();
+
+	std::vector<EntityId> stale{ original };
+	EntityId current = original;
+	for (int i = 0; i < 5; i++) {
+		world.DestroyEntity(current);
+		world.Update();
+
+		// the freed slot is handed out again with a newer generation
+		Entity* reused = world.CreateEntity(Vec3(double(i), 0, 0));
+		current = reused->GetId();
+		ECS_CHECK_EQ(current.index, original.index);
+		ECS_CHECK(current.generation > stale.back().generation);
+		world.Update();
+
+		for (auto id : stale) {
+			ECS_CHECK(!world.IsValid(id));
+			ECS_CHECK(world.GetEntity(id) == nullptr);
+			// destroying through an old handle leaves the new entity alone
+			world.DestroyEntity(id);
+		}
+		world.Update();
+		ECS_CHECK(world.IsValid(current));
+		ECS_CHECK(world.GetEntity(current) == reused);
+		stale.push_back(current);
+	}
+}
+
+ECS_TEST(Storage, PoolAllocatorReusesAlignedBlocks)
+{
+	// blocks smaller than their alignment, spread over several slabs
+	PoolAllocator pool(24, 64, 8);
+	std::vector<void*> blocks;
+	for (int i = 0; i < 30; i++) {
+		blocks.push_back(pool.Allocate());
+		ECS_CHECK(Aligned(blocks.back(), 64));
+		std::memset(blocks.back(), i, 24);
+	}
+
+	// no two blocks share memory
+	std::set<std::uintptr_t> starts;
+	for (auto block : blocks) starts.insert(reinterpret_cast<std::uintptr_t>(block));
+	ECS_REQUIRE(starts.size() == blocks.size());
+	for (auto it = std::next(starts.begin()); it != starts.end(); ++it) ECS_CHECK(*it - *std::prev(it) >= 24);
+	for (int i = 0; i < 30; i++) ECS_CHECK_EQ(static_cast<unsigned char*>(blocks[i])[23], static_cast<unsigned char>(i));
+
+	// freed blocks come back before any new memory, last freed first
+	pool.Free(blocks[3]);
+	pool.Free(blocks[17]);
+	pool.Free(blocks[29]);
+	ECS_CHECK(pool.Allocate() == blocks[29]);
+	ECS_CHECK(pool.Allocate() == blocks[17]);
+	ECS_CHECK(pool.Allocate() == blocks[3]);
+
+	void* fresh = pool.Allocate();
+	ECS_CHECK(Aligned(fresh, 64));
+	ECS_CHECK(starts.count(reinterpret_cast<std::uintptr_t>(fresh)) == 0);
+}
+
+ECS_TEST(Storage, FrameArenaResetMergesBlocks)
+{
+	FrameArena arena(256);
+	const std::size_t sizes[] = { 1, 40, 100, 3, 200, 64, 700, 8, 129 };
+	const std::size_t aligns[] = { 1, 8, 16, 2, 64, 32, 8, 128, 4 };
+
+	for (int frame = 0; frame < 3; frame++) {
+		std::vector<unsigned char*> allocations;
+		std::size_t total = 0;
+		for (std::size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+			allocations.push_back(static_cast<unsigned char*>(arena.Allocate(sizes[i], aligns[i])));
+			ECS_CHECK(Aligned(allocations.back(), aligns[i]));
+			std::memset(allocations.back(), int(i + 1), sizes[i]);
+			total += sizes[i];
+		}
+		ECS_CHECK_EQ(arena.Used(), total);
+
+		// nothing overwrote anything else
+		for (std::size_t i = 0; i < allocations.size(); i++) {
+			ECS_CHECK_EQ(allocations[i][0], static_cast<unsigned char>(i + 1));
+			ECS_CHECK_EQ(allocations[i][sizes[i] - 1], static_cast<unsigned char>(i + 1));
+		}
+
+		// after the first frame the merged block holds all of it, so it is one bump after another
+		if (frame > 0)
+			for (std::size_t i = 1; i < allocations.size(); i++) ECS_CHECK(allocations[i] >= allocations[i - 1] + sizes[i - 1]);
+
+		arena.Reset();
+		ECS_CHECK_EQ(arena.Used(), 0u);
+	}
+}
@@ -0,0 +1,46 @@
+#include "Test.h"
+
+#include <exception>
+#include <iostream>
+
+TestRegistry& TestRegistry::Get()
+{
+	static TestRegistry registry;
+	return registry;
+}
+
+int TestRegistry::Run(const std::string& suite)
+{
+	int failed = 0;
+	int ran = 0;
+
+	for (auto& test : tests) {
+		if (!suite.empty() && suite != test.suite) continue;
+
+		failures = 0;
+		try {
+			test.body();
+		}
+		catch (const std::exception& e) {
+			Fail(test.suite, 0, std::string("threw ") + e.what());
+		}
+
+		std::cout << (failures ? "FAIL " : "ok   ") << test.suite << '.' << test.name << std::endl;
+		if (failures) failed++;
+		ran++;
+	}
+
+	if (ran == 0) {
+		std::cout << "no tests in suite " << suite << std::endl;
+		return -1;
+	}
+
+	std::cout << ran - failed << " of " << ran << " passed" << std::endl;
+	return failed;
+}
+
+void TestRegistry::Fail(const char* file, int line, const std::string& message)
+{
+	failures++;
+	std::cout << "  " << file << ':' << line << ": " << message << std::endl;
+}
@@ -0,0 +1,71 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Behaviour tests, each one a function registered under a suite by ECS_TEST, e.g.
+//   ECS_TEST(Hierarchy, ChildFollowsParent) { ... ECS_CHECK(a == b); }
+// ECS_CHECK records a failure and carries on, ECS_REQUIRE ends the test. An exception escaping
+// a test fails it too.
+struct TestCase {
+	const char* suite;
+	const char* name;
+	void (*body)();
+};
+
+class TestRegistry {
+public:
+	static TestRegistry& Get();
+
+	void Add(const TestCase& test) { tests.push_back(test); }
+
+	// Runs every test of suite, or every test when suite is empty, and prints a line per test.
+	// Returns the number of tests that failed, or -1 if suite matched none.
+	int Run(const std::string& suite);
+
+	void Fail(const char* file, int line, const std::string& message);
+
+private:
+	TestRegistry() : failures(0) {}
+	TestRegistry(TestRegistry& other) = delete;
+	void operator=(const TestRegistry&) = delete;
+
+	std::vector<TestCase> tests;
+	// of the test running now
+	std::size_t failures;
+};
+
+struct TestRegistrar {
+	TestRegistrar(const char* suite, const char* name, void (*body)()) { TestRegistry::Get().Add(TestCase{ suite, name, body }); }
+};
+
+// Formats the operands of a failed comparison
+template<typename A, typename B>
+inline std::string DescribeComparison(const char* expression, const A& a, const B& b)
+{
+	std::ostringstream out;
+	out << expression << " with " << a << " and " << b;
+	return out.str();
+}
+
+#define ECS_TEST(suite, name) \
+	static void suite##_##name(); \
+	static TestRegistrar suite##_##name##_registrar(#suite, #name, &suite##_##name); \
+	static void suite##_##name()
+
+#define ECS_CHECK(cond) \
+	do { if (!(cond)) TestRegistry::Get().Fail(__FILE__, __LINE__, #cond); } while (0)
+
+#define ECS_CHECK_EQ(a, b) \
+	do { \
+		const auto& ecsCheckA = (a); \
+		const auto& ecsCheckB = (b); \
+		if (!(ecsCheckA == ecsCheckB)) TestRegistry::Get().Fail(__FILE__, __LINE__, DescribeComparison(#a " == " #b, ecsCheckA, ecsCheckB)); \
+	} while (0)
+
+#define ECS_REQUIRE(cond) \
+	do { if (!(cond)) { TestRegistry::Get().Fail(__FILE__, __LINE__, #cond); return; } } while (0)
+
+#endif
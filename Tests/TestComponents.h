@@ -0,0 +1,60 @@
+#ifndef TEST_COMPONENTS_H
+#define TEST_COMPONENTS_H
+
+#include <string>
+
+#include "Component.h"
+
+// Quiet components for the tests, one per storage policy plus one that can't be snapshotted. Ids stay clear of the demo's and
+// the benchmarks' so all three can share a process if ever needed.
+class TestTable : public Component {
+public:
+	TestTable() : value(0), updates(0) {};
+	TestTable(double value) : value(value), updates(0) {};
+
+	static constexpr bool bitwiseSnapshot = true;
+
+	// counts calls without stamping anything, like a component that only reads
+	void Update() { updates++; }
+
+	double value;
+	int updates;
+};
+
+class TestSparse : public Component {
+public:
+	TestSparse() : value(0) {};
+	TestSparse(int value) : value(value) {};
+
+	static constexpr StoragePolicy storagePolicy = StoragePolicy::SparseSet;
+	static constexpr bool bitwiseSnapshot = true;
+
+	int value;
+};
+
+// cleared at the end of every Update
+class TestTransient : public Component {
+public:
+	TestTransient() : value(0) {};
+	TestTransient(int value) : value(value) {};
+
+	static constexpr StoragePolicy storagePolicy = StoragePolicy::Transient;
+
+	int value;
+};
+
+// holds heap memory, so it never opts in to snapshots
+class TestNamed : public Component {
+public:
+	TestNamed() {};
+	TestNamed(const std::string& name) : name(name) {};
+
+	std::string name;
+};
+
+ECS_REGISTER_COMPONENT(TestTable, 24)
+ECS_REGISTER_COMPONENT(TestSparse, 25)
+ECS_REGISTER_COMPONENT(TestNamed, 26)
+ECS_REGISTER_COMPONENT(TestTransient, 27)
+
+#endif
@@ -0,0 +1,117 @@
+#include <cmath>
+#include <vector>
+
+#include "EntityManager.h"
+#include "Test.h"
+
+namespace {
+	bool Near(const Vec3& a, const Vec3& b)
+	{
+		return a.SqrDistance(b) < 1e-18;
+	}
+
+	// same rotation, either sign
+	bool Near(const Quat& a, const Quat& b)
+	{
+		return std::fabs(std::fabs(Quat::DotProd(a, b)) - 1) < 1e-12;
+	}
+
+	std::size_t Find(const TransformFrame& frame, EntityId id)
+	{
+		for (std::size_t i = 0; i < frame.Size(); i++)
+			if (frame.ids[i] == id) return i;
+		return frame.Size();
+	}
+
+	// Every array lines up with ids and entities not moved since the frame before interpolate to where they are
+	void CheckStill(const TransformFrame& frame, EntityId id, const Vec3& position)
+	{
+		const std::size_t i = Find(frame, id);
+		ECS_REQUIRE(i < frame.Size());
+		ECS_CHECK(frame.positions[i] == position);
+		ECS_CHECK(frame.previousPositions[i] == position);
+		ECS_CHECK(frame.previousRotations[i] == frame.rotations[i]);
+		ECS_CHECK(frame.previousScales[i] == frame.scales[i]);
+	}
+}
+
+ECS_TEST(TransformBuffer, InterpolatesAcrossAddsAndDestroys)
+{
+	EntityManager world(0);
+	TransformBuffer& buffer = world.CreateTransformBuffer();
+	ECS_CHECK_EQ(buffer.Acquire().frame, 0u);
+
+	Entity* moving = world.CreateEntity(Vec3(0, 0, 0));
+	Entity* doomed = world.CreateEntity(Vec3(5, 5, 5));
+	Entity* still = world.CreateEntity(Vec3(-3, 0, 1));
+	const EntityId movingId = moving->GetId();
+	const EntityId doomedId = doomed->GetId();
+	const EntityId stillId = still->GetId();
+	world.Update();
+
+	ECS_CHECK(buffer.HasNewFrame());
+	const TransformFrame& first = buffer.Acquire();
+	ECS_CHECK_EQ(first.frame, 1u);
+	ECS_CHECK_EQ(first.Size(), 3u);
+	CheckStill(first, movingId, Vec3(0, 0, 0));
+	CheckStill(first, doomedId, Vec3(5, 5, 5));
+
+	// one moves and turns, one is destroyed
+	moving->transform->position = Vec3(8, 0, -4);
+	moving->transform->rotation = Quat::FromAngleAxis(90, Vec3::up);
+	moving->transform->scale = Vec3(3, 3, 3);
+	moving->markChanged<Transform>();
+	world.DestroyEntity(doomedId);
+	world.Update();
+
+	const TransformFrame& second = buffer.Acquire();
+	ECS_CHECK_EQ(second.frame, 2u);
+	ECS_CHECK_EQ(second.Size(), 2u);
+	ECS_CHECK(Find(second, doomedId) == second.Size());
+	CheckStill(second, stillId, Vec3(-3, 0, 1));
+
+	std::vector<Vec3> positions, scales;
+	std::vector<Quat> rotations;
+	second.Interpolate(0.25f, positions, rotations, scales);
+	ECS_REQUIRE(positions.size() == second.Size() && rotations.size() == second.Size() && scales.size() == second.Size());
+
+	const std::size_t m = Find(second, movingId);
+	ECS_REQUIRE(m < second.Size());
+	ECS_CHECK(second.previousPositions[m] == Vec3(0, 0, 0));
+	ECS_CHECK(Near(positions[m], Vec3(2, 0, -1)));
+	ECS_CHECK(Near(scales[m], Vec3(1.5, 1.5, 1.5)));
+	ECS_CHECK(Near(rotations[m], Quat::FromAngleAxis(22.5, Vec3::up)));
+
+	const std::size_t s = Find(second, stillId);
+	ECS_CHECK(Near(positions[s], Vec3(-3, 0, 1)));
+	ECS_CHECK(Near(rotations[s], second.rotations[s]));
+
+	// a new entity in the destroyed one's slot starts where it is, not where the old one was
+	Entity* added = world.CreateEntity(Vec3(-7, 2, 0), Quat::FromAngleAxis(45, Vec3::forward));
+	const EntityId addedId = added->GetId();
+	ECS_CHECK_EQ(addedId.index, doomedId.index);
+	moving->transform->position = Vec3(8, 4, -4);
+	moving->markChanged<Transform>();
+	world.Update();
+
+	const TransformFrame& third = buffer.Acquire();
+	ECS_CHECK_EQ(third.frame, 3u);
+	ECS_CHECK_EQ(third.Size(), 3u);
+	CheckStill(third, addedId, Vec3(-7, 2, 0));
+	CheckStill(third, stillId, Vec3(-3, 0, 1));
+
+	third.Interpolate(0.5f, positions, rotations, scales);
+	ECS_REQUIRE(positions.size() == third.Size());
+	const std::size_t a = Find(third, addedId);
+	ECS_CHECK(Near(positions[a], Vec3(-7, 2, 0)));
+	ECS_CHECK(Near(rotations[a], Quat::FromAngleAxis(45, Vec3::forward)));
+
+	const std::size_t m3 = Find(third, movingId);
+	ECS_CHECK(third.previousPositions[m3] == Vec3(8, 0, -4));
+	ECS_CHECK(Near(positions[m3], Vec3(8, 2, -4)));
+	ECS_CHECK(Near(rotations[m3], Quat::FromAngleAxis(90, Vec3::up)));
+	ECS_CHECK(Near(scales[m3], Vec3(3, 3, 3)));
+
+	// nothing new until the next Update
+	ECS_CHECK(!buffer.HasNewFrame());
+}
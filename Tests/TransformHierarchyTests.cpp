@@ -0,0 +1,187 @@
+#include <cmath>
+
+#include "EntityManager.h"
+#include "Test.h"
+#include "TestComponents.h"
+
+namespace {
+	bool Near(const Vec3& a, const Vec3& b)
+	{
+		return a.SqrDistance(b) < 1e-18;
+	}
+}
+
+ECS_TEST(TransformHierarchy, ChildrenFollowTheirAncestors)
+{
+	EntityManager world(0);
+	const Quat turn = Quat::FromAngleAxis(90, Vec3::up);
+	Entity* root = world.CreateEntity(Vec3(10, 0, 0), turn, Vec3(2, 2, 2));
+	Entity* child = world.CreateEntity(Vec3(1, 0, 0));
+	Entity* grandchild = world.CreateEntity(Vec3(0, 3, 0));
+	world.Update();
+
+	TransformHierarchy& hierarchy = *world.GetHierarchy();
+	ECS_CHECK(hierarchy.SetParent(child->GetId(), root->GetId()));
+	ECS_CHECK(hierarchy.SetParent(grandchild->GetId(), child->GetId()));
+	world.Update();
+
+	// scale, then rotate, then translate, applied from the root down
+	const Vec3 childWorld = Vec3(10, 0, 0) + turn * Vec3(2, 0, 0);
+	const Vec3 grandchildWorld = childWorld + turn * Vec3(0, 6, 0);
+	ECS_CHECK(Near(hierarchy.GetWorldPosition(root->GetId()), Vec3(10, 0, 0)));
+	ECS_CHECK(Near(hierarchy.GetWorldPosition(child->GetId()), childWorld));
+	ECS_CHECK(Near(hierarchy.GetWorldPosition(grandchild->GetId()), grandchildWorld));
+
+	// only the root moves, both descendants follow
+	root->transform->position = Vec3(-5, 1, 0);
+	root->markChanged<Transform>();
+	world.Update();
+	ECS_CHECK(Near(hierarchy.GetWorldPosition(child->GetId()), childWorld + Vec3(-15, 1, 0)));
+	ECS_CHECK(Near(hierarchy.GetWorldPosition(grandchild->GetId()), grandchildWorld + Vec3(-15, 1, 0)));
+	ECS_CHECK(child->transform->position == Vec3(1, 0, 0));
+}
+
+ECS_TEST(TransformHierarchy, WritesAreSeenThroughChangeTicks)
+{
+	EntityManager world(0);
+	Entity* parent = world.CreateEntity(Vec3(5, 0, 0));
+	Entity* child = world.CreateEntity(Vec3(1, 0, 0));
+	world.Update();
+
+	TransformHierarchy& hierarchy = *world.GetHierarchy();
+	hierarchy.SetParent(child->GetId(), parent->GetId());
+	world.Update();
+	ECS_CHECK(Near(hierarchy.GetWorldPosition(child->GetId()), Vec3(6, 0, 0)));
+
+	// a write nothing was told about stays unseen, frame after frame
+	child->transform->position = Vec3(2, 0, 0);
+	world.Update();
+	world.Update();
+	ECS_CHECK(Near(hierarchy.GetWorldPosition(child->GetId()), Vec3(6, 0, 0)));
+
+	child->markChanged<Transform>();
+	world.Update();
+	ECS_CHECK(Near(hierarchy.GetWorldPosition(child->GetId()), Vec3(7, 0, 0)));
+
+	// a write through a view is stamped by the view, one between Updates is not missed either
+	world.view<Transform>().each([&](Entity& e, Transform& t) {
+		if (e.GetId() == parent->GetId()) t.position = Vec3(0, 3, 0);
+	});
+	world.Update();
+	ECS_CHECK(Near(hierarchy.GetWorldPosition(child->GetId()), Vec3(2, 3, 0)));
+
+	// an unrelated entity destroyed and its slot reused leaves the nodes alone
+	Entity* other = world.CreateEntity(Vec3(9, 9, 9));
+	world.Update();
+	world.DestroyEntity(other->GetId());
+	world.Update();
+	Entity* reused = world.CreateEntity(Vec3(-9, 0, 0));
+	world.Update();
+	ECS_CHECK(!hierarchy.Contains(reused->GetId()));
+	ECS_CHECK(hierarchy.GetWorldMatrix(reused->GetId()) == nullptr);
+	ECS_CHECK_EQ(hierarchy.Size(), 2u);
+	ECS_CHECK(Near(hierarchy.GetWorldPosition(child->GetId()), Vec3(2, 3, 0)));
+}
+
+ECS_TEST(TransformHierarchy, RejectsCycles)
+{
+	EntityManager world(0);
+	Entity* a = world.CreateEntity();
+	Entity* b = world.CreateEntity();
+	Entity* c = world.CreateEntity();
+
+	TransformHierarchy& hierarchy = *world.GetHierarchy();
+	ECS_CHECK(hierarchy.SetParent(b->GetId(), a->GetId()));
+	ECS_CHECK(hierarchy.SetParent(c->GetId(), b->GetId()));
+	ECS_CHECK(!hierarchy.SetParent(a->GetId(), c->GetId()));
+	ECS_CHECK(!hierarchy.SetParent(a->GetId(), a->GetId()));
+	ECS_CHECK(hierarchy.GetParent(a->GetId()).IsNull());
+	ECS_CHECK(hierarchy.GetParent(c->GetId()) == b->GetId());
+}
+
+ECS_TEST(TransformHierarchy, UnlinkingDetachesAndPrunes)
+{
+	EntityManager world(0);
+	Entity* parent = world.CreateEntity(Vec3(5, 0, 0));
+	Entity* child = world.CreateEntity(Vec3(1, 0, 0));
+	world.Update();
+
+	TransformHierarchy& hierarchy = *world.GetHierarchy();
+	hierarchy.SetParent(child->GetId(), parent->GetId());
+	world.Update();
+	ECS_CHECK_EQ(hierarchy.Size(), 2u);
+
+	// a detached pair has nothing left linking it, neither is tracked any more
+	hierarchy.SetParent(child->GetId(), EntityId::null);
+	world.Update();
+	ECS_CHECK(!hierarchy.Contains(child->GetId()));
+	ECS_CHECK(!hierarchy.Contains(parent->GetId()));
+	ECS_CHECK(hierarchy.GetWorldMatrix(child->GetId()) == nullptr);
+	ECS_CHECK(hierarchy.GetChildren(parent->GetId()).empty());
+	ECS_CHECK_EQ(hierarchy.Size(), 0u);
+}
+
+ECS_TEST(TransformHierarchy, DestroyedParentsLeaveRoots)
+{
+	EntityManager world(0);
+	Entity* parent = world.CreateEntity(Vec3(5, 0, 0));
+	Entity* child = world.CreateEntity(Vec3(1, 0, 0));
+	Entity* grandchild = world.CreateEntity(Vec3(1, 0, 0));
+	world.Update();
+
+	TransformHierarchy& hierarchy = *world.GetHierarchy();
+	hierarchy.SetParent(child->GetId(), parent->GetId());
+	hierarchy.SetParent(grandchild->GetId(), child->GetId());
+	world.Update();
+
+	const EntityId childId = child->GetId();
+	const EntityId grandchildId = grandchild->GetId();
+	world.DestroyEntity(parent->GetId());
+	world.Update();
+
+	// the child is a root now and its subtree is relative to it alone
+	ECS_CHECK(hierarchy.GetParent(childId).IsNull());
+	ECS_CHECK(hierarchy.GetParent(grandchildId) == childId);
+	ECS_CHECK(Near(hierarchy.GetWorldPosition(grandchildId), Vec3(2, 0, 0)));
+}
+
+ECS_TEST(TransformHierarchy, RemovedTransformDropsOut)
+{
+	EntityManager world(0);
+	Entity* parent = world.CreateEntity();
+	Entity* child = world.CreateEntity(Vec3(1, 0, 0));
+	child->add<TestTable>(1);
+	world.Update();
+
+	TransformHierarchy& hierarchy = *world.GetHierarchy();
+	hierarchy.SetParent(child->GetId(), parent->GetId());
+	world.Update();
+
+	child->remove<Transform>();
+	world.Update();
+	ECS_CHECK(!hierarchy.Contains(child->GetId()));
+	ECS_CHECK_EQ(hierarchy.Size(), 0u);
+}
+
+ECS_TEST(TransformHierarchy, PublishedInWorldSpace)
+{
+	EntityManager world(0);
+	TransformBuffer& buffer = world.CreateTransformBuffer();
+	const Quat turn = Quat::FromAngleAxis(90, Vec3::up);
+	Entity* parent = world.CreateEntity(Vec3(10, 0, 0), turn, Vec3(2, 2, 2));
+	Entity* child = world.CreateEntity(Vec3(1, 0, 0), Quat::identity, Vec3(1, 3, 1));
+	world.Update();
+	world.GetHierarchy()->SetParent(child->GetId(), parent->GetId());
+	world.Update();
+
+	const TransformFrame& frame = buffer.Acquire();
+	bool found = false;
+	for (std::size_t i = 0; i < frame.Size(); i++) {
+		if (frame.ids[i] != child->GetId()) continue;
+		found = true;
+		ECS_CHECK(Near(frame.positions[i], world.GetHierarchy()->GetWorldPosition(child->GetId())));
+		ECS_CHECK(std::fabs(std::fabs(Quat::DotProd(frame.rotations[i], turn)) - 1) < 1e-9);
+		ECS_CHECK(Near(frame.scales[i], Vec3(2, 6, 2)));
+	}
+	ECS_CHECK(found);
+}
@@ -0,0 +1,16 @@
+#include <string>
+
+#include "Logger.h"
+#include "Test.h"
+
+// ECS_Tests [suite]
+// Runs every test, or only those of one suite, and exits non zero if any failed. CTest runs one
+// suite per test so failures are reported by area.
+int main(int argc, char** argv)
+{
+	// the test components don't log, but the library's own messages would bury the results
+	Logger::Get().Discard();
+
+	const int failed = TestRegistry::Get().Run(argc > 1 ? argv[1] : "");
+	return failed == 0 ? 0 : 1;
+}